@@ -0,0 +1,233 @@
+// --------------------------------------------------------------------------------------
+// attacks.cpp
+// --- Builds the attack tables declared in attacks.h.
+// --- Magic numbers are found at startup with a seeded sparse random search, which
+// --- takes a few milliseconds. When the CPU supports BMI2 the magic search is skipped
+// --- and the slider tables are laid out for PEXT indexing instead.
+// --------------------------------------------------------------------------------------
+
+#include "attacks.h"
+
+#if !defined(__BMI2__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+// --- Table storage ---
+Bitboard Attacks::ROOK_TABLE[0x19000];
+Bitboard Attacks::BISHOP_TABLE[0x1480];
+Bitboard Attacks::PAWN_ATTACKS[2][64];
+Bitboard Attacks::KNIGHT_ATTACKS[64];
+Bitboard Attacks::KING_ATTACKS[64];
+Magic Attacks::ROOK_MAGICS[64];
+Magic Attacks::BISHOP_MAGICS[64];
+bool Attacks::use_pext = false;
+
+// --- Set once initialize() has run ---
+static bool tables_ready = false;
+
+// --- Small xorshift generator used for the magic search (fixed seeds keep startup deterministic) ---
+struct MagicRandom
+{
+    uint64_t s;
+
+    explicit MagicRandom(uint64_t seed) : s(seed) {}
+
+    uint64_t next()
+    {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 2685821657736338717ULL;
+    }
+
+    // --- Numbers with few set bits make good magic candidates ---
+    uint64_t sparse() { return next() & next() & next(); }
+};
+
+// --- Returns the square at (rank, file) offset from sq, or NO_SQUARE if off the board ---
+static int offset_square(int sq, int d_rank, int d_file)
+{
+    int r = rank_of(sq) + d_rank;
+    int f = col_of(sq) + d_file;
+    if (r < 0 || r > 7 || f < 0 || f > 7)
+    {
+        return NO_SQUARE;
+    }
+    return r * 8 + f;
+}
+
+// --- Slow ray walk, only used while building the tables ---
+static Bitboard sliding_attack(piece_type pt, int sq, Bitboard occupied)
+{
+    const int bishop_steps[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+    const int rook_steps[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    const int (*steps)[2] = (pt == BISHOP) ? bishop_steps : rook_steps;
+
+    Bitboard attacks = 0;
+    for (int d = 0; d < 4; d++)
+    {
+        int s = sq;
+        while ((s = offset_square(s, steps[d][0], steps[d][1])) != NO_SQUARE)
+        {
+            attacks |= square_bb(s);
+            if (occupied & square_bb(s))
+            {
+                break;
+            }
+        }
+    }
+    return attacks;
+}
+
+// --- PEXT index, compiled for BMI2 even when the rest of the build is not ---
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("bmi2")))
+#endif
+unsigned Attacks::pext_index(Bitboard occupied, Bitboard mask)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (unsigned)_pext_u64(occupied, mask);
+#else
+    // --- Portable fallback; never selected on non-x86 targets ---
+    unsigned result = 0;
+    for (unsigned bit = 1; mask; bit <<= 1)
+    {
+        if (occupied & mask & (0 - mask))
+            result |= bit;
+        mask &= mask - 1;
+    }
+    return result;
+#endif
+}
+
+// --- Fills masks, magics and attack slices for one slider type ---
+void Attacks::init_sliders(piece_type pt, Bitboard table[], Magic magics[])
+{
+    // --- Seeds per rank that find all magics quickly ---
+    const uint64_t seeds[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+    static Bitboard occupancy[4096];
+    static Bitboard reference[4096];
+    static int epoch[4096];
+    int attempt = 0;
+    int size = 0;
+
+    for (int i = 0; i < 4096; i++)
+    {
+        epoch[i] = 0;
+    }
+
+    for (int sq = 0; sq < 64; sq++)
+    {
+        Magic &m = magics[sq];
+
+        // --- Edge squares never block anything beyond them, so they are left out of the mask ---
+        Bitboard rank_edges = (RANK_1_BB | RANK_8_BB) & ~(RANK_1_BB << (8 * rank_of(sq)));
+        Bitboard file_edges = (FILE_A_BB | FILE_H_BB) & ~(FILE_A_BB << col_of(sq));
+
+        m.mask = sliding_attack(pt, sq, 0) & ~(rank_edges | file_edges);
+        m.shift = 64 - popcount(m.mask);
+        m.magic = 0;
+        m.attacks = (sq == 0) ? table : magics[sq - 1].attacks + size;
+
+        // --- Enumerate every subset of the mask (Carry-Rippler trick) ---
+        Bitboard b = 0;
+        size = 0;
+        do
+        {
+            occupancy[size] = b;
+            reference[size] = sliding_attack(pt, sq, b);
+            if (use_pext)
+            {
+                m.attacks[pext_index(b, m.mask)] = reference[size];
+            }
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+        if (use_pext)
+        {
+            continue;
+        }
+
+        // --- Search for a magic that maps every subset without destructive collisions ---
+        MagicRandom rng(seeds[rank_of(sq)]);
+        for (int i = 0; i < size;)
+        {
+            for (m.magic = 0; popcount((m.magic * m.mask) >> 56) < 6;)
+            {
+                m.magic = rng.sparse();
+            }
+
+            attempt++;
+            for (i = 0; i < size; i++)
+            {
+                unsigned idx = (unsigned)(((occupancy[i] & m.mask) * m.magic) >> m.shift);
+
+                if (epoch[idx] < attempt)
+                {
+                    epoch[idx] = attempt;
+                    m.attacks[idx] = reference[i];
+                }
+                else if (m.attacks[idx] != reference[i])
+                {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// --- Builds all attack tables ---
+void Attacks::initialize()
+{
+    if (tables_ready)
+    {
+        return;
+    }
+
+#if defined(__BMI2__)
+    use_pext = true;
+#elif defined(__x86_64__) || defined(__i386__)
+    use_pext = __builtin_cpu_supports("bmi2");
+#endif
+
+    const int knight_steps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+    const int king_steps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+
+    for (int sq = 0; sq < 64; sq++)
+    {
+        KNIGHT_ATTACKS[sq] = 0;
+        KING_ATTACKS[sq] = 0;
+        PAWN_ATTACKS[WHITE][sq] = 0;
+        PAWN_ATTACKS[BLACK][sq] = 0;
+
+        for (int k = 0; k < 8; k++)
+        {
+            int to = offset_square(sq, knight_steps[k][0], knight_steps[k][1]);
+            if (to != NO_SQUARE)
+                KNIGHT_ATTACKS[sq] |= square_bb(to);
+
+            to = offset_square(sq, king_steps[k][0], king_steps[k][1]);
+            if (to != NO_SQUARE)
+                KING_ATTACKS[sq] |= square_bb(to);
+        }
+
+        // --- White pawns capture towards rank 8, black pawns towards rank 1 ---
+        for (int d_file = -1; d_file <= 1; d_file += 2)
+        {
+            int to = offset_square(sq, 1, d_file);
+            if (to != NO_SQUARE)
+                PAWN_ATTACKS[WHITE][sq] |= square_bb(to);
+
+            to = offset_square(sq, -1, d_file);
+            if (to != NO_SQUARE)
+                PAWN_ATTACKS[BLACK][sq] |= square_bb(to);
+        }
+    }
+
+    init_sliders(BISHOP, BISHOP_TABLE, BISHOP_MAGICS);
+    init_sliders(ROOK, ROOK_TABLE, ROOK_MAGICS);
+
+    tables_ready = true;
+}
@@ -0,0 +1,88 @@
+// --------------------------------------------------------------------------------------
+// attacks.h
+// --- Declares the precomputed attack tables used for bitboard attack detection.
+// --- Knights, kings and pawns use plain per-square tables. Bishops and rooks use
+// --- "fancy" magic bitboards: the relevant blockers are hashed into an index into a
+// --- shared attack table. On CPUs with BMI2 the index is computed with PEXT instead.
+// --- Tables are built once by Attacks::initialize(), which Engine::Engine() calls.
+// --------------------------------------------------------------------------------------
+
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include "position.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// --- Magic entry for one square of one slider type ---
+struct Magic
+{
+    Bitboard mask;      // --- Relevant blocker squares (board edges excluded) ---
+    Bitboard magic;     // --- Multiplier used by the magic index ---
+    Bitboard *attacks;  // --- This square's slice of the shared attack table ---
+    unsigned shift;     // --- 64 - popcount(mask) ---
+};
+
+class Attacks
+{
+private:
+    // --- Shared attack tables all magic entries point into ---
+    static Bitboard ROOK_TABLE[0x19000];
+    static Bitboard BISHOP_TABLE[0x1480];
+
+    // --- Fills the masks, magics and attack slices for one slider type ---
+    static void init_sliders(piece_type pt, Bitboard table[], Magic magics[]);
+
+public:
+    // --- Leaper tables ---
+    static Bitboard PAWN_ATTACKS[2][64];
+    static Bitboard KNIGHT_ATTACKS[64];
+    static Bitboard KING_ATTACKS[64];
+
+    // --- Slider magics ---
+    static Magic ROOK_MAGICS[64];
+    static Magic BISHOP_MAGICS[64];
+
+    // --- True when the tables were filled using PEXT indexing (runtime BMI2 detection) ---
+    static bool use_pext;
+
+    // --- Builds all tables; safe to call more than once ---
+    static void initialize();
+
+    // --- PEXT index for builds without -mbmi2 (compiled for BMI2, chosen at runtime) ---
+    static unsigned pext_index(Bitboard occupied, Bitboard mask);
+
+    // --- Index of an occupancy in a magic entry's attack slice ---
+    static inline unsigned index(const Magic &m, Bitboard occupied)
+    {
+#if defined(__BMI2__)
+        return (unsigned)_pext_u64(occupied, m.mask);
+#else
+        if (use_pext)
+        {
+            return pext_index(occupied, m.mask);
+        }
+        return (unsigned)(((occupied & m.mask) * m.magic) >> m.shift);
+#endif
+    }
+
+    // --- Attack lookups ---
+    static inline Bitboard bishop(int sq, Bitboard occupied)
+    {
+        const Magic &m = BISHOP_MAGICS[sq];
+        return m.attacks[index(m, occupied)];
+    }
+    static inline Bitboard rook(int sq, Bitboard occupied)
+    {
+        const Magic &m = ROOK_MAGICS[sq];
+        return m.attacks[index(m, occupied)];
+    }
+    static inline Bitboard queen(int sq, Bitboard occupied) { return bishop(sq, occupied) | rook(sq, occupied); }
+    static inline Bitboard knight(int sq) { return KNIGHT_ATTACKS[sq]; }
+    static inline Bitboard king(int sq) { return KING_ATTACKS[sq]; }
+    static inline Bitboard pawn(side s, int sq) { return PAWN_ATTACKS[s][sq]; }
+};
+
+#endif
@@ -8,6 +8,7 @@
 // --------------------------------------------------------------------------------------
 
 #include "board.h"
+#include "position.h"
 #include <string>
 #include <iostream>
 
@@ -54,7 +55,7 @@ bool Board::square_occupied(int i, int j)
 
 // --- Returns true if the square at (i, j) is occupied by a piece belonging to the opponent of side s. ---
 // --- Positive values represent White pieces, and negative values represent Black pieces. ---
-bool Board::square_occupied_by_opponent(char board[8][8], int i, int j, side s)
+bool Board::square_occupied_by_opponent(const char board[8][8], int i, int j, side s)
 {
     if (s == WHITE)
     {
@@ -73,456 +74,182 @@ bool Board::square_occupied_by_opponent(char board[8][8], int i, int j, side s)
     return false;
 }
 
-// --- Handles movement logic for a White piece from a start square to a target square.
-// --- Validates move legality based on piece type and board state
-// --- Updates board state only if the move is legal and does not leave the king in check.
-// --- Returns standard algebraic move notation string if successful; empty string otherwise.
-std::string Board::handle_white_move(int start_i, int start_j, int target_i, int target_j)
+// --- Checks a move of side S and, if it is legal, plays it into result: pieces, castling
+// --- rights and en passant flags. Promotion is left to the caller (the pawn stays a pawn).
+// --- One body serves both colours; directions, rows and piece codes are constants of S.
+// --- S's own en passant flags are cleared and set again for a double push; the other
+// --- side's flags are left as they were ---
+template <side S>
+bool Board::play_if_legal(const board_state &position, int start_i, int start_j, int target_i, int target_j, board_state &result)
 {
-    // --- Create a copy of the current position to simulate the move before confirming legality ---
-    std::string move_string = "";
-    board_state possible_position;
-    copy_board(position.board, possible_position.board);
-
-    // --- Copy castling and en passant flags ---
-    possible_position.can_castle_black[0] = position.can_castle_black[0];
-    possible_position.can_castle_black[1] = position.can_castle_black[1];
-    possible_position.can_castle_white[0] = position.can_castle_white[0];
-    possible_position.can_castle_white[1] = position.can_castle_white[1];
-
-    for (int n = 0; n < 8; n++)
-    {
-        possible_position.pawn_two_squares_black[n] = position.pawn_two_squares_black[n];
-        possible_position.pawn_two_squares_white[n] = position.pawn_two_squares_white[n];
-    }
-
-    bool move_is_legal = false;
-    promote_pawn = false;
-    en_passant_index = -1;
-
-    // --- If target square contains a white piece, the move is illegal ---
-    if (position.board[target_i][target_j] > 0)
-    {
-        return "";
-    }
-
-    // --- Validate the move depending on the type of piece being moved ---
-    switch (position.board[start_i][start_j])
-    {
-    case WHITE_PAWN:
-        if (pawn_move(start_i, start_j, target_i, target_j))
-        {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
+    const side them = opposite(S);
+    const int forward = S == WHITE ? -1 : 1;                                            // --- Row step of a pawn ---
+    const int pawn_row = S == WHITE ? WHITE_PAWN_STARTING_ROWN : BLACK_PAWN_STARTING_ROWN; // --- Double pushes start here ---
+    const int passant_row = S == WHITE ? 3 : 4;                                         // --- Row of a pawn taking en passant ---
+    const int home_row = S == WHITE ? 7 : 0;                                            // --- King and rooks start here ---
 
-            // --- Handle en passant capture ---
-            if (start_i == 3 && target_i == 2 &&
-                abs(target_j - start_j) == 1 &&
-                position.board[start_i][target_j] == BLACK_PAWN &&
-                position.pawn_two_squares_black[target_j])
-            {
-                possible_position.board[start_i][target_j] = 0;
-            }
-            move_is_legal = true;
-        }
-        break;
-    case WHITE_KNIGHT:
-        if (under_knight_control(start_i, start_j, target_i, target_j))
-        {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
-            move_is_legal = true;
-        }
-        break;
-    case WHITE_BISHOP:
-        if (under_bishop_control(position.board, start_i, start_j, target_i, target_j))
-        {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
-            move_is_legal = true;
-        }
-        break;
-    case WHITE_ROOK:
-        if (under_rook_control(position.board, start_i, start_j, target_i, target_j))
-        {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
-
-            // --- Update castling rights if rook moves from its original square ---
-            if (start_i == 7 && start_j == 0)
-            {
-                possible_position.can_castle_white[0] = false;
-            }
-            if (start_i == 7 && start_j == 7)
-            {
-                possible_position.can_castle_white[1] = false;
-            }
-
-            move_is_legal = true;
-        }
-        break;
-    case WHITE_QUEEN:
-        if (under_queen_control(position.board, start_i, start_j, target_i, target_j))
-        {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
-            move_is_legal = true;
-        }
-        break;
-    case WHITE_KING:
-        if (under_king_control(start_i, start_j, target_i, target_j))
-        {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
-
-            // --- King moved, so castling becomes invalid ---
-            possible_position.can_castle_white[0] = false;
-            possible_position.can_castle_white[1] = false;
-            move_is_legal = true;
-        }
-
-        // --- Castling kingside ---
-        if (start_i == 7 && start_j == 4 && target_i == 7 && target_j == 6 &&
-            position.board[7][5] == 0 && position.board[7][6] == 0 &&
-            !under_control(position.board, 7, 4, BLACK) &&
-            !under_control(position.board, 7, 5, BLACK) &&
-            !under_control(position.board, 7, 6, BLACK) &&
-            position.can_castle_white[1])
-        {
-            possible_position.board[target_i][target_j] = possible_position.board[start_i][start_j];
-            possible_position.board[start_i][start_j] = 0;
-            possible_position.board[7][7] = 0;
-            possible_position.board[7][5] = WHITE_ROOK;
-            possible_position.can_castle_white[0] = false;
-            possible_position.can_castle_white[1] = false;
-            move_is_legal = true;
-        }
-
-        // --- Castling queenside ---
-        if (start_i == 7 && start_j == 4 && target_i == 7 && target_j == 2 &&
-            position.board[7][1] == 0 && position.board[7][2] == 0 && position.board[7][3] == 0 &&
-            !under_control(position.board, 7, 2, BLACK) &&
-            !under_control(position.board, 7, 3, BLACK) &&
-            !under_control(position.board, 7, 4, BLACK) &&
-            position.can_castle_white[0])
-        {
-            possible_position.board[target_i][target_j] = possible_position.board[start_i][start_j];
-            possible_position.board[start_i][start_j] = 0;
-            possible_position.board[7][0] = 0;
-            possible_position.board[7][3] = WHITE_ROOK;
-            possible_position.can_castle_white[0] = false;
-            possible_position.can_castle_white[1] = false;
-            move_is_legal = true;
-        }
-        break;
-    default:
-        break;
-    }
+    char piece = position.board[start_i][start_j];
+    char target = position.board[target_i][target_j];
 
-    // --- Final legality check: king must not be in check after move ---
-    if (move_is_legal && !king_is_in_check(possible_position.board, WHITE))
+    // --- Only pieces of S move, and never onto another piece of S ---
+    if (piece == EMPTY || side_of(piece) != S || (target != EMPTY && side_of(target) == S))
     {
-        move_string = generate_move_notation(start_i, start_j, target_i, target_j, WHITE);
-        copy_board(possible_position.board, position.board);
-
-        // --- Copy updated castling and en passant info to main board ---
-        position.can_castle_white[0] = possible_position.can_castle_white[0];
-        position.can_castle_white[1] = possible_position.can_castle_white[1];
-        position.can_castle_black[0] = possible_position.can_castle_black[0];
-        position.can_castle_black[1] = possible_position.can_castle_black[1];
-
-        for (int i = 0; i < 8; i++)
-        {
-            position.pawn_two_squares_white[i] = false;
-            position.pawn_two_squares_black[i] = possible_position.pawn_two_squares_black[i];
-        }
-
-        if (en_passant_index != -1)
-        {
-            position.pawn_two_squares_white[en_passant_index] = true;
-        }
-
-        // --- Handle pawn promotion ---
-        if (promote_pawn)
-        {
-            char user_input = gui_promotion_callback(); // Get piece type from GUI
-
-            switch (user_input)
-            {
-            case 'k':
-                position.board[target_i][target_j] = WHITE_KNIGHT;
-                break;
-            case 'b':
-                position.board[target_i][target_j] = WHITE_BISHOP;
-                break;
-            case 'r':
-                position.board[target_i][target_j] = WHITE_ROOK;
-                break;
-            case 'q':
-            default:
-                position.board[target_i][target_j] = WHITE_QUEEN;
-                break;
-            }
-        }
-
-        return move_string;
+        return false;
     }
 
-    // --- Move is illegal or would place king in check ---
-    return "";
-}
-
-// --- Validates black move legality based on piece type and board state
-bool Board::is_black_move_legal(board_state &position, int start_i, int start_j, int target_i, int target_j, board_state &possible_position)
-{
-    // --- Copy current board state to possible_position for simulation ---
-    copy_board(position.board, possible_position.board);
-    possible_position.can_castle_black[0] = position.can_castle_black[0];
-    possible_position.can_castle_black[1] = position.can_castle_black[1];
-    possible_position.can_castle_white[0] = position.can_castle_white[0];
-    possible_position.can_castle_white[1] = position.can_castle_white[1];
-
+    result = position;
+    bool *own_passant = S == WHITE ? result.pawn_two_squares_white : result.pawn_two_squares_black;
+    const bool *their_passant = S == WHITE ? position.pawn_two_squares_black : position.pawn_two_squares_white;
+    bool *own_castle = S == WHITE ? result.can_castle_white : result.can_castle_black;
+    const bool *can_castle = S == WHITE ? position.can_castle_white : position.can_castle_black;
     for (int n = 0; n < 8; n++)
     {
-        possible_position.pawn_two_squares_black[n] = position.pawn_two_squares_black[n];
-        possible_position.pawn_two_squares_white[n] = position.pawn_two_squares_white[n];
+        own_passant[n] = false;
     }
 
-    // --- Initialize legality flag and en passant index tracker ---
     bool move_is_legal = false;
-    int en_passant_index = -1;
-
-    // --- Check move legality based on piece type ---
-    switch (position.board[start_i][start_j])
+    switch (type_of(piece))
     {
-    case BLACK_PAWN:
-    {
-        // --- One square forward ---
-        if (target_i == start_i + 1 && target_j == start_j)
-        {
-            // --- Check if square is empty ---
-            if (position.board[target_i][target_j] == 0)
-            {
-                move_piece(possible_position, start_i, start_j, target_i, target_j);
-                move_is_legal = true;
-            }
-        }
-        // --- Two squares forward from starting position ---
-        else if (start_i == 1 && target_i == start_i + 2 && start_j == target_j)
+    case PAWN:
+        // --- One square forward onto an empty square ---
+        if (target_i == start_i + forward && target_j == start_j && target == EMPTY)
         {
-            if (position.board[target_i - 1][target_j] == 0 && position.board[target_i][target_j] == 0)
-            {
-                // --- Reset en passant flags ---
-                for (int i = 0; i < 8; i++)
-                    possible_position.pawn_two_squares_black[i] = false;
-
-                // --- Mark en passant eligible column ---
-                en_passant_index = target_j;
-                move_piece(possible_position, start_i, start_j, target_i, target_j);
-                possible_position.pawn_two_squares_black[target_j] = true;
-                move_is_legal = true;
-            }
+            move_is_legal = true;
         }
-        // --- En passant capture ---
-        else if (start_i == 4 && target_i == 5 && (target_j == (start_j - 1) || target_j == (start_j + 1)) &&
-                 position.pawn_two_squares_white[target_j])
+        // --- Two squares forward from the starting row, both squares empty ---
+        else if (start_i == pawn_row && target_i == start_i + 2 * forward && target_j == start_j &&
+                 position.board[start_i + forward][start_j] == EMPTY && target == EMPTY)
         {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
-            possible_position.board[4][target_j] = 0; // --- Remove captured pawn ---
+            own_passant[target_j] = true;
             move_is_legal = true;
         }
         // --- Diagonal capture ---
-        else if ((target_i == start_i + 1) && (target_j == start_j - 1 || target_j == start_j + 1) && position.board[target_i][target_j] > 0)
+        else if (target_i == start_i + forward && abs(target_j - start_j) == 1 && target != EMPTY)
         {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
             move_is_legal = true;
         }
-
-        break;
-    }
-
-    case BLACK_KNIGHT:
-        // --- Knight's L-shaped move ---
-        if (under_knight_control(start_i, start_j, target_i, target_j))
+        // --- En passant: the pawn beside it has just moved two squares ---
+        else if (start_i == passant_row && target_i == start_i + forward && abs(target_j - start_j) == 1 &&
+                 target == EMPTY && their_passant[target_j] && position.board[start_i][target_j] == make_piece(them, PAWN))
         {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
+            result.board[start_i][target_j] = EMPTY;
             move_is_legal = true;
         }
         break;
-
-    case BLACK_BISHOP:
-        // --- Bishop diagonal movement ---
-        if (under_bishop_control(position.board, start_i, start_j, target_i, target_j))
-        {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
-            move_is_legal = true;
-        }
+    case KNIGHT:
+        move_is_legal = under_knight_control(start_i, start_j, target_i, target_j);
         break;
-
-    case BLACK_ROOK:
-        // --- Rook horizontal/vertical movement ---
-        if (under_rook_control(position.board, start_i, start_j, target_i, target_j))
-        {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
-
-            // --- Disable castling rights if rook moves from original square ---
-            if (start_i == 0 && start_j == 0)
-            {
-                possible_position.can_castle_black[0] = false;
-            }
-            if (start_i == 0 && start_j == 7)
-            {
-                possible_position.can_castle_black[1] = false;
-            }
-            move_is_legal = true;
-        }
+    case BISHOP:
+        move_is_legal = under_bishop_control(position.board, start_i, start_j, target_i, target_j);
         break;
-
-    case BLACK_QUEEN:
-        // --- Queen diagonal + straight movement ---
-        if (under_queen_control(position.board, start_i, start_j, target_i, target_j))
-        {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
-            move_is_legal = true;
-        }
+    case ROOK:
+        move_is_legal = under_rook_control(position.board, start_i, start_j, target_i, target_j);
+
+        // --- A rook leaving its original square loses its castling right ---
+        if (start_i == home_row && start_j == 0)
+            own_castle[0] = false;
+        if (start_i == home_row && start_j == 7)
+            own_castle[1] = false;
         break;
-
-    case BLACK_KING:
-        // --- King standard 1-square movement ---
-        if (under_king_control(start_i, start_j, target_i, target_j))
-        {
-            move_piece(possible_position, start_i, start_j, target_i, target_j);
-            possible_position.can_castle_black[0] = false;
-            possible_position.can_castle_black[1] = false;
-            move_is_legal = true;
-        }
+    case QUEEN:
+        move_is_legal = under_queen_control(position.board, start_i, start_j, target_i, target_j);
+        break;
+    case KING:
+        move_is_legal = under_king_control(start_i, start_j, target_i, target_j);
 
         // --- Castling kingside ---
-        if (start_i == 0 && start_j == 4 && target_i == 0 && target_j == 6 &&
-            position.board[0][5] == 0 && position.board[0][6] == 0 &&
-            !under_control(position.board, 0, 4, WHITE) &&
-            !under_control(position.board, 0, 5, WHITE) &&
-            !under_control(position.board, 0, 6, WHITE) &&
-            position.can_castle_black[1])
+        if (start_i == home_row && start_j == 4 && target_i == home_row && target_j == 6 && can_castle[1] &&
+            position.board[home_row][5] == EMPTY && position.board[home_row][6] == EMPTY &&
+            !under_control(position.board, home_row, 4, them) &&
+            !under_control(position.board, home_row, 5, them) &&
+            !under_control(position.board, home_row, 6, them))
         {
-            possible_position.board[target_i][target_j] = possible_position.board[start_i][start_j];
-            possible_position.board[start_i][start_j] = 0;
-            possible_position.board[0][7] = 0;
-            possible_position.board[0][5] = BLACK_ROOK;
-
-            possible_position.can_castle_black[0] = false;
-            possible_position.can_castle_black[1] = false;
+            result.board[home_row][7] = EMPTY;
+            result.board[home_row][5] = make_piece(S, ROOK);
             move_is_legal = true;
         }
 
         // --- Castling queenside ---
-        else if (start_i == 0 && start_j == 4 && target_i == 0 && target_j == 2 &&
-                 position.board[0][1] == 0 && position.board[0][2] == 0 && position.board[0][3] == 0 &&
-                 !under_control(position.board, 0, 2, WHITE) &&
-                 !under_control(position.board, 0, 3, WHITE) &&
-                 !under_control(position.board, 0, 4, WHITE) &&
-                 position.can_castle_black[0])
+        if (start_i == home_row && start_j == 4 && target_i == home_row && target_j == 2 && can_castle[0] &&
+            position.board[home_row][1] == EMPTY && position.board[home_row][2] == EMPTY && position.board[home_row][3] == EMPTY &&
+            !under_control(position.board, home_row, 2, them) &&
+            !under_control(position.board, home_row, 3, them) &&
+            !under_control(position.board, home_row, 4, them))
         {
-            possible_position.board[target_i][target_j] = possible_position.board[start_i][start_j];
-            possible_position.board[start_i][start_j] = 0;
-            possible_position.board[0][0] = 0;
-            possible_position.board[0][3] = BLACK_ROOK;
-
-            possible_position.can_castle_black[0] = false;
-            possible_position.can_castle_black[1] = false;
+            result.board[home_row][0] = EMPTY;
+            result.board[home_row][3] = make_piece(S, ROOK);
             move_is_legal = true;
         }
-        break;
 
+        // --- King moved, so castling becomes invalid ---
+        own_castle[0] = false;
+        own_castle[1] = false;
+        break;
     default:
         break;
     }
 
-    // --- Final legality check: move must not leave king in check ---
-    if (move_is_legal && !king_is_in_check(possible_position.board, BLACK))
+    if (!move_is_legal)
     {
-        // --- Commit move to actual position ---
-        copy_board(possible_position.board, position.board);
-        position.can_castle_white[0] = possible_position.can_castle_white[0];
-        position.can_castle_white[1] = possible_position.can_castle_white[1];
-        position.can_castle_black[0] = possible_position.can_castle_black[0];
-        position.can_castle_black[1] = possible_position.can_castle_black[1];
-
-        for (int i = 0; i < 8; i++)
-        {
-            position.pawn_two_squares_white[i] = possible_position.pawn_two_squares_white[i];
-            position.pawn_two_squares_black[i] = possible_position.pawn_two_squares_black[i];
-        }
-
-        // --- If en passant capture occurred, mark it ---
-        if (en_passant_index != -1)
-        {
-            position.pawn_two_squares_white[en_passant_index] = true;
-        }
-
-        return true;
+        return false;
     }
+    result.board[target_i][target_j] = piece;
+    result.board[start_i][start_j] = EMPTY;
 
-    // --- Move was illegal or left king in check ---
-    return false;
+    // --- Final legality check: king must not be in check after move ---
+    return !king_is_in_check(result.board, S);
 }
 
-// --- Returns true if the selected white pawn can legally move to the target square.
-bool Board::pawn_move(int start_i, int start_j, int target_i, int target_j)
+// --- Handles movement logic for a White piece from a start square to a target square.
+// --- Updates board state only if the move is legal and does not leave the king in check.
+// --- Returns standard algebraic move notation string if successful; empty string otherwise.
+std::string Board::handle_white_move(int start_i, int start_j, int target_i, int target_j)
 {
-    char starting_row = WHITE_PAWN_STARTING_ROWN;
-
-    // --- One square forward move ---
-    if (target_i == start_i - 1 && start_j == target_j)
+    board_state possible_position;
+    if (!play_if_legal<WHITE>(position, start_i, start_j, target_i, target_j, possible_position))
     {
-        // --- Check if the square is empty ---
-        if (!square_occupied(target_i, target_j))
-        {
-            // --- Check for promotion condition ---
-            if (target_i == 0)
-            {
-                promote_pawn = true;
-            }
-            return true;
-        }
+        return "";
     }
 
-    // --- Two squares forward from starting row ---
-    if (start_i == starting_row && start_i - 2 == target_i && start_j == target_j)
+    std::string move_string = generate_move_notation(start_i, start_j, target_i, target_j, WHITE);
+    position = possible_position;
+
+    // --- Handle pawn promotion ---
+    if (position.board[target_i][target_j] == WHITE_PAWN && target_i == 0)
     {
-        // --- Ensure both intermediate and target squares are empty ---
-        if (!square_occupied(target_i + 1, target_j) && !square_occupied(target_i, target_j))
+        char user_input = gui_promotion_callback ? gui_promotion_callback() : 'q'; // Get piece type from GUI
+
+        switch (user_input)
         {
-            // --- Mark en passant index for potential capture next turn ---
-            en_passant_index = target_j;
-            return true;
+        case 'k':
+            position.board[target_i][target_j] = WHITE_KNIGHT;
+            break;
+        case 'b':
+            position.board[target_i][target_j] = WHITE_BISHOP;
+            break;
+        case 'r':
+            position.board[target_i][target_j] = WHITE_ROOK;
+            break;
+        case 'q':
+        default:
+            position.board[target_i][target_j] = WHITE_QUEEN;
+            break;
         }
     }
 
-    // --- En passant capture to the left or right ---
-    if (start_i == 3 && target_i == 2 && (target_j == start_j - 1 || target_j == start_j + 1) &&
-        position.pawn_two_squares_black[target_j])
-    {
-        return true;
-    }
+    return move_string;
+}
 
-    // --- Normal diagonal captures (both left and right) ---
-    int direction = 1;
-    for (int n = 0; n < 2; n++)
+// --- Validates black move legality based on piece type and board state
+// --- On success the move (promotion aside) is played into both position and possible_position
+bool Board::is_black_move_legal(board_state &position, int start_i, int start_j, int target_i, int target_j, board_state &possible_position)
+{
+    if (!play_if_legal<BLACK>(position, start_i, start_j, target_i, target_j, possible_position))
     {
-        if (n == 1)
-        {
-            direction = -1;
-        }
-
-        // --- Check if target square is diagonally in front and contains a black piece ---
-        if (start_i - 1 == target_i && target_j + direction == start_j && square_occupied_by_black(target_i, target_j))
-        {
-            // --- Check for promotion on capture ---
-            if (target_i == 0)
-            {
-                promote_pawn = true;
-            }
-            return true;
-        }
+        return false;
     }
-
-    // --- If no valid move condition matched, return false ---
-    return false;
+    position = possible_position;
+    return true;
 }
 
 // --- Returns true if the pawn at (start_i, start_j) controls the target square (target_i, target_j).
@@ -681,89 +408,24 @@ bool Board::under_king_control(int start_i, int start_j, int target_i, int targe
 }
 
 // --- Returns true if the square (i, j) is under control by any piece of side 's'.
+// --- Looks the attackers up in the precomputed attack tables instead of testing every piece.
 bool Board::under_control(const char board[8][8], int i, int j, side s)
 {
-    // --- Set piece identifiers based on the side ---
-    char pawn = WHITE_PAWN;
-    char knight = WHITE_KNIGHT;
-    char bishop = WHITE_BISHOP;
-    char rook = WHITE_ROOK;
-    char queen = WHITE_QUEEN;
-    char king = WHITE_KING;
-
-    if (s == BLACK)
-    {
-        pawn = BLACK_PAWN;
-        knight = BLACK_KNIGHT;
-        bishop = BLACK_BISHOP;
-        rook = BLACK_ROOK;
-        queen = BLACK_QUEEN;
-        king = BLACK_KING;
-    }
-
-    // --- Check if any piece of the given side controls (i, j) ---
-    for (int m = 0; m < 8; m++)
-    {
-        for (int n = 0; n < 8; n++)
-        {
-            if (board[m][n] == pawn && under_pawn_control(board, m, n, i, j))
-            {
-                return true;
-            }
-            if (board[m][n] == knight && under_knight_control(m, n, i, j))
-            {
-                return true;
-            }
-            if (board[m][n] == bishop && under_bishop_control(board, m, n, i, j))
-            {
-                return true;
-            }
-            if (board[m][n] == rook && under_rook_control(board, m, n, i, j))
-            {
-                return true;
-            }
-            if (board[m][n] == queen && under_queen_control(board, m, n, i, j))
-            {
-                return true;
-            }
-            if (board[m][n] == king && under_king_control(m, n, i, j))
-            {
-                return true;
-            }
-        }
-    }
+    Position pos;
+    pos.clear();
+    pos.load_board(board);
 
-    // --- No piece of side 's' controls the square ---
-    return false;
+    return pos.is_attacked(square_of(i, j), s);
 }
 
 // --- Returns true if side s's king is in check on a given board state ---
 bool Board::king_is_in_check(char board[8][8], side s)
 {
-    char king = WHITE_KING;
-    side opponent = BLACK;
+    Position pos;
+    pos.clear();
+    pos.load_board(board);
 
-    if (s == BLACK)
-    {
-        king = BLACK_KING;
-        opponent = WHITE;
-    }
-
-    // --- Scan the board for the king and check if it is under attack ---
-    for (int m = 0; m < 8; m++)
-    {
-        for (int n = 0; n < 8; n++)
-        {
-            if (board[m][n] == king)
-            {
-                if (under_control(board, m, n, opponent))
-                {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+    return pos.in_check(s);
 }
 
 // --- Overloaded version: Checks check status for side s using current board state ---
@@ -774,7 +436,7 @@ bool Board::king_is_in_check(side s)
 
 // --- Returns true if the side s is in checkmate ---
 // --- A checkmate occurs when the king is in check and no legal moves can prevent it ---
-bool Board::is_checkmate(board_state p, side s)
+bool Board::is_checkmate(const board_state &p, side s)
 {
     char possible_board[8][8];
 
@@ -782,7 +444,7 @@ bool Board::is_checkmate(board_state p, side s)
     int dir = -1;
     int startingRank = 6;
     int enPassantRank = 3;
-    bool *en_passant = p.pawn_two_squares_black;
+    const bool *en_passant = p.pawn_two_squares_black;
 
     char pawn = WHITE_PAWN;
     char knight = WHITE_KNIGHT;
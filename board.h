@@ -55,7 +55,7 @@ struct board_state
     char board[8][8]; // Current board layout
     bool pawn_two_squares_black[8]; // En passant tracker for black
     bool pawn_two_squares_white[8]; // En passant tracker for white
-    bool can_castle_white[2]; // [0]: kingside, [1]: queenside
+    bool can_castle_white[2]; // [0]: queenside (a-rook), [1]: kingside (h-rook)
     bool can_castle_black[2];
 };
 
@@ -79,8 +79,9 @@ private:
         {1, 1},
         {1, 1}};
 
-    int en_passant_index; // For pawn en passant tracking
-    bool promote_pawn; // Promotion flag
+    // --- Shared move check of both colours behind handle_white_move and is_black_move_legal ---
+    template <side S>
+    static bool play_if_legal(const board_state &position, int start_i, int start_j, int target_i, int target_j, board_state &result);
 
 public:
     // --- Optional promotion selector from GUI ---
@@ -90,12 +91,11 @@ public:
     bool square_occupied_by_white(int i, int j);
     bool square_occupied_by_black(int i, int j);
     bool square_occupied(int i, int j);
-    static bool square_occupied_by_opponent(char board[8][8], int i, int j, side s);
+    static bool square_occupied_by_opponent(const char board[8][8], int i, int j, side s);
 
     // --- Player move handlers ---
     std::string handle_white_move(int start_i, int start_j, int target_i, int target_j);
     bool is_black_move_legal(board_state &position, int start_i, int start_j, int target_i, int target_j, board_state &possible_position);
-    bool pawn_move(int start_i, int start_j, int target_i, int target_j); // Special pawn handling
 
     // --- Board control functions (attack detection) ---
     static bool under_pawn_control(const char board[8][8], int start_i, int start_j, int target_i, int target_j);
@@ -109,7 +109,7 @@ public:
     // --- Check / Checkmate / Stalemate detection ---
     static bool king_is_in_check(char board[8][8], side s);
     bool king_is_in_check(side s);
-    static bool is_checkmate(board_state p, side s);
+    static bool is_checkmate(const board_state &p, side s);
     bool is_checkmate(side s);
     static bool is_stalemate(board_state &p, side s);
 
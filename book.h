@@ -0,0 +1,70 @@
+// --------------------------------------------------------------------------------------
+// book.h
+// --- Declares the opening book: a file of Polyglot-format entries, memory-mapped and
+// --- probed by binary search before the engine starts a search.
+// --- Each entry is 16 big-endian bytes: position key (8), move (2), weight (2) and a
+// --- learn field (4), sorted by key. Moves are Polyglot moves: to square in bits 0-5,
+// --- from square in bits 6-11, promotion (1-4 knight to queen) in bits 12-14, castling
+// --- written as the king taking its own rook.
+// --- Positions are keyed with Polyglot's own Random64 hash (see book_key), so books
+// --- from other Polyglot tools and from tools/book_build are read the same way.
+// --------------------------------------------------------------------------------------
+
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "position.h"
+#include "mappedfile.h"
+
+const int BOOK_ENTRY_SIZE = 16;
+
+struct BookEntry
+{
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+    uint32_t learn;
+};
+
+// --- Polyglot key a position is stored under in the book ---
+uint64_t book_key(const Position &pos);
+
+// --- book_key of the start position, as published with the Polyglot format ---
+const uint64_t POLYGLOT_START_KEY = 0x463B96181691FC9CULL;
+
+// --- Move conversion between the engine's encoding and the book's ---
+uint16_t to_book_move(Move m);
+Move from_book_move(Position &pos, uint16_t book_move); // --- NO_MOVE unless it is legal in pos ---
+
+// --- Writes one entry in the file's big-endian layout ---
+void write_book_entry(const BookEntry &entry, unsigned char *bytes);
+
+class OpeningBook
+{
+private:
+    MappedFile file;
+    size_t entry_count;
+
+    BookEntry entry(size_t index) const;
+
+public:
+    OpeningBook();
+
+    // --- Maps a book file; false if it is missing or not a whole number of entries ---
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const { return entry_count > 0; }
+
+    // --- All entries stored for a key, found by binary search ---
+    std::vector<BookEntry> lookup(uint64_t key) const;
+
+    // --- A legal book move for the position, chosen at random in proportion to the
+    // --- entry weights; NO_MOVE if the position is not in the book ---
+    Move probe(Position &pos, std::mt19937 &rng) const;
+};
+
+#endif
@@ -1,2340 +1,1299 @@
 // --------------------------------------------------------------------------------------
 // engine.cpp
 // --- Implements the Engine class which handles AI logic and move generation.
-// --- Uses Minimax with alpha-beta pruning to determine best moves for both sides.
-// --- Evaluates positions using Evaluation class and tracks nodes explored.
+// --- Uses Minimax with alpha-beta pruning to determine best moves for both sides,
+// --- deepened iteratively until the search budget in SearchLimits is spent.
+// --- Moves come from the shared generator in movegen.h, so both colours, the root
+// --- and the inner search nodes all see exactly the same move set. The search plays
+// --- and takes back moves on a single Position instead of copying it per node.
+// --- Evaluates positions using Evaluation class and tracks nodes explored per thread.
+// --- Background searches run the same root search on their own thread and publish
+// --- progress after every iteration. Pondering is such a search on the position after
+// --- the expected reply, with the budget ignored until the reply is actually played.
 // --------------------------------------------------------------------------------------
 
 #include <iostream>
 #include <vector>
+#include <climits>
+#include <cmath>
 #include <stdlib.h>
 #include <time.h>
 #include <algorithm>
 #include "engine.h"
+#include "attacks.h"
+#include "zobrist.h"
 #include <string>
+#include <thread>
 
 using namespace std;
 
-int paths = 0; // --- Global counter for nodes explored in the current search ---
-
-// --- Constructor for the Engine class. Initializes evaluation tables. ---
-Engine::Engine()
+// --- Constructor for the Engine class. Initializes evaluation, attack and hash tables. ---
+Engine::Engine(int hash_mb, int threads, const std::string &network_path)
+    : tt(hash_mb), book_rng((unsigned int)time(NULL)), stopped(false), can_stop(false), stop_requested(false), pondering(false), ponder_key(0),
+      async_running(false)
 {
     Evaluation::initialize_piece_square_tables();
+    Attacks::initialize();
+    Zobrist::initialize();
+    set_threads(threads);
+    if (!network_path.empty())
+    {
+        set_network(network_path);
+    }
 }
 
-// --- Returns and apply the best move for Black using minimax search ---
-EngineMove Engine::make_black_move(board_state &position)
+// --- Makes sure no search or helper thread outlives the engine ---
+Engine::~Engine()
 {
-    Board board;
-    board.get_position() = position;
-    int from_i = -1, from_j = -1, to_i = -1, to_j = -1;
-    int best_score = INT_MAX;
-    board_state possible_position;
-    board_state best_position;
-    string computer_move_notation;
+    cancel_search();
+    stop_helpers();
+}
+
+// --- Search budget used by all following searches ---
+void Engine::set_limits(const SearchLimits &search_limits)
+{
+    limits = search_limits;
+    if (limits.depth < 1 || limits.depth > MAX_SEARCH_DEPTH)
+    {
+        limits.depth = MAX_SEARCH_DEPTH;
+    }
+}
+
+const SearchLimits &Engine::get_limits() const
+{
+    return limits;
+}
 
-    Board::reset_en_passant(position, BLACK);
+// --- Number of search threads (1 disables Lazy SMP) ---
+void Engine::set_threads(int threads)
+{
+    threads = max(1, min(threads, MAX_THREADS));
 
-    for (int m = 0; m < 8; m++)
+    workers.clear();
+    for (int id = 0; id < threads; id++)
     {
-        for (int n = 0; n < 8; n++)
+        workers.push_back(unique_ptr<SearchWorker>(new SearchWorker(id)));
+    }
+}
+
+int Engine::get_threads() const
+{
+    return (int)workers.size();
+}
+
+// --- Transposition table size in megabytes; resizing drops all stored results ---
+void Engine::set_hash(int hash_mb)
+{
+    tt.resize(hash_mb);
+}
+
+int Engine::get_hash() const
+{
+    return tt.size_mb();
+}
+
+// --- Forgets all stored results, e.g. before a new game ---
+void Engine::clear_hash()
+{
+    tt.clear();
+}
+
+// --- Also clears every worker's killer and history tables ---
+void Engine::new_game()
+{
+    tt.clear();
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t]->ordering.clear();
+    }
+}
+
+// --- Maps the book file, replacing any open one ---
+bool Engine::set_book(const std::string &path)
+{
+    if (path.empty())
+    {
+        book.close();
+        return true;
+    }
+    return book.open(path);
+}
+
+bool Engine::has_book() const
+{
+    return book.is_open();
+}
+
+void Engine::set_tablebase_path(const std::string &directory)
+{
+    tablebases.set_path(directory);
+}
+
+bool Engine::has_tablebases() const
+{
+    return tablebases.is_enabled();
+}
+
+bool Engine::set_network(const std::string &path)
+{
+    if (path.empty())
+    {
+        network.close();
+        return true;
+    }
+    return network.open(path);
+}
+
+bool Engine::has_network() const
+{
+    return network.is_open();
+}
+
+// --- Resets the clock, stop flags and node counters at the start of a search ---
+void Engine::start_search()
+{
+    search_start = chrono::steady_clock::now();
+    stopped = false;
+    can_stop = false;
+    tt.new_search();
+
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t]->ordering.new_search();
+        workers[t]->nodes.store(0, memory_order_relaxed);
+        workers[t]->stats = SearchStats();
+    }
+
+    lock_guard<mutex> lock(info_mutex);
+    info = SearchInfo();
+}
+
+// --- Milliseconds since start_search() ---
+int Engine::elapsed_ms() const
+{
+    return (int)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - search_start).count();
+}
+
+// --- Sets stopped when the time or node budget has run out (main thread only) ---
+// --- A forced move is honoured at once, even before the first iteration is complete ---
+void Engine::check_limits()
+{
+    if (stop_requested)
+    {
+        stopped = true;
+        return;
+    }
+    if (!can_stop || pondering)
+    {
+        return;
+    }
+    if (limits.nodes > 0 && searched_nodes() >= limits.nodes)
+    {
+        stopped = true;
+    }
+    if (limits.time_ms > 0 && elapsed_ms() >= limits.time_ms)
+    {
+        stopped = true;
+    }
+}
+
+// --- Publishes the result of a completed iteration to pollers and the callback ---
+// --- The callback runs outside the lock so it may call get_search_info() ---
+void Engine::report_iteration(int depth, int score, const std::string &best_move, const std::vector<Move> &pv)
+{
+    SearchInfo snapshot;
+    SearchCallback on_iteration;
+    {
+        lock_guard<mutex> lock(info_mutex);
+        info.depth = depth;
+        info.eval = (float)score / 100;
+        info.nodes = searched_nodes();
+        info.time_ms = elapsed_ms();
+        info.best_move = best_move;
+        info.pv = pv;
+        snapshot = info;
+        on_iteration = callback;
+    }
+    if (on_iteration)
+    {
+        on_iteration(snapshot);
+    }
+}
+
+// --- Counts a node and checks the budget every 1024 nodes ---
+// --- Only the owning thread writes its counter, so no atomic read-modify-write is needed ---
+inline void Engine::count_node(SearchWorker &worker)
+{
+    long n = worker.nodes.load(memory_order_relaxed) + 1;
+    worker.nodes.store(n, memory_order_relaxed);
+
+    if ((n & 1023) == 0 && worker.id == 0)
+    {
+        check_limits();
+    }
+}
+
+// --- Total nodes searched by all threads in the current search ---
+long Engine::searched_nodes() const
+{
+    long total = 0;
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        total += workers[t]->nodes.load(memory_order_relaxed);
+    }
+    return total;
+}
+
+// --- Adds the counters of another thread ---
+void SearchStats::add(const SearchStats &other)
+{
+    nodes += other.nodes;
+    qnodes += other.qnodes;
+    for (int p = 0; p < STATS_PLIES; p++)
+    {
+        nodes_by_ply[p] += other.nodes_by_ply[p];
+    }
+    fail_highs += other.fail_highs;
+    fail_highs_first += other.fail_highs_first;
+    tt_probes += other.tt_probes;
+    tt_hits += other.tt_hits;
+    tt_cutoffs += other.tt_cutoffs;
+    tb_hits += other.tb_hits;
+    movegen.calls += other.movegen.calls;
+    movegen.timed_calls += other.movegen.timed_calls;
+    movegen.timed_ns += other.movegen.timed_ns;
+    eval.calls += other.eval.calls;
+    eval.timed_calls += other.eval.timed_calls;
+    eval.timed_ns += other.eval.timed_ns;
+}
+
+// --- Sums the statistics of all threads once the helpers have stopped ---
+SearchStats Engine::collect_stats(const std::vector<long> &iteration_nodes) const
+{
+    SearchStats total;
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        total.add(workers[t]->stats);
+    }
+    total.nodes = searched_nodes();
+    total.time_ms = elapsed_ms();
+    total.depth = (int)iteration_nodes.size();
+
+    // --- Each iteration repeats the previous one, so its own cost is the difference ---
+    size_t n = iteration_nodes.size();
+    if (n >= 3)
+    {
+        long last = iteration_nodes[n - 1] - iteration_nodes[n - 2];
+        long previous = iteration_nodes[n - 2] - iteration_nodes[n - 3];
+        total.branching_factor = previous > 0 ? (double)last / previous : 0;
+    }
+    return total;
+}
+
+// --- Times one call in TIMING_SAMPLE for a PhaseClock, for the lifetime of the object ---
+class PhaseTimer
+{
+private:
+    PhaseClock &clock;
+    bool timed;
+    chrono::steady_clock::time_point start;
+
+public:
+    explicit PhaseTimer(PhaseClock &phase_clock) : clock(phase_clock), timed(clock.calls++ % TIMING_SAMPLE == 0)
+    {
+        if (timed)
         {
-            if (position.board[m][n] < 0)
-            {
-                if (position.board[m][n] == BLACK_PAWN)
-                {
-                    // one move forward by pawn
-                    if (position.board[m + 1][n] == 0)
-                    {
-                        // if not moving to last rank
-                        if (m + 1 != 7)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m + 1][n] = BLACK_PAWN;
-                            possible_position.board[m][n] = 0;
-
-                            if (!Board::king_is_in_check(possible_position.board, BLACK))
-                            {
-                                int alpha = INT_MIN, beta = INT_MAX;
-                                int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                if (score < best_score)
-                                {
-                                    best_position = Board::copy_position(possible_position);
-                                    best_score = score;
-                                    from_i = m;
-                                    from_j = n;
-                                    to_i = m + 1;
-                                    to_j = n;
-                                }
-                            }
-                        }
-                        // if moves last rank, then cycle through promotion of all pieces
-                        else
-                        {
-                            // variable i denotes possible pieces from black knight to queen
-                            for (char i = -5; i <= -2; i++)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m + 1][n] = i;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                    if (score < best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = m + 1;
-                                        to_j = n;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    // two moves from starting position by pawn
-                    if (m == 1 && position.board[m + 1][n] == 0 && position.board[m + 2][n] == 0)
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[m + 2][n] = BLACK_PAWN;
-                        possible_position.board[m][n] = 0;
-
-                        possible_position.pawn_two_squares_black[n] = true;
-
-                        if (!Board::king_is_in_check(possible_position.board, BLACK))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                            if (score < best_score)
-                            {
-                                best_position = Board::copy_position(possible_position);
-                                best_score = score;
-                                from_i = m;
-                                from_j = n;
-                                to_i = m + 2;
-                                to_j = n;
-                            }
-                        }
-                    }
-                    // capture to the left
-                    if (n != 0 && position.board[m + 1][n - 1] > 0)
-                    {
-                        if (m + 1 != 7)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m + 1][n - 1] = BLACK_PAWN;
-                            possible_position.board[m][n] = 0;
-                            if (!Board::king_is_in_check(possible_position.board, BLACK))
-                            {
-                                int alpha = INT_MIN, beta = INT_MAX;
-                                int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                if (score < best_score)
-                                {
-                                    best_position = Board::copy_position(possible_position);
-                                    best_score = score;
-                                    from_i = m;
-                                    from_j = n;
-                                    to_i = m + 1;
-                                    to_j = n - 1;
-                                }
-                            }
-                        }
-                        // if moves last rank, then cycle through promotion of all pieces
-                        else
-                        {
-                            // variable i is possible pieces from black knight to queen
-                            for (char i = -5; i <= -2; i++)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m + 1][n - 1] = i;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                    if (score < best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = m + 1;
-                                        to_j = n - 1;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    // capture to the right
-                    if (n != 7 && position.board[m + 1][n + 1] > 0)
-                    {
-                        if (m + 1 != 7)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m + 1][n + 1] = BLACK_PAWN;
-                            possible_position.board[m][n] = 0;
-                            if (!Board::king_is_in_check(possible_position.board, BLACK))
-                            {
-                                int alpha = INT_MIN, beta = INT_MAX;
-                                int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                if (score < best_score)
-                                {
-                                    best_position = Board::copy_position(possible_position);
-                                    best_score = score;
-                                    from_i = m;
-                                    from_j = n;
-                                    to_i = m + 1;
-                                    to_j = n + 1;
-                                }
-                            }
-                        }
-                        // if moves last rank, then cycle through promotion of all pieces
-                        else
-                        {
-                            // variable i is possible pieces from black knight to queen
-                            for (char i = -5; i <= -2; i++)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m + 1][n + 1] = i;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                    if (score < best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = m + 1;
-                                        to_j = n + 1;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    // en passant to the right
-                    if (n != 7 && position.board[m][n + 1] == 1 && position.pawn_two_squares_white[n + 1])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[m + 1][n + 1] = BLACK_PAWN;
-                        possible_position.board[m][n] = 0;
-                        possible_position.board[m][n + 1] = 0;
-                        if (!Board::king_is_in_check(possible_position.board, BLACK))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                            if (score < best_score)
-                            {
-                                best_position = Board::copy_position(possible_position);
-                                best_score = score;
-                                from_i = m;
-                                from_j = n;
-                                to_i = m + 1;
-                                to_j = n + 1;
-                            }
-                        }
-                    }
-                    // en passant to the left
-                    if (n != 0 && position.board[m][n - 1] == 1 && position.pawn_two_squares_white[n - 1])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[m + 1][n - 1] = BLACK_PAWN;
-                        possible_position.board[m][n] = 0;
-                        possible_position.board[m][n - 1] = 0;
-                        if (!Board::king_is_in_check(possible_position.board, BLACK))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                            if (score < best_score)
-                            {
-                                best_position = Board::copy_position(possible_position);
-                                best_score = score;
-                                from_i = m;
-                                from_j = n;
-                                to_i = m + 1;
-                                to_j = n - 1;
-                            }
-                        }
-                    }
-                }
+            start = chrono::steady_clock::now();
+        }
+    }
 
-                if (position.board[m][n] == BLACK_KNIGHT)
-                {
-                    for (int k = 0; k < 8; k++)
-                    {
-                        int k_i = m + knight_move[k][0];
-                        int k_j = n + knight_move[k][1];
-                        if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8)
-                        {
-                            if (Board::under_knight_control(m, n, k_i, k_j) && position.board[k_i][k_j] >= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[k_i][k_j] = BLACK_KNIGHT;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                    if (score < best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = k_i;
-                                        to_j = k_j;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+    ~PhaseTimer()
+    {
+        if (timed)
+        {
+            clock.timed_calls++;
+            clock.timed_ns += (long)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        }
+    }
+};
 
-                if (position.board[m][n] == BLACK_BISHOP)
-                {
-                    for (int k = 0; k < 4; k++)
-                    {
-                        int path_i = m + bishop_direction[k][0];
-                        int path_j = n + bishop_direction[k][1];
-                        while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                        {
-                            if (Board::under_bishop_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] >= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[path_i][path_j] = BLACK_BISHOP;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                    if (score < best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = path_i;
-                                        to_j = path_j;
-                                    }
-                                }
-                            }
-                            // if next square is not empty, we stop
-                            if (position.board[path_i][path_j] != 0)
-                            {
-                                break;
-                            }
-                            path_i += bishop_direction[k][0];
-                            path_j += bishop_direction[k][1];
-                        }
-                    }
-                }
+// --- Another iteration is only started if it can plausibly finish in the time left ---
+// --- Each iteration takes several times longer than the previous one ---
+static bool time_for_next_iteration(int elapsed, int budget)
+{
+    return budget <= 0 || elapsed * 2 < budget;
+}
 
-                if (position.board[m][n] == BLACK_ROOK)
-                {
-                    for (int k = 0; k < 4; k++)
-                    {
-                        int path_i = m + rook_direction[k][0];
-                        int path_j = n + rook_direction[k][1];
-                        while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                        {
-                            if (Board::under_rook_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] >= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[path_i][path_j] = BLACK_ROOK;
-                                possible_position.board[m][n] = 0;
-                                if (m == 0 && n == 0)
-                                {
-                                    possible_position.can_castle_black[0] = false;
-                                }
-                                if (m == 0 && n == 7)
-                                {
-                                    possible_position.can_castle_black[1] = false;
-                                }
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                    if (score < best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = path_i;
-                                        to_j = path_j;
-                                    }
-                                }
-                            }
-                            // if next square is not empty, we stop
-                            if (position.board[path_i][path_j] != 0)
-                            {
-                                break;
-                            }
-                            path_i += rook_direction[k][0];
-                            path_j += rook_direction[k][1];
-                        }
-                    }
-                }
+// --- Collects the legal moves of side s ---
+static void generate_legal_moves(Position &position, side s, MoveList &legal)
+{
+    MoveList moves;
+    generate_moves(position, s, moves);
 
-                if (position.board[m][n] == BLACK_QUEEN)
-                {
-                    for (int k = 0; k < 8; k++)
-                    {
-                        int path_i = m + every_direction[k][0];
-                        int path_j = n + every_direction[k][1];
-                        while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                        {
-                            if (Board::under_queen_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] >= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[path_i][path_j] = BLACK_QUEEN;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                    if (score < best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = path_i;
-                                        to_j = path_j;
-                                    }
-                                }
-                            }
-                            // if next square is not empty, we stop
-                            if (position.board[path_i][path_j] != 0)
-                            {
-                                break;
-                            }
-                            path_i += every_direction[k][0];
-                            path_j += every_direction[k][1];
-                        }
-                    }
-                }
+    Undo undo;
+    for (int k = 0; k < moves.count; k++)
+    {
+        position.make_move(moves.moves[k], undo);
+        if (!position.in_check(s))
+        {
+            legal.add(moves.moves[k]);
+        }
+        position.unmake_move(moves.moves[k], undo);
+    }
+}
 
-                if (position.board[m][n] == BLACK_KING)
-                {
-                    for (int k = 0; k < 8; k++)
-                    {
-                        int k_i = m + every_direction[k][0];
-                        int k_j = n + every_direction[k][1];
-                        if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8)
-                        {
-                            if (Board::under_king_control(m, n, k_i, k_j) && position.board[k_i][k_j] >= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[k_i][k_j] = BLACK_KING;
-                                possible_position.board[m][n] = 0;
-                                possible_position.can_castle_black[0] = false;
-                                possible_position.can_castle_black[1] = false;
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                                    if (score < best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = k_i;
-                                        to_j = k_j;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    // castling kingside
-                    if (m == 0 && n == 4 && position.board[0][5] == 0 && position.board[0][6] == 0 && position.board[0][7] == BLACK_ROOK && !Board::under_control(position.board, 0, 4, WHITE) && !Board::under_control(position.board, 0, 5, WHITE) && !Board::under_control(position.board, 0, 6, WHITE) && position.can_castle_black[1])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[0][6] = BLACK_KING;
-                        possible_position.board[0][4] = 0;
-                        possible_position.board[0][7] = 0;
-                        possible_position.board[0][5] = BLACK_ROOK;
-                        possible_position.can_castle_black[0] = false;
-                        possible_position.can_castle_black[1] = false;
-                        if (!Board::king_is_in_check(possible_position.board, BLACK))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                            if (score < best_score)
-                            {
-                                best_position = Board::copy_position(possible_position);
-                                best_score = score;
-                                from_i = 0;
-                                from_j = 4;
-                                to_i = 0;
-                                to_j = 6;
-                            }
-                        }
-                    }
-                    // castling queenside
-                    if (m == 0 && n == 4 && position.board[0][1] == 0 && position.board[0][2] == 0 && position.board[0][3] == 0 && position.board[0][0] == BLACK_ROOK && !Board::under_control(position.board, 0, 2, WHITE) && !Board::under_control(position.board, 0, 3, WHITE) && !Board::under_control(position.board, 0, 4, WHITE) && position.can_castle_black[0])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[0][2] = BLACK_KING;
-                        possible_position.board[0][4] = 0;
-                        possible_position.board[0][0] = 0;
-                        possible_position.board[0][3] = BLACK_ROOK;
-                        possible_position.can_castle_black[0] = false;
-                        possible_position.can_castle_black[1] = false;
-                        if (!Board::king_is_in_check(possible_position.board, BLACK))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, true, alpha, beta);
-                            if (score < best_score)
-                            {
-                                best_position = Board::copy_position(possible_position);
-                                best_score = score;
-                                from_i = 0;
-                                from_j = 4;
-                                to_i = 0;
-                                to_j = 2;
-                            }
-                        }
-                    }
-                }
+// --- Moves the entry at index k to index to (to <= k), keeping the order of the others ---
+static void move_to_index(MoveList &list, int k, int to)
+{
+    Move m = list.moves[k];
+    for (; k > to; k--)
+    {
+        list.moves[k] = list.moves[k - 1];
+    }
+    list.moves[to] = m;
+}
+
+// --- Converts a score from side s's point of view to White's ---
+static int to_white(int score, side s)
+{
+    return (s == WHITE) ? score : -score;
+}
+
+// --- Score of a position where side s is checkmated, from White's point of view ---
+static int mated_score(side s, int ply)
+{
+    return (s == WHITE) ? -(MATE_VALUE - ply) : (MATE_VALUE - ply);
+}
+
+// --- Mate and tablebase scores are stored relative to the node and converted back on
+// --- probing, so a mate or tablebase win found through a transposition keeps its true
+// --- distance from the root ---
+static int score_to_tt(int score, int ply)
+{
+    if (score >= TB_WIN_BOUND)
+        return score + ply;
+    if (score <= -TB_WIN_BOUND)
+        return score - ply;
+    return score;
+}
+
+static int score_from_tt(int score, int ply)
+{
+    if (score >= TB_WIN_BOUND)
+        return score - ply;
+    if (score <= -TB_WIN_BOUND)
+        return score + ply;
+    return score;
+}
+
+// --- Sorts root moves once before the first iteration (captures first) ---
+static void order_root_moves(const Position &root, MoveList &moves, const OrderingTables &tables)
+{
+    int scores[MAX_MOVES];
+    score_moves(root, moves, NO_MOVE, tables, 0, scores);
+    for (int k = 0; k < moves.count; k++)
+    {
+        pick_move(moves, scores, k);
+    }
+}
+
+// --- Fills an EngineMove with coordinates and notation of a root move ---
+static EngineMove describe_move(Board &board, Move m, side s)
+{
+    EngineMove em;
+    em.from_i = row_of(move_from(m));
+    em.from_j = col_of(move_from(m));
+    em.to_i = row_of(move_to(m));
+    em.to_j = col_of(move_to(m));
+    em.notation = board.generate_move_notation(em.from_i, em.from_j, em.to_i, em.to_j, s);
+    em.move = m;
+    return em;
+}
+
+// --- Follows the best moves stored in the table from the root, starting with best ---
+// --- Stops at a missing or illegal move (a key collision) and never goes past depth plies ---
+std::vector<Move> Engine::principal_variation(Position root, Move best, int depth) const
+{
+    std::vector<Move> pv;
+    Move m = best;
+    Undo undo;
+
+    while (m != NO_MOVE && (int)pv.size() < depth)
+    {
+        MoveList legal;
+        generate_legal_moves(root, root.to_move, legal);
+        if (find(legal.moves, legal.moves + legal.count, m) == legal.moves + legal.count)
+        {
+            break;
+        }
+
+        pv.push_back(m);
+        root.make_move(m, undo);
+
+        TTEntry entry;
+        m = tt.probe(root.key, entry) ? entry.move : NO_MOVE;
+    }
+    return pv;
+}
+
+// --- Searches one root move to the given depth; scores are from side s's point of view ---
+int Engine::search_root_move(SearchWorker &worker, Position &root, Move m, int depth, side s, int alpha, int beta)
+{
+    if (network.is_open())
+    {
+        network.refresh(root, worker.accumulators[0]);
+    }
+
+    Undo undo;
+    root.make_move(m, undo);
+    update_accumulator(worker, root, m, undo, 0);
+    int score = (s == WHITE) ? adv_minimax<BLACK>(worker, root, depth - 1, 1, alpha, beta)
+                             : -adv_minimax<WHITE>(worker, root, depth - 1, 1, -beta, -alpha);
+    root.unmake_move(m, undo);
+    return score;
+}
+
+// --- Searches the root moves from index first on, within the window; returns the best score ---
+// --- Principal variation search: the first move (the best one so far) gets the window, the
+// --- others only a zero window that proves them worse, and are searched again if they are not ---
+int Engine::search_root_moves(SearchWorker &worker, Position &root, MoveList &moves, int first, int depth, side s, int alpha, int beta, int &best_index)
+{
+    int best_score = -INFINITE_SCORE;
+    best_index = first;
+
+    for (int k = first; k < moves.count; k++)
+    {
+        int score;
+        if (k == first)
+        {
+            score = search_root_move(worker, root, moves.moves[k], depth, s, alpha, beta);
+        }
+        else
+        {
+            score = search_root_move(worker, root, moves.moves[k], depth, s, alpha, alpha + 1);
+            if (score > alpha && score < beta && !stopped)
+            {
+                score = search_root_move(worker, root, moves.moves[k], depth, s, alpha, beta);
             }
         }
+
+        if (stopped)
+        {
+            break;
+        }
+
+        if (score > best_score)
+        {
+            best_score = score;
+            best_index = k;
+            alpha = max(alpha, score);
+        }
+        if (alpha >= beta)
+        {
+            break;
+        }
     }
+    return best_score;
+}
 
-    // --- Stores Information in result data structure ---
-    computer_move_notation = board.generate_move_notation(from_i, from_j, to_i, to_j, BLACK);
-    EngineMove result;
-    result.notation = computer_move_notation;
-    result.from_i = from_i;
-    result.from_j = from_j;
-    result.to_i = to_i;
-    result.to_j = to_j;
-    result.eval = (float)best_score / 100;
-    result.nodes = paths;
+// --- Finds the best of the root moves from index first on, starting with an aspiration
+// --- window around the score the line had in the previous iteration. A score outside the
+// --- window is only a bound, so the window is widened on that side and the search repeated ---
+int Engine::search_line(SearchWorker &worker, Position &root, MoveList &moves, int first, int depth, side s, int previous, int &best_index)
+{
+    int delta = ASPIRATION_WINDOW;
+    int alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+    if (depth >= ASPIRATION_MIN_DEPTH && abs(previous) < MATE_BOUND)
+    {
+        alpha = previous - delta;
+        beta = previous + delta;
+    }
 
-    // --- resets the total no of nodes visited ---
-    paths = 0;
+    while (true)
+    {
+        int score = search_root_moves(worker, root, moves, first, depth, s, alpha, beta, best_index);
+        if (stopped)
+        {
+            return score;
+        }
 
-    // --- Apply best move to actual game ---
-    position = Board::copy_position(best_position);
+        if (score <= alpha && alpha > -INFINITE_SCORE)
+            alpha = max(-INFINITE_SCORE, alpha - delta);
+        else if (score >= beta && beta < INFINITE_SCORE)
+            beta = min(INFINITE_SCORE, beta + delta);
+        else
+            return score;
+        delta *= 2;
+    }
+}
 
-    return result;
+// --- Iterative deepening loop run by each helper thread ---
+// --- Odd helpers start one ply deeper so threads spread over different depths ---
+void Engine::helper_search(SearchWorker &worker, Position root, MoveList moves, side s)
+{
+    int score = 0;
+    for (int depth = 1 + (worker.id & 1); depth <= limits.depth && !stopped; depth++)
+    {
+        int best_index;
+        score = search_line(worker, root, moves, 0, depth, s, score, best_index);
+        if (stopped)
+        {
+            break;
+        }
+        move_to_index(moves, best_index, 0);
+    }
 }
 
-// --- Returns the best move for White using minimax search ---
-EngineMove Engine::make_white_move(board_state &position)
+// --- Launches one thread per helper worker on a copy of the root ---
+void Engine::start_helpers(const Position &root, const MoveList &moves, side s)
+{
+    for (size_t t = 1; t < workers.size(); t++)
+    {
+        helpers.push_back(thread(&Engine::helper_search, this, ref(*workers[t]), root, moves, s));
+    }
+}
+
+// --- Stops and joins all helper threads ---
+void Engine::stop_helpers()
+{
+    stopped = true;
+    for (size_t t = 0; t < helpers.size(); t++)
+    {
+        helpers[t].join();
+    }
+    helpers.clear();
+}
+
+// --- Iterative deepening over the best `lines` root moves of side s (MultiPV) ---
+// --- Each iteration finds line 1 among all moves, line 2 among the rest, and so on, and
+// --- moves each line's move to its index, so the next iteration tries them in that order
+// --- and opens every line's aspiration window around its last score. Returns the lines of
+// --- the last completed iteration, best first, each with its principal variation ---
+std::vector<EngineMove> Engine::search_multipv(const board_state &position, side s, int lines, Move &fallback)
 {
     Board board;
     board.get_position() = position;
-    int from_i = -1, from_j = -1, to_i = -1, to_j = -1;
-    int best_score = INT_MIN;
-    board_state possible_position;
-    board_state best_position;
-    string computer_move_notation;
 
-    Board::reset_en_passant(position, WHITE);
+    SearchWorker &main_worker = *workers[0];
+    Position root = Position::from_board_state(position, s);
+    MoveList moves;
+    generate_legal_moves(root, s, moves);
+    start_search();
+    order_root_moves(root, moves, main_worker.ordering);
+    start_helpers(root, moves, s);
+
+    lines = max(0, min(lines, moves.count));
+    fallback = moves.count > 0 ? moves.moves[0] : NO_MOVE;
 
-    for (int m = 0; m < 8; m++)
+    std::vector<EngineMove> result;
+    std::vector<int> line_scores(lines, 0);
+    std::vector<long> iteration_nodes;
+
+    for (int depth = 1; depth <= limits.depth && lines > 0; depth++)
     {
-        for (int n = 0; n < 8; n++)
+        std::vector<int> scores(lines, 0);
+        for (int pv = 0; pv < lines && !stopped; pv++)
+        {
+            int best_index;
+            scores[pv] = search_line(main_worker, root, moves, pv, depth, s, line_scores[pv], best_index);
+            move_to_index(moves, best_index, pv);
+        }
+
+        if (stopped)
         {
-            if (position.board[m][n] > 0)
+            break;
+        }
+
+        // --- A later line can come out ahead of an earlier one when its window had to widen ---
+        for (int a = 1; a < lines; a++)
+        {
+            for (int b = a; b > 0 && scores[b] > scores[b - 1]; b--)
             {
-                if (position.board[m][n] == WHITE_PAWN)
-                {
-                    // one move forward by pawn
-                    if (position.board[m - 1][n] == 0)
-                    {
-                        // if not moving to last rank
-                        if (m - 1 != 0)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m - 1][n] = WHITE_PAWN;
-                            possible_position.board[m][n] = 0;
-
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                int alpha = INT_MIN, beta = INT_MAX;
-                                int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                if (score > best_score)
-                                {
-                                    best_position = Board::copy_position(possible_position);
-                                    best_score = score;
-                                    from_i = m;
-                                    from_j = n;
-                                    to_i = m - 1;
-                                    to_j = n;
-                                }
-                            }
-                        }
-                        // if moves last rank, then cycle through promotion of all pieces
-                        else
-                        {
-                            // variable i denotes possible pieces from white knight to queen
-                            for (char i = 5; i >= 2; i--)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m - 1][n] = i;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                    if (score > best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = m - 1;
-                                        to_j = n;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    // two moves from starting position by pawn
-                    if (m == 6 && position.board[m - 1][n] == 0 && position.board[m - 2][n] == 0)
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[m - 2][n] = WHITE_PAWN;
-                        possible_position.board[m][n] = 0;
-
-                        possible_position.pawn_two_squares_white[n] = true;
-
-                        if (!Board::king_is_in_check(possible_position.board, WHITE))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                            if (score > best_score)
-                            {
-                                best_position = Board::copy_position(possible_position);
-                                best_score = score;
-                                from_i = m;
-                                from_j = n;
-                                to_i = m - 2;
-                                to_j = n;
-                            }
-                        }
-                    }
-                    // capture to the left
-                    if (n != 7 && position.board[m - 1][n + 1] < 0)
-                    {
-                        if (m - 1 != 0)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m - 1][n + 1] = WHITE_PAWN;
-                            possible_position.board[m][n] = 0;
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                int alpha = INT_MIN, beta = INT_MAX;
-                                int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                if (score > best_score)
-                                {
-                                    best_position = Board::copy_position(possible_position);
-                                    best_score = score;
-                                    from_i = m;
-                                    from_j = n;
-                                    to_i = m - 1;
-                                    to_j = n + 1;
-                                }
-                            }
-                        }
-                        // if moves last rank, then cycle through promotion of all pieces
-                        else
-                        {
-                            // variable i is possible pieces from knight to queen
-                            for (char i = 5; i >= 2; i--)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m - 1][n + 1] = i;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                    if (score > best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = m - 1;
-                                        to_j = n + 1;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    // capture to the right
-                    if (n != 0 && position.board[m - 1][n - 1] < 0)
-                    {
-                        if (m - 1 != 0)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m - 1][n - 1] = WHITE_PAWN;
-                            possible_position.board[m][n] = 0;
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                int alpha = INT_MIN, beta = INT_MAX;
-                                int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                if (score > best_score)
-                                {
-                                    best_position = Board::copy_position(possible_position);
-                                    best_score = score;
-                                    from_i = m;
-                                    from_j = n;
-                                    to_i = m - 1;
-                                    to_j = n - 1;
-                                }
-                            }
-                        }
-                        // if moves last rank, then cycle through promotion of all pieces
-                        else
-                        {
-                            // variable i is possible pieces from white knight to queen
-                            for (char i = 5; i >= 2; i--)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m - 1][n - 1] = i;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                    if (score > best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = m - 1;
-                                        to_j = n - 1;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    // en passant to the left
-                    if (n != 7 && position.board[m][n + 1] == -1 && position.pawn_two_squares_black[n + 1])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[m - 1][n + 1] = WHITE_PAWN;
-                        possible_position.board[m][n] = 0;
-                        possible_position.board[m][n + 1] = 0;
-                        if (!Board::king_is_in_check(possible_position.board, WHITE))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                            if (score > best_score)
-                            {
-                                best_position = Board::copy_position(possible_position);
-                                best_score = score;
-                                from_i = m;
-                                from_j = n;
-                                to_i = m - 1;
-                                to_j = n + 1;
-                            }
-                        }
-                    }
-                    // en passant to the right
-                    if (n != 0 && position.board[m][n - 1] == -1 && position.pawn_two_squares_black[n - 1])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[m - 1][n - 1] = WHITE_PAWN;
-                        possible_position.board[m][n] = 0;
-                        possible_position.board[m][n - 1] = 0;
-                        if (!Board::king_is_in_check(possible_position.board, WHITE))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                            if (score > best_score)
-                            {
-                                best_position = Board::copy_position(possible_position);
-                                best_score = score;
-                                from_i = m;
-                                from_j = n;
-                                to_i = m - 1;
-                                to_j = n - 1;
-                            }
-                        }
-                    }
-                }
+                swap(scores[b], scores[b - 1]);
+                swap(moves.moves[b], moves.moves[b - 1]);
+            }
+        }
+        line_scores = scores;
 
-                if (position.board[m][n] == WHITE_KNIGHT)
-                {
-                    for (int k = 0; k < 8; k++)
-                    {
-                        int k_i = m + knight_move[k][0];
-                        int k_j = n + knight_move[k][1];
-                        if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8)
-                        {
-                            if (Board::under_knight_control(m, n, k_i, k_j) && position.board[k_i][k_j] <= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[k_i][k_j] = WHITE_KNIGHT;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                    if (score > best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = k_i;
-                                        to_j = k_j;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+        result.clear();
+        for (int pv = 0; pv < lines; pv++)
+        {
+            EngineMove em = describe_move(board, moves.moves[pv], s);
+            em.eval = (float)to_white(scores[pv], s) / 100;
+            em.nodes = (int)searched_nodes();
+            em.pv = principal_variation(root, moves.moves[pv], depth);
+            result.push_back(em);
+        }
 
-                if (position.board[m][n] == WHITE_BISHOP)
-                {
-                    for (int k = 0; k < 4; k++)
-                    {
-                        int path_i = m + bishop_direction[k][0];
-                        int path_j = n + bishop_direction[k][1];
-                        while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                        {
-                            if (Board::under_bishop_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] <= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[path_i][path_j] = WHITE_BISHOP;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                    if (score > best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = path_i;
-                                        to_j = path_j;
-                                    }
-                                }
-                            }
-                            // if next square is not empty, we stop
-                            if (position.board[path_i][path_j] != 0)
-                            {
-                                break;
-                            }
-                            path_i += bishop_direction[k][0];
-                            path_j += bishop_direction[k][1];
-                        }
-                    }
-                }
+        tt.store(root.key, depth, BOUND_EXACT, to_white(scores[0], s), moves.moves[0]);
+        can_stop = true;
+        iteration_nodes.push_back(searched_nodes());
+        report_iteration(depth, to_white(scores[0], s), result[0].notation, result[0].pv);
 
-                if (position.board[m][n] == WHITE_ROOK)
-                {
-                    for (int k = 0; k < 4; k++)
-                    {
-                        int path_i = m + rook_direction[k][0];
-                        int path_j = n + rook_direction[k][1];
-                        while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                        {
-                            if (Board::under_rook_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] <= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[path_i][path_j] = WHITE_ROOK;
-                                possible_position.board[m][n] = 0; // recheck logic
-                                if (m == 7 && n == 0)
-                                {
-                                    possible_position.can_castle_white[0] = false;
-                                }
-                                if (m == 7 && n == 7)
-                                {
-                                    possible_position.can_castle_white[1] = false;
-                                }
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                    if (score > best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = path_i;
-                                        to_j = path_j;
-                                    }
-                                }
-                            }
-                            // if next square is not empty, we stop
-                            if (position.board[path_i][path_j] != 0)
-                            {
-                                break;
-                            }
-                            path_i += rook_direction[k][0];
-                            path_j += rook_direction[k][1];
-                        }
-                    }
-                }
+        // --- A forced mate will not get any better by searching deeper ---
+        if (scores[0] > MATE_BOUND || scores[0] < -MATE_BOUND)
+        {
+            break;
+        }
+        if (!pondering && !time_for_next_iteration(elapsed_ms(), limits.time_ms))
+        {
+            break;
+        }
+    }
 
-                if (position.board[m][n] == WHITE_QUEEN)
-                {
-                    for (int k = 0; k < 8; k++)
-                    {
-                        int path_i = m + every_direction[k][0];
-                        int path_j = n + every_direction[k][1];
-                        while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                        {
-                            if (Board::under_queen_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] <= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[path_i][path_j] = WHITE_QUEEN;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                    if (score > best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = path_i;
-                                        to_j = path_j;
-                                    }
-                                }
-                            }
-                            // if next square is not empty, we stop
-                            if (position.board[path_i][path_j] != 0)
-                            {
-                                break;
-                            }
-                            path_i += every_direction[k][0];
-                            path_j += every_direction[k][1];
-                        }
-                    }
-                }
+    stop_helpers();
 
-                if (position.board[m][n] == WHITE_KING)
-                {
-                    for (int k = 0; k < 8; k++)
-                    {
-                        int k_i = m + every_direction[k][0];
-                        int k_j = n + every_direction[k][1];
-                        if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8)
-                        {
-                            if (Board::under_king_control(m, n, k_i, k_j) && position.board[k_i][k_j] <= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[k_i][k_j] = WHITE_KING;
-                                possible_position.board[m][n] = 0;
-                                possible_position.can_castle_white[0] = false;
-                                possible_position.can_castle_white[1] = false;
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                                    if (score > best_score)
-                                    {
-                                        best_position = Board::copy_position(possible_position);
-                                        best_score = score;
-                                        from_i = m;
-                                        from_j = n;
-                                        to_i = k_i;
-                                        to_j = k_j;
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    // castling kingside
-                    if (m == 7 && n == 4 && position.board[7][5] == 0 && position.board[7][6] == 0 && position.board[7][7] == WHITE_ROOK && !Board::under_control(position.board, 7, 4, BLACK) && !Board::under_control(position.board, 7, 5, BLACK) && !Board::under_control(position.board, 7, 6, BLACK) && position.can_castle_white[1])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[7][6] = WHITE_KING;
-                        possible_position.board[7][4] = 0;
-                        possible_position.board[7][7] = 0;
-                        possible_position.board[7][5] = WHITE_ROOK;
-                        possible_position.can_castle_white[0] = false;
-                        possible_position.can_castle_white[1] = false;
-                        if (!Board::king_is_in_check(possible_position.board, WHITE))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                            if (score > best_score)
-                            {
-                                best_position = Board::copy_position(possible_position);
-                                best_score = score;
-                                from_i = 7;
-                                from_j = 4;
-                                to_i = 7;
-                                to_j = 6;
-                            }
-                        }
-                    }
-                    // castling queenside
-                    if (m == 7 && n == 4 && position.board[7][1] == 0 && position.board[7][2] == 0 && position.board[7][3] == 0 && position.board[7][0] == WHITE_ROOK && !Board::under_control(position.board, 7, 2, BLACK) && !Board::under_control(position.board, 7, 3, BLACK) && !Board::under_control(position.board, 7, 4, BLACK) && position.can_castle_white[0])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[7][2] = WHITE_KING;
-                        possible_position.board[7][4] = 0;
-                        possible_position.board[7][0] = 0;
-                        possible_position.board[7][3] = WHITE_ROOK;
-                        possible_position.can_castle_white[0] = false;
-                        possible_position.can_castle_white[1] = false;
-                        if (!Board::king_is_in_check(possible_position.board, WHITE))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-                            if (score > best_score)
-                            {
-                                best_position = Board::copy_position(possible_position);
-                                best_score = score;
-                                from_i = 7;
-                                from_j = 4;
-                                to_i = 7;
-                                to_j = 2;
-                            }
-                        }
-                    }
-                }
-            }
+    SearchStats stats = collect_stats(iteration_nodes);
+    for (size_t k = 0; k < result.size(); k++)
+    {
+        result[k].stats = stats;
+    }
+    return result;
+}
+
+// --- Searches every legal move of side s, applies the best one and returns it ---
+// --- Iterates depth 1, 2, ... and keeps the best move of the last completed iteration ---
+EngineMove Engine::search_root(board_state &position, side s)
+{
+    Position root = Position::from_board_state(position, s);
+
+    // --- Book positions, and endgames the tablebases show won or lost, are played at once
+    // --- without starting a search. Drawn endgames are still searched: any move keeping
+    // --- the draw will do, and the search, which probes the tables, finds one ---
+    Move direct_move = NO_MOVE;
+    int direct_score = 0;
+    if (book.is_open())
+    {
+        direct_move = book.probe(root, book_rng);
+    }
+    if (direct_move == NO_MOVE && tablebases.is_enabled() && popcount(root.occupied) <= TB_MAX_PIECES)
+    {
+        Move best;
+        int wdl, dtz;
+        if (tablebases.probe_root(root, best, wdl, dtz) && wdl != TB_DRAW)
+        {
+            direct_move = best;
+            direct_score = to_white(wdl == TB_WIN ? TB_WIN_SCORE - dtz : -(TB_WIN_SCORE - dtz), s);
         }
     }
 
-    // --- Stores Information in result data structure ---
-    computer_move_notation = board.generate_move_notation(from_i, from_j, to_i, to_j, WHITE);
-    EngineMove result;
-    result.notation = computer_move_notation;
-    result.from_i = from_i;
-    result.from_j = from_j;
-    result.to_i = to_i;
-    result.to_j = to_j;
-    result.eval = (float)best_score / 100;
-    result.nodes = paths;
+    Move fallback = NO_MOVE;
+    std::vector<EngineMove> lines;
+    if (direct_move == NO_MOVE)
+    {
+        lines = search_multipv(position, s, 1, fallback);
+    }
 
-    // --- resets the total no of nodes visited ---
-    paths = 0;
+    EngineMove result;
+    if (direct_move != NO_MOVE)
+    {
+        Board board;
+        board.get_position() = position;
+        result = describe_move(board, direct_move, s);
+        result.eval = (float)direct_score / 100;
+        result.pv.push_back(direct_move);
+    }
+    else if (!lines.empty())
+    {
+        result = lines[0];
+    }
+    else if (fallback != NO_MOVE)
+    {
+        // --- Forced before the first iteration finished: play the first ordered move ---
+        Board board;
+        board.get_position() = position;
+        result = describe_move(board, fallback, s);
+        result.nodes = (int)searched_nodes();
+        result.stats = collect_stats(std::vector<long>());
+    }
+    else
+    {
+        // --- No legal move: checkmate or stalemate ---
+        result.from_i = result.from_j = result.to_i = result.to_j = -1;
+        result.eval = (float)(root.in_check(s) ? mated_score(s, 0) : 0) / 100;
+        result.stats = collect_stats(std::vector<long>());
+    }
 
     // --- Apply best move to actual game ---
-    position = Board::copy_position(best_position);
+    if (result.move != NO_MOVE)
+    {
+        Undo undo;
+        root.make_move(result.move, undo);
+        root.to_board_state(position);
+    }
+
+    return result;
+}
+
+// --- Returns and apply the best move for Black using minimax search ---
+EngineMove Engine::make_black_move(board_state &position)
+{
+    stop_requested = false;
+    return search_root(position, BLACK);
+}
 
-     return result;
+// --- Returns and apply the best move for White using minimax search ---
+EngineMove Engine::make_white_move(board_state &position)
+{
+    stop_requested = false;
+    return search_root(position, WHITE);
 }
 
 // --- Returns a vector of top 1–3 best White moves sorted by evaluation ---
 std::vector<EngineMove> Engine::get_best_white_moves(board_state &position)
 {
-    Board board;
-    board.get_position() = position;
-    Board::reset_en_passant(position, WHITE);
-    board_state possible_position;
+    return get_best_moves(position, WHITE);
+}
 
-    std::vector<EngineMove> move_list;
+// --- Returns the best moves of side s, best first, each with its principal variation ---
+std::vector<EngineMove> Engine::get_best_moves(board_state &position, side s, int lines)
+{
+    stop_requested = false;
+    return search_hints(position, s, lines);
+}
+
+// --- MultiPV search for hints; moves that lose too much are left out, but never all of them ---
+std::vector<EngineMove> Engine::search_hints(const board_state &position, side s, int lines)
+{
+    Move fallback;
+    std::vector<EngineMove> found = search_multipv(position, s, lines, fallback);
 
-    for (int m = 0; m < 8; m++)
+    std::vector<EngineMove> top_moves;
+    for (size_t k = 0; k < found.size(); k++)
     {
-        for (int n = 0; n < 8; n++)
+        float own_eval = (s == WHITE) ? found[k].eval : -found[k].eval;
+        if (k == 0 || own_eval >= HINT_MIN_EVAL)
         {
-            if (position.board[m][n] > 0)
-            {
-                if (position.board[m][n] == WHITE_PAWN)
-                {
-                    // one move forward by pawn
-                    if (position.board[m - 1][n] == 0)
-                    {
-                        // if not moving to last rank
-                        if (m - 1 != 0)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m - 1][n] = WHITE_PAWN;
-                            possible_position.board[m][n] = 0;
-
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                int alpha = INT_MIN, beta = INT_MAX;
-                                int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                EngineMove em;
-                                em.from_i = m;
-                                em.from_j = n;
-                                em.to_i = m - 1;
-                                em.to_j = n;
-                                em.eval = (float)score / 100;
-                                em.notation = board.generate_move_notation(m, n, m - 1, n, WHITE);
-                                em.nodes = paths;
-
-                                move_list.push_back(em);
-                            }
-                        }
-                        // if moves last rank, then cycle through promotion of all pieces
-                        else
-                        {
-                            // variable i denotes possible pieces from white knight to queen
-                            for (char i = 5; i >= 2; i--)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m - 1][n] = i;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                    EngineMove em;
-                                    em.from_i = m;
-                                    em.from_j = n;
-                                    em.to_i = m - 1;
-                                    em.to_j = n;
-                                    em.eval = (float)score / 100;
-                                    em.notation = board.generate_move_notation(m, n, m - 1, n, WHITE);
-                                    em.nodes = paths;
-
-                                    move_list.push_back(em);
-                                }
-                            }
-                        }
-                    }
-                    // two moves from starting position by pawn
-                    if (m == 6 && position.board[m - 1][n] == 0 && position.board[m - 2][n] == 0)
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[m - 2][n] = WHITE_PAWN;
-                        possible_position.board[m][n] = 0;
-
-                        possible_position.pawn_two_squares_white[n] = true;
-
-                        if (!Board::king_is_in_check(possible_position.board, WHITE))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                            EngineMove em;
-                            em.from_i = m;
-                            em.from_j = n;
-                            em.to_i = m - 2;
-                            em.to_j = n;
-                            em.eval = (float)score / 100;
-                            em.notation = board.generate_move_notation(m, n, m - 2, n, WHITE);
-                            em.nodes = paths;
-
-                            move_list.push_back(em);
-                        }
-                    }
-                    // capture to the left
-                    if (n != 7 && position.board[m - 1][n + 1] < 0)
-                    {
-                        if (m - 1 != 0)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m - 1][n + 1] = WHITE_PAWN;
-                            possible_position.board[m][n] = 0;
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                int alpha = INT_MIN, beta = INT_MAX;
-                                int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                EngineMove em;
-                                em.from_i = m;
-                                em.from_j = n;
-                                em.to_i = m - 1;
-                                em.to_j = n + 1;
-                                em.eval = (float)score / 100;
-                                em.notation = board.generate_move_notation(m, n, m - 1, n + 1, WHITE);
-                                em.nodes = paths;
-
-                                move_list.push_back(em);
-                            }
-                        }
-                        // if moves last rank, then cycle through promotion of all pieces
-                        else
-                        {
-                            // variable i is possible pieces from knight to queen
-                            for (char i = 5; i >= 2; i--)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m - 1][n + 1] = i;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                    EngineMove em;
-                                    em.from_i = m;
-                                    em.from_j = n;
-                                    em.to_i = m - 1;
-                                    em.to_j = n + 1;
-                                    em.eval = (float)score / 100;
-                                    em.notation = board.generate_move_notation(m, n, m - 1, n + 1, WHITE);
-                                    em.nodes = paths;
-
-                                    move_list.push_back(em);
-                                }
-                            }
-                        }
-                    }
-                    // capture to the right
-                    if (n != 0 && position.board[m - 1][n - 1] < 0)
-                    {
-                        if (m - 1 != 0)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m - 1][n - 1] = WHITE_PAWN;
-                            possible_position.board[m][n] = 0;
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                int alpha = INT_MIN, beta = INT_MAX;
-                                int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                EngineMove em;
-                                em.from_i = m;
-                                em.from_j = n;
-                                em.to_i = m - 1;
-                                em.to_j = n - 1;
-                                em.eval = (float)score / 100;
-                                em.notation = board.generate_move_notation(m, n, m - 1, n - 1, WHITE);
-                                em.nodes = paths;
-
-                                move_list.push_back(em);
-                            }
-                        }
-                        // if moves last rank, then cycle through promotion of all pieces
-                        else
-                        {
-                            // variable i is possible pieces from white knight to queen
-                            for (char i = 5; i >= 2; i--)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m - 1][n - 1] = i;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                    EngineMove em;
-                                    em.from_i = m;
-                                    em.from_j = n;
-                                    em.to_i = m - 1;
-                                    em.to_j = n - 1;
-                                    em.eval = (float)score / 100;
-                                    em.notation = board.generate_move_notation(m, n, m - 1, n - 1, WHITE);
-                                    em.nodes = paths;
-
-                                    move_list.push_back(em);
-                                }
-                            }
-                        }
-                    }
-                    // en passant to the left
-                    if (n != 7 && position.board[m][n + 1] == -1 && position.pawn_two_squares_black[n + 1])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[m - 1][n + 1] = WHITE_PAWN;
-                        possible_position.board[m][n] = 0;
-                        possible_position.board[m][n + 1] = 0;
-                        if (!Board::king_is_in_check(possible_position.board, WHITE))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                            EngineMove em;
-                            em.from_i = m;
-                            em.from_j = n;
-                            em.to_i = m - 1;
-                            em.to_j = n + 1;
-                            em.eval = (float)score / 100;
-                            em.notation = board.generate_move_notation(m, n, m - 1, n + 1, WHITE);
-                            em.nodes = paths;
-
-                            move_list.push_back(em);
-                        }
-                    }
-                    // en passant to the right
-                    if (n != 0 && position.board[m][n - 1] == -1 && position.pawn_two_squares_black[n - 1])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[m - 1][n - 1] = WHITE_PAWN;
-                        possible_position.board[m][n] = 0;
-                        possible_position.board[m][n - 1] = 0;
-                        if (!Board::king_is_in_check(possible_position.board, WHITE))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                            EngineMove em;
-                            em.from_i = m;
-                            em.from_j = n;
-                            em.to_i = m - 1;
-                            em.to_j = n - 1;
-                            em.eval = (float)score / 100;
-                            em.notation = board.generate_move_notation(m, n, m - 1, n - 1, WHITE);
-                            em.nodes = paths;
-
-                            move_list.push_back(em);
-                        }
-                    }
-                }
+            top_moves.push_back(found[k]);
+        }
+    }
+    return top_moves;
+}
 
-                if (position.board[m][n] == WHITE_KNIGHT)
-                {
-                    for (int k = 0; k < 8; k++)
-                    {
-                        int k_i = m + knight_move[k][0];
-                        int k_j = n + knight_move[k][1];
-                        if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8)
-                        {
-                            if (Board::under_knight_control(m, n, k_i, k_j) && position.board[k_i][k_j] <= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[k_i][k_j] = WHITE_KNIGHT;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                    EngineMove em;
-                                    em.from_i = m;
-                                    em.from_j = n;
-                                    em.to_i = k_i;
-                                    em.to_j = k_j;
-                                    em.eval = (float)score / 100;
-                                    em.notation = board.generate_move_notation(m, n, k_i, k_j, WHITE);
-                                    em.nodes = paths;
-
-                                    move_list.push_back(em);
-                                }
-                            }
-                        }
-                    }
-                }
+// --- Starts search_root() for side s on a thread, on a copy of the position ---
+void Engine::launch_search(const board_state &position, side s)
+{
+    async_position = position;
+    stop_requested = false;
+    async_running = true;
+    search_thread = thread([this, s]()
+                           {
+                               async_move = search_root(async_position, s);
+                               async_running = false;
+                           });
+}
 
-                if (position.board[m][n] == WHITE_BISHOP)
-                {
-                    for (int k = 0; k < 4; k++)
-                    {
-                        int path_i = m + bishop_direction[k][0];
-                        int path_j = n + bishop_direction[k][1];
-                        while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                        {
-                            if (Board::under_bishop_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] <= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[path_i][path_j] = WHITE_BISHOP;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                    EngineMove em;
-                                    em.from_i = m;
-                                    em.from_j = n;
-                                    em.to_i = path_i;
-                                    em.to_j = path_j;
-                                    em.eval = (float)score / 100;
-                                    em.notation = board.generate_move_notation(m, n, path_i, path_j, WHITE);
-                                    em.nodes = paths;
-
-                                    move_list.push_back(em);
-                                }
-                            }
-                            // if next square is not empty, we stop
-                            if (position.board[path_i][path_j] != 0)
-                            {
-                                break;
-                            }
-                            path_i += bishop_direction[k][0];
-                            path_j += bishop_direction[k][1];
-                        }
-                    }
-                }
+// --- Starts a search for side s on a copy of the position and returns at once ---
+// --- After a ponder hit the running search simply goes on, now within the budget; the
+// --- time it spent pondering counts, so it often stops right away with a deep result ---
+void Engine::search_async(const board_state &position, side s)
+{
+    if (pondering && Position::from_board_state(position, s).key == ponder_key)
+    {
+        pondering = false;
+        return;
+    }
 
-                if (position.board[m][n] == WHITE_ROOK)
-                {
-                    for (int k = 0; k < 4; k++)
-                    {
-                        int path_i = m + rook_direction[k][0];
-                        int path_j = n + rook_direction[k][1];
-                        while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                        {
-                            if (Board::under_rook_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] <= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[path_i][path_j] = WHITE_ROOK;
-                                possible_position.board[m][n] = 0; // recheck logic
-                                if (m == 7 && n == 0)
-                                {
-                                    possible_position.can_castle_white[0] = false;
-                                }
-                                if (m == 7 && n == 7)
-                                {
-                                    possible_position.can_castle_white[1] = false;
-                                }
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                    EngineMove em;
-                                    em.from_i = m;
-                                    em.from_j = n;
-                                    em.to_i = path_i;
-                                    em.to_j = path_j;
-                                    em.eval = (float)score / 100;
-                                    em.notation = board.generate_move_notation(m, n, path_i, path_j, WHITE);
-                                    em.nodes = paths;
-
-                                    move_list.push_back(em);
-                                }
-                            }
-                            // if next square is not empty, we stop
-                            if (position.board[path_i][path_j] != 0)
-                            {
-                                break;
-                            }
-                            path_i += rook_direction[k][0];
-                            path_j += rook_direction[k][1];
-                        }
-                    }
-                }
+    cancel_search();
+    launch_search(position, s);
+}
 
-                if (position.board[m][n] == WHITE_QUEEN)
-                {
-                    for (int k = 0; k < 8; k++)
-                    {
-                        int path_i = m + every_direction[k][0];
-                        int path_j = n + every_direction[k][1];
-                        while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                        {
-                            if (Board::under_queen_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] <= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[path_i][path_j] = WHITE_QUEEN;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                    EngineMove em;
-                                    em.from_i = m;
-                                    em.from_j = n;
-                                    em.to_i = path_i;
-                                    em.to_j = path_j;
-                                    em.eval = (float)score / 100;
-                                    em.notation = board.generate_move_notation(m, n, path_i, path_j, WHITE);
-                                    em.nodes = paths;
-
-                                    move_list.push_back(em);
-                                }
-                            }
-                            // if next square is not empty, we stop
-                            if (position.board[path_i][path_j] != 0)
-                            {
-                                break;
-                            }
-                            path_i += every_direction[k][0];
-                            path_j += every_direction[k][1];
-                        }
-                    }
-                }
+// --- Ponders on the reply to the engine's last move that its search expects ---
+// --- Nothing happens if the table holds no legal move for this position ---
+void Engine::ponder_async(const board_state &position, side s)
+{
+    cancel_search();
+
+    Position pos = Position::from_board_state(position, s);
+    TTEntry entry;
+    if (!tt.probe(pos.key, entry) || entry.move == NO_MOVE)
+    {
+        return;
+    }
+
+    MoveList legal;
+    generate_legal_moves(pos, s, legal);
+    if (find(legal.moves, legal.moves + legal.count, entry.move) == legal.moves + legal.count)
+    {
+        return;
+    }
+
+    Undo undo;
+    board_state expected = position;
+    pos.make_move(entry.move, undo);
+    pos.to_board_state(expected);
+
+    ponder_key = pos.key;
+    pondering = true;
+    launch_search(expected, opposite(s));
+}
+
+// --- True while the engine searches on the opponent's time ---
+bool Engine::is_pondering() const
+{
+    return pondering;
+}
+
+// --- Starts the hint search of get_best_moves() on a copy of the position and returns at once ---
+void Engine::search_hints_async(const board_state &position, side s, int lines)
+{
+    cancel_search();
+
+    async_position = position;
+    stop_requested = false;
+    async_running = true;
+    search_thread = thread([this, s, lines]()
+                           {
+                               async_hints = search_hints(async_position, s, lines);
+                               async_running = false;
+                           });
+}
+
+// --- True while a background search is running ---
+bool Engine::searching() const
+{
+    return async_running;
+}
+
+// --- Progress of the running (or last) search; nodes are counted live ---
+SearchInfo Engine::get_search_info() const
+{
+    lock_guard<mutex> lock(info_mutex);
+    SearchInfo snapshot = info;
+    snapshot.nodes = searched_nodes();
+    return snapshot;
+}
+
+// --- Callback invoked on the search thread after each iteration (empty to disable) ---
+void Engine::set_search_callback(const SearchCallback &on_iteration)
+{
+    lock_guard<mutex> lock(info_mutex);
+    callback = on_iteration;
+}
+
+// --- Ends the running search early; its best move so far becomes the result ---
+void Engine::force_move()
+{
+    stop_requested = true;
+}
+
+// --- Stops the running search and throws its result away ---
+void Engine::cancel_search()
+{
+    stop_requested = true;
+    if (search_thread.joinable())
+    {
+        search_thread.join();
+    }
+    pondering = false;
+}
 
-                if (position.board[m][n] == WHITE_KING)
+// --- Waits for search_async() and writes the position after the engine's move ---
+EngineMove Engine::finish_move(board_state &position)
+{
+    if (search_thread.joinable())
+    {
+        search_thread.join();
+    }
+    position = async_position;
+    return async_move;
+}
+
+// --- Waits for search_hints_async() and returns its moves ---
+std::vector<EngineMove> Engine::finish_hints()
+{
+    if (search_thread.joinable())
+    {
+        search_thread.join();
+    }
+    return async_hints;
+}
+
+// --- Plies a late quiet move is reduced by: grows with the logarithm of both the depth and
+// --- the move's place in the order ---
+static int lmr_reduction(int depth, int move_number)
+{
+    struct ReductionTable
+    {
+        int plies[64][64];
+        ReductionTable()
+        {
+            for (int d = 0; d < 64; d++)
+            {
+                for (int n = 0; n < 64; n++)
                 {
-                    for (int k = 0; k < 8; k++)
-                    {
-                        int k_i = m + every_direction[k][0];
-                        int k_j = n + every_direction[k][1];
-                        if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8)
-                        {
-                            if (Board::under_king_control(m, n, k_i, k_j) && position.board[k_i][k_j] <= 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[k_i][k_j] = WHITE_KING;
-                                possible_position.board[m][n] = 0;
-                                possible_position.can_castle_white[0] = false;
-                                possible_position.can_castle_white[1] = false;
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    int alpha = INT_MIN, beta = INT_MAX;
-                                    int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                                    EngineMove em;
-                                    em.from_i = m;
-                                    em.from_j = n;
-                                    em.to_i = k_i;
-                                    em.to_j = k_j;
-                                    em.eval = (float)score / 100;
-                                    em.notation = board.generate_move_notation(m, n, k_i, k_j, WHITE);
-                                    em.nodes = paths;
-
-                                    move_list.push_back(em);
-                                }
-                            }
-                        }
-                    }
-
-                    // castling kingside
-                    if (m == 7 && n == 4 && position.board[7][5] == 0 && position.board[7][6] == 0 && position.board[7][7] == WHITE_ROOK && !Board::under_control(position.board, 7, 4, BLACK) && !Board::under_control(position.board, 7, 5, BLACK) && !Board::under_control(position.board, 7, 6, BLACK) && position.can_castle_white[1])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[7][6] = WHITE_KING;
-                        possible_position.board[7][4] = 0;
-                        possible_position.board[7][7] = 0;
-                        possible_position.board[7][5] = WHITE_ROOK;
-                        possible_position.can_castle_white[0] = false;
-                        possible_position.can_castle_white[1] = false;
-                        if (!Board::king_is_in_check(possible_position.board, WHITE))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                            EngineMove em;
-                            em.from_i = 7;
-                            em.from_j = 4;
-                            em.to_i = 7;
-                            em.to_j = 6;
-                            em.eval = (float)score / 100;
-                            em.notation = board.generate_move_notation(7, 4, 7, 6, WHITE);
-                            em.nodes = paths;
-
-                            move_list.push_back(em);
-                        }
-                    }
-                    // castling queenside
-                    if (m == 7 && n == 4 && position.board[7][1] == 0 && position.board[7][2] == 0 && position.board[7][3] == 0 && position.board[7][0] == WHITE_ROOK && !Board::under_control(position.board, 7, 2, BLACK) && !Board::under_control(position.board, 7, 3, BLACK) && !Board::under_control(position.board, 7, 4, BLACK) && position.can_castle_white[0])
-                    {
-                        possible_position = Board::copy_position(position);
-                        possible_position.board[7][2] = WHITE_KING;
-                        possible_position.board[7][4] = 0;
-                        possible_position.board[7][0] = 0;
-                        possible_position.board[7][3] = WHITE_ROOK;
-                        possible_position.can_castle_white[0] = false;
-                        possible_position.can_castle_white[1] = false;
-                        if (!Board::king_is_in_check(possible_position.board, WHITE))
-                        {
-                            int alpha = INT_MIN, beta = INT_MAX;
-                            int score = adv_minimax(possible_position, DEPTH - 1, false, alpha, beta);
-
-                            EngineMove em;
-                            em.from_i = 7;
-                            em.from_j = 4;
-                            em.to_i = 7;
-                            em.to_j = 2;
-                            em.eval = (float)score / 100;
-                            em.notation = board.generate_move_notation(7, 4, 7, 2, WHITE);
-                            em.nodes = paths;
-
-                            move_list.push_back(em);
-                        }
-                    }
+                    plies[d][n] = (d > 0 && n > 0) ? (int)(0.5 + std::log((double)d) * std::log((double)n) / 2.5) : 0;
                 }
             }
         }
+    };
+    static const ReductionTable table;
+    return table.plies[min(depth, 63)][min(move_number, 63)];
+}
+
+// --- True if side s has a piece other than pawns and its king; without one, zugzwang is
+// --- common and passing the turn is no proof that a real move would do as well ---
+static bool has_non_pawn_material(const Position &position, side s)
+{
+    return (position.occupancy[s] & ~(position.pieces[s][PAWN] | position.pieces[s][KING])) != 0;
+}
+
+// --- Minimax function with alpha-beta pruning for evaluating board positions ---
+// --- Windows one point wide only prove a bound; wider ones are principal variation (PV)
+// --- nodes, whose exact score matters and which are pruned more carefully ---
+// --- Us is the side to move: White maximizes, Black minimizes, decided at compile time ---
+template <side Us>
+int Engine::adv_minimax(SearchWorker &worker, Position &position, int depth, int ply, int alpha, int beta, bool null_allowed)
+{
+    // --- Budget is checked every 1024 nodes; an aborted search returns a dummy score ---
+    count_node(worker);
+    worker.stats.nodes_by_ply[min(ply, STATS_PLIES - 1)]++;
+    if (stopped)
+    {
+        return 0;
     }
 
-    // --- Sort the output vector by eval descending (best move first) ---
-    std::sort(move_list.begin(), move_list.end(), [](const EngineMove &a, const EngineMove &b)
-              { return a.eval > b.eval; });
+    // --- A stored result that is deep enough either settles this node or not at all ---
+    // --- A shallower one still supplies the move to try first ---
+    TTEntry entry;
+    Move tt_move = NO_MOVE;
+    bool tt_hit = tt.probe(position.key, entry);
+    worker.stats.tt_probes++;
+    if (tt_hit)
+    {
+        tt_move = entry.move;
+        worker.stats.tt_hits++;
+    }
+    if (tt_hit && entry.depth >= depth)
+    {
+        int tt_score = score_from_tt(entry.score, ply);
+        if (entry.bound() == BOUND_EXACT ||
+            (entry.bound() == BOUND_LOWER && tt_score >= beta) ||
+            (entry.bound() == BOUND_UPPER && tt_score <= alpha))
+        {
+            worker.stats.tt_cutoffs++;
+            return tt_score;
+        }
+    }
 
-    // --- Filter top 3 or less moves with reasonable evals ---
-    std::vector<EngineMove> top_moves;
-    for (const auto &move : move_list)
+    // --- Positions the tablebases cover have an exact result and need no search ---
+    if (tablebases.is_enabled() && popcount(position.occupied) <= TB_MAX_PIECES)
     {
-        if (move.eval >= -0.5f) // Filter out very bad moves
+        int wdl;
+        if (tablebases.probe_wdl(position, wdl))
         {
-            top_moves.push_back(move);
-            if (top_moves.size() == 3)
-                break;
+            worker.stats.tb_hits++;
+            int tb_score = to_white(wdl == TB_WIN ? TB_WIN_SCORE - ply : wdl == TB_LOSS ? -(TB_WIN_SCORE - ply) : 0, Us);
+            tt.store(position.key, depth, BOUND_EXACT, score_to_tt(tb_score, ply), NO_MOVE);
+            return tb_score;
         }
     }
 
-    // --- Fallback if not enough good moves ---
-    if (top_moves.empty() && !move_list.empty())
-        top_moves.push_back(move_list.front()); // at least return best move
+    int original_alpha = alpha, original_beta = beta;
+    int score;
+    bool in_check = position.in_check(Us);
+    bool pv_node = beta - alpha > 1;
 
-    paths = 0;
+    // --- Check extension: a side in check is searched a ply deeper, so forcing lines are
+    // --- not cut short at the horizon ---
+    if (in_check)
+    {
+        depth++;
+    }
 
-    return top_moves;
-}
+    // --- Leaves resolve captures first instead of trusting the static eval mid-exchange ---
+    if (depth == 0 || ply >= MAX_PLY - 1)
+    {
+        score = quiescence<Us>(worker, position, ply, alpha, beta);
+        if (!stopped)
+        {
+            tt.store(position.key, 0, score <= original_alpha ? BOUND_UPPER : score >= original_beta ? BOUND_LOWER : BOUND_EXACT, score_to_tt(score, ply), NO_MOVE);
+        }
+        return score;
+    }
 
-// --- Minimax function with alpha-beta pruning for evaluating board positions ---
-int Engine::adv_minimax(board_state &position, int depth, bool maximizingPlayer, int alpha, int beta)
-{
-    paths++;
-    board_state possible_position;
+    // --- Null move pruning: if the side to move still reaches beta (White) or alpha (Black)
+    // --- after passing, a shallower search of the pass is enough to cut the node off ---
+    if (null_allowed && !pv_node && !in_check && depth >= NULL_MOVE_MIN_DEPTH && has_non_pawn_material(position, Us))
+    {
+        int static_eval;
+        {
+            PhaseTimer timer(worker.stats.eval);
+            static_eval = evaluate(worker, position, ply);
+        }
+        if (Us == WHITE ? static_eval >= beta : static_eval <= alpha)
+        {
+            int null_depth = max(0, depth - 1 - NULL_MOVE_REDUCTION - depth / 6);
+            Undo null_undo;
+            position.make_null_move(null_undo);
+            copy_accumulator(worker, ply);
+            int null_alpha = Us == WHITE ? beta - 1 : alpha;
+            int null_score = adv_minimax<opposite(Us)>(worker, position, null_depth, ply + 1, null_alpha, null_alpha + 1, false);
+            position.unmake_null_move(null_undo);
+            if (stopped)
+            {
+                return 0;
+            }
+            // --- The bound itself is returned: a mate found after passing proves nothing ---
+            if (Us == WHITE ? null_score >= beta : null_score <= alpha)
+            {
+                return Us == WHITE ? beta : alpha;
+            }
+        }
+    }
 
-    int score = Evaluation::evaluate(position, depth);
-    if (depth == 0 || game_is_over(position))
+    MoveList moves;
     {
-        return score;
+        PhaseTimer timer(worker.stats.movegen);
+        generate_moves<Us>(position, moves);
     }
 
-    // --- this is maximizer's move (choose best move for white) ---
-    if (maximizingPlayer)
+    int scores[MAX_MOVES];
+    score_moves(position, moves, tt_move, worker.ordering, ply, scores);
+
+    // --- White maximizes, Black minimizes ---
+    Move best_move = NO_MOVE;
+    int legal_moves = 0;
+    score = Us == WHITE ? INT_MIN : INT_MAX;
+    Undo undo;
+    for (int k = 0; k < moves.count; k++)
     {
-        Board::reset_en_passant(position, WHITE);
-        score = INT_MIN;
-        for (int m = 0; m < 8; m++)
+        Move m = pick_move(moves, scores, k);
+        position.make_move(m, undo);
+        if (position.in_check(Us))
+        {
+            position.unmake_move(m, undo);
+            continue;
+        }
+        legal_moves++;
+        update_accumulator(worker, position, m, undo, ply);
+
+        // --- Principal variation search: the first move gets the full window, the others a
+        // --- zero window at the bound they must beat, and a full search only if they do ---
+        int child_score;
+        if (legal_moves == 1)
+        {
+            child_score = adv_minimax<opposite(Us)>(worker, position, depth - 1, ply + 1, alpha, beta);
+        }
+        else
         {
-            for (int n = 0; n < 8; n++)
+            // --- Late move reductions: quiet moves this far down the order rarely matter ---
+            int reduction = 0;
+            if (depth >= LMR_MIN_DEPTH && legal_moves > LMR_FULL_MOVES && !in_check && !is_capture(m) && !is_promotion(m) &&
+                !position.in_check(opposite(Us)))
             {
-                if (position.board[m][n] > 0)
-                {
+                reduction = max(0, min(depth - 2, lmr_reduction(depth, legal_moves) - (pv_node ? 1 : 0)));
+            }
 
-                    if (position.board[m][n] == WHITE_PAWN)
-                    {
-                        // one move forward by pawn
-                        if (position.board[m - 1][n] == 0)
-                        {
-                            // if not move to last rank
-                            if (m - 1 != 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m - 1][n] = WHITE_PAWN;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                    alpha = max(alpha, score);
-                                    if (beta <= alpha)
-                                        break;
-                                }
-                            }
-                            // if moves last rank, then promote to all pieces
-                            else
-                            {
-                                // variable i is possible pieces from white knight to queen
-                                for (char i = 2; i <= 5; i++)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[m - 1][n] = i;
-                                    possible_position.board[m][n] = 0;
-
-                                    if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                    {
-                                        score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                        alpha = max(alpha, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                            }
-                        }
-                        // two moves from starting position by pawn
-                        if (m == 6 && position.board[m - 1][n] == 0 && position.board[m - 2][n] == 0)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m - 2][n] = WHITE_PAWN;
-                            possible_position.board[m][n] = 0;
-
-                            possible_position.pawn_two_squares_white[n] = true;
-
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                alpha = max(alpha, score);
-                                if (beta <= alpha)
-                                    break;
-                            }
-                        }
-                        // capture to the left
-                        if (n != 0 && position.board[m - 1][n - 1] < 0)
-                        {
-                            // not to last rank
-                            if (m - 1 != 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m - 1][n - 1] = WHITE_PAWN;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                    alpha = max(alpha, score);
-                                    if (beta <= alpha)
-                                        break;
-                                }
-                            }
-                            else
-                            {
-                                // variable i is possible pieces from white knight to queen
-                                for (char i = 2; i <= 5; i++)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[m - 1][n - 1] = i;
-                                    possible_position.board[m][n] = 0;
-
-                                    if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                    {
-                                        score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                        alpha = max(alpha, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                            }
-                        }
-                        // capture to the right
-                        if (n != 7 && position.board[m - 1][n + 1] < 0)
-                        {
-                            // not last rank
-                            if (m - 1 != 0)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m - 1][n + 1] = WHITE_PAWN;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                {
-                                    score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                    alpha = max(alpha, score);
-                                    if (beta <= alpha)
-                                        break;
-                                }
-                            }
-                            // last rank (promote)
-                            else
-                            {
-                                // variable i is possible pieces from white knight to queen
-                                for (char i = 2; i <= 5; i++)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[m - 1][n + 1] = i;
-                                    possible_position.board[m][n] = 0;
-
-                                    if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                    {
-                                        score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                        alpha = max(alpha, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                            }
-                        }
-
-                        // en passant to the right
-                        if (n != 7 && position.board[m][n + 1] == -1 && position.pawn_two_squares_black[n + 1])
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m - 1][n + 1] = WHITE_PAWN;
-                            possible_position.board[m][n] = 0;
-                            possible_position.board[m][n + 1] = 0;
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                alpha = max(alpha, score);
-                                if (beta <= alpha)
-                                    break;
-                            }
-                        }
-
-                        // en passant to the left
-                        if (n != 0 && position.board[m][n - 1] == -1 && position.pawn_two_squares_black[n - 1])
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m - 1][n - 1] = WHITE_PAWN;
-                            possible_position.board[m][n] = 0;
-                            possible_position.board[m][n - 1] = 0;
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                alpha = max(alpha, score);
-                                if (beta <= alpha)
-                                    break;
-                            }
-                        }
-                    }
-
-                    if (position.board[m][n] == WHITE_KNIGHT)
-                    {
-                        for (int k = 0; k < 8; k++)
-                        {
-                            int k_i = m + knight_move[k][0];
-                            int k_j = n + knight_move[k][1];
-                            if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8)
-                            {
-                                if (Board::under_knight_control(m, n, k_i, k_j) && position.board[k_i][k_j] <= 0)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[k_i][k_j] = WHITE_KNIGHT;
-                                    possible_position.board[m][n] = 0;
-                                    if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                    {
-                                        score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                        alpha = max(alpha, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    if (position.board[m][n] == WHITE_BISHOP)
-                    {
-                        for (int k = 0; k < 4; k++)
-                        {
-                            int path_i = m + bishop_direction[k][0];
-                            int path_j = n + bishop_direction[k][1];
-                            while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                            {
-                                if (Board::under_bishop_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] <= 0)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[path_i][path_j] = WHITE_BISHOP;
-                                    possible_position.board[m][n] = 0;
-                                    if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                    {
-                                        score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                        alpha = max(alpha, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                                // if next square is not empty, we stop
-                                if (position.board[path_i][path_j] != 0)
-                                {
-                                    break;
-                                }
-                                path_i += bishop_direction[k][0];
-                                path_j += bishop_direction[k][1];
-                            }
-                        }
-                    }
-
-                    if (position.board[m][n] == WHITE_ROOK)
-                    {
-                        for (int k = 0; k < 4; k++)
-                        {
-                            int path_i = m + rook_direction[k][0];
-                            int path_j = n + rook_direction[k][1];
-                            while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                            {
-                                if (Board::under_rook_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] <= 0)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[path_i][path_j] = WHITE_ROOK;
-                                    possible_position.board[m][n] = 0;
-                                    if (m == 7 && n == 0)
-                                    {
-                                        possible_position.can_castle_white[0] = false;
-                                    }
-                                    if (m == 7 && n == 7)
-                                    {
-                                        possible_position.can_castle_white[1] = false;
-                                    }
-                                    if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                    {
-                                        score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                        alpha = max(alpha, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                                // if next square is not empty, we stop
-                                if (position.board[path_i][path_j] != 0)
-                                {
-                                    break;
-                                }
-                                path_i += rook_direction[k][0];
-                                path_j += rook_direction[k][1];
-                            }
-                        }
-                    }
-
-                    if (position.board[m][n] == WHITE_QUEEN)
-                    {
-                        for (int k = 0; k < 8; k++)
-                        {
-                            int path_i = m + every_direction[k][0];
-                            int path_j = n + every_direction[k][1];
-                            while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                            {
-                                if (Board::under_queen_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] <= 0)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[path_i][path_j] = WHITE_QUEEN;
-                                    possible_position.board[m][n] = 0;
-                                    if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                    {
-                                        score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                        alpha = max(alpha, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                                // if next square is not empty, we stop
-                                if (position.board[path_i][path_j] != 0)
-                                {
-                                    break;
-                                }
-                                path_i += every_direction[k][0];
-                                path_j += every_direction[k][1];
-                            }
-                        }
-                    }
-
-                    if (position.board[m][n] == WHITE_KING)
-                    {
-                        for (int k = 0; k < 8; k++)
-                        {
-                            int k_i = m + every_direction[k][0];
-                            int k_j = n + every_direction[k][1];
-                            if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8)
-                            {
-                                if (Board::under_king_control(m, n, k_i, k_j) && position.board[k_i][k_j] <= 0)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[k_i][k_j] = WHITE_KING;
-                                    possible_position.board[m][n] = 0;
-                                    possible_position.can_castle_white[0] = false;
-                                    possible_position.can_castle_white[1] = false;
-                                    if (!Board::king_is_in_check(possible_position.board, WHITE))
-                                    {
-                                        score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                        alpha = max(alpha, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                            }
-                        }
-                        // castling kingside
-                        if (m == 7 && n == 4 && position.board[7][5] == 0 && position.board[7][6] == 0 && position.board[7][7] == WHITE_ROOK && !Board::under_control(position.board, 7, 4, BLACK) && !Board::under_control(position.board, 7, 5, BLACK) && !Board::under_control(position.board, 7, 6, BLACK) && position.can_castle_white[1])
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[7][6] = WHITE_KING;
-                            possible_position.board[7][4] = 0;
-                            possible_position.board[7][7] = 0;
-                            possible_position.board[7][5] = WHITE_ROOK;
-                            possible_position.can_castle_white[0] = false;
-                            possible_position.can_castle_white[1] = false;
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                alpha = max(alpha, score);
-                                if (beta <= alpha)
-                                    break;
-                            }
-                        }
-                        // castling queenside
-                        if (m == 7 && n == 4 && position.board[7][1] == 0 && position.board[7][2] == 0 && position.board[7][3] == 0 && position.board[7][0] == WHITE_ROOK && !Board::under_control(position.board, 7, 1, BLACK) && !Board::under_control(position.board, 7, 2, BLACK) && !Board::under_control(position.board, 7, 3, BLACK) && position.can_castle_white[0])
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[7][2] = WHITE_KING;
-                            possible_position.board[7][4] = 0;
-                            possible_position.board[7][0] = 0;
-                            possible_position.board[7][3] = WHITE_ROOK;
-                            possible_position.can_castle_white[0] = false;
-                            possible_position.can_castle_white[1] = false;
-                            if (!Board::king_is_in_check(possible_position.board, WHITE))
-                            {
-                                score = max(score, adv_minimax(possible_position, depth - 1, false, alpha, beta));
-                                alpha = max(alpha, score);
-                                if (beta <= alpha)
-                                    break;
-                            }
-                        }
-                    }
-                }
+            int zero_alpha = Us == WHITE ? alpha : beta - 1;
+            child_score = adv_minimax<opposite(Us)>(worker, position, depth - 1 - reduction, ply + 1, zero_alpha, zero_alpha + 1);
+            bool improves = Us == WHITE ? child_score > alpha : child_score < beta;
+            if (improves && reduction > 0 && !stopped)
+            {
+                child_score = adv_minimax<opposite(Us)>(worker, position, depth - 1, ply + 1, zero_alpha, zero_alpha + 1);
+            }
+            if (child_score > alpha && child_score < beta && !stopped)
+            {
+                child_score = adv_minimax<opposite(Us)>(worker, position, depth - 1, ply + 1, alpha, beta);
             }
         }
+        position.unmake_move(m, undo);
+
+        // --- Scores of an aborted search are meaningless and must not reach the table ---
+        if (stopped)
+        {
+            return 0;
+        }
+
+        if (Us == WHITE ? (child_score > score) : (child_score < score))
+        {
+            score = child_score;
+            best_move = m;
+        }
+        if (Us == WHITE)
+            alpha = max(alpha, score);
+        else
+            beta = min(beta, score);
+
+        // --- Quiet moves that cause a cutoff feed the killer and history tables ---
+        if (beta <= alpha)
+        {
+            if (!is_capture(m))
+            {
+                worker.ordering.update(Us, m, depth, ply);
+            }
+            worker.stats.fail_highs++;
+            if (legal_moves == 1)
+            {
+                worker.stats.fail_highs_first++;
+            }
+            break;
+        }
+    }
+
+    // --- No legal move: checkmate if in check, stalemate otherwise ---
+    if (legal_moves == 0)
+    {
+        score = in_check ? mated_score(Us, ply) : 0;
+        tt.store(position.key, depth, BOUND_EXACT, score_to_tt(score, ply), NO_MOVE);
         return score;
     }
-    // --- this is the minimizer's move (choose best move for black) ---
-    else
+
+    // --- Scores outside the original window are only bounds ---
+    bound_type bound = BOUND_EXACT;
+    if (score <= original_alpha)
+        bound = BOUND_UPPER;
+    else if (score >= original_beta)
+        bound = BOUND_LOWER;
+    tt.store(position.key, depth, bound, score_to_tt(score, ply), best_move);
+
+    return score;
+}
+
+// --- The accumulator is only kept while a network is open ---
+void Engine::update_accumulator(SearchWorker &worker, const Position &position, Move m, const Undo &undo, int ply)
+{
+    if (network.is_open())
+    {
+        network.update(worker.accumulators[ply], worker.accumulators[ply + 1], position, m, undo.captured);
+    }
+}
+
+void Engine::copy_accumulator(SearchWorker &worker, int ply)
+{
+    if (network.is_open())
+    {
+        worker.accumulators[ply + 1] = worker.accumulators[ply];
+    }
+}
+
+int Engine::evaluate(SearchWorker &worker, const Position &position, int ply)
+{
+    if (network.is_open())
+    {
+        return network.evaluate(position, worker.accumulators[ply]);
+    }
+    return Evaluation::evaluate(position, &worker.pawns);
+}
+
+// --- Material values used for delta pruning, in centipawns as in Evaluation ---
+static const int PIECE_VALUE[6] = {100, 320, 330, 500, 900, 0};
+
+// --- A capture that cannot lift the score to the window even with this margin is skipped ---
+static const int DELTA_MARGIN = 200;
+
+// --- Capture-only search at the leaves so exchanges are resolved before evaluating ---
+// --- The side to move may "stand pat" on the static eval instead of capturing ---
+template <side Us>
+int Engine::quiescence(SearchWorker &worker, Position &position, int ply, int alpha, int beta)
+{
+    count_node(worker);
+    worker.stats.qnodes++;
+    worker.stats.nodes_by_ply[min(ply, STATS_PLIES - 1)]++;
+    if (stopped)
+    {
+        return 0;
+    }
+
+    int stand_pat;
+    {
+        PhaseTimer timer(worker.stats.eval);
+        stand_pat = evaluate(worker, position, ply);
+    }
+
+    bool in_check = position.in_check(Us);
+
+    if (ply >= MAX_PLY - 1)
+    {
+        return stand_pat;
+    }
+
+    // --- Stand pat: the side to move is assumed to have a move at least as good as doing nothing ---
+    // --- Not allowed in check, where every evasion is searched instead ---
+    int score = Us == WHITE ? INT_MIN : INT_MAX;
+    if (!in_check)
     {
-        Board::reset_en_passant(position, BLACK);
-        score = INT_MAX;
-        for (int m = 0; m < 8; m++)
+        score = stand_pat;
+        if (Us == WHITE)
         {
-            for (int n = 0; n < 8; n++)
-            {
-                if (position.board[m][n] < 0)
-                {
+            if (stand_pat >= beta)
+                return stand_pat;
+            alpha = max(alpha, stand_pat);
+        }
+        else
+        {
+            if (stand_pat <= alpha)
+                return stand_pat;
+            beta = min(beta, stand_pat);
+        }
+    }
 
-                    if (position.board[m][n] == BLACK_PAWN)
-                    {
-                        // one move forward by pawn
-                        if (position.board[m + 1][n] == 0)
-                        {
-                            // if not moving to last rank
-                            if (m + 1 != 7)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m + 1][n] = BLACK_PAWN;
-                                possible_position.board[m][n] = 0;
-
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                    beta = min(beta, score);
-                                    if (beta <= alpha)
-                                        break;
-                                }
-                            }
-                            // if moves last rank, then promote to all pieces
-                            else
-                            {
-                                // variable i is possible pieces from black knight to queen
-                                for (char i = -5; i <= -2; i++)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[m + 1][n] = i;
-                                    possible_position.board[m][n] = 0;
-
-                                    if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                    {
-                                        score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                        beta = min(beta, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                            }
-                        }
-                        // two moves from starting position by pawn
-                        if (m == 1 && position.board[m + 1][n] == 0 && position.board[m + 2][n] == 0)
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m + 2][n] = BLACK_PAWN;
-                            possible_position.board[m][n] = 0;
-
-                            possible_position.pawn_two_squares_black[n] = true;
-
-                            if (!Board::king_is_in_check(possible_position.board, BLACK))
-                            {
-                                score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                beta = min(beta, score);
-                                if (beta <= alpha)
-                                    break;
-                            }
-                        }
-                        // capture to the left
-                        if (n != 0 && position.board[m + 1][n - 1] > 0)
-                        {
-                            if (m + 1 != 7)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m + 1][n - 1] = BLACK_PAWN;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                    beta = min(beta, score);
-                                    if (beta <= alpha)
-                                        break;
-                                }
-                            }
-                            // if moves last rank, then promote to all pieces
-                            else
-                            {
-                                // variable i is possible pieces from black knight to queen
-                                for (char i = -5; i <= -2; i++)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[m + 1][n - 1] = i;
-                                    possible_position.board[m][n] = 0;
-
-                                    if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                    {
-                                        score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                        beta = min(beta, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                            }
-                        }
-                        // capture to the right
-                        if (n != 7 && position.board[m + 1][n + 1] > 0)
-                        {
-                            if (m + 1 != 7)
-                            {
-                                possible_position = Board::copy_position(position);
-                                possible_position.board[m + 1][n + 1] = BLACK_PAWN;
-                                possible_position.board[m][n] = 0;
-                                if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                {
-                                    score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                    beta = min(beta, score);
-                                    if (beta <= alpha)
-                                        break;
-                                }
-                            }
-                            // if moves last rank, then promote to all pieces
-                            else
-                            {
-                                // variable i is possible pieces from black knight to queen
-                                for (char i = -5; i <= -2; i++)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[m + 1][n + 1] = i;
-                                    possible_position.board[m][n] = 0;
-
-                                    if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                    {
-                                        score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                        beta = min(beta, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                            }
-                        }
-
-                        // en passant to the right
-                        if (n != 7 && position.board[m][n + 1] == 1 && position.pawn_two_squares_white[n + 1])
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m + 1][n + 1] = BLACK_PAWN;
-                            possible_position.board[m][n] = 0;
-                            possible_position.board[m][n + 1] = 0;
-                            if (!Board::king_is_in_check(possible_position.board, BLACK))
-                            {
-                                score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                beta = min(beta, score);
-                                if (beta <= alpha)
-                                    break;
-                            }
-                        }
-
-                        // en passant to the left
-                        if (n != 0 && position.board[m][n - 1] == 1 && position.pawn_two_squares_white[n - 1])
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[m + 1][n - 1] = BLACK_PAWN;
-                            possible_position.board[m][n] = 0;
-                            possible_position.board[m][n - 1] = 0;
-                            if (!Board::king_is_in_check(possible_position.board, BLACK))
-                            {
-                                score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                beta = min(beta, score);
-                                if (beta <= alpha)
-                                    break;
-                            }
-                        }
-                    }
-
-                    if (position.board[m][n] == BLACK_KNIGHT)
-                    {
-                        for (int k = 0; k < 8; k++)
-                        {
-                            int k_i = m + knight_move[k][0];
-                            int k_j = n + knight_move[k][1];
-                            if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8)
-                            {
-                                if (Board::under_knight_control(m, n, k_i, k_j) && position.board[k_i][k_j] >= 0)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[k_i][k_j] = BLACK_KNIGHT;
-                                    possible_position.board[m][n] = 0;
-                                    if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                    {
-                                        score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                        beta = min(beta, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    if (position.board[m][n] == BLACK_BISHOP)
-                    {
-                        for (int k = 0; k < 4; k++)
-                        {
-                            int path_i = m + bishop_direction[k][0];
-                            int path_j = n + bishop_direction[k][1];
-                            while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                            {
-                                if (Board::under_bishop_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] >= 0)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[path_i][path_j] = BLACK_BISHOP;
-                                    possible_position.board[m][n] = 0;
-                                    if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                    {
-                                        score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                        beta = min(beta, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                                // if next square is not empty, we stop
-                                if (position.board[path_i][path_j] != 0)
-                                {
-                                    break;
-                                }
-                                path_i += bishop_direction[k][0];
-                                path_j += bishop_direction[k][1];
-                            }
-                        }
-                    }
-
-                    if (position.board[m][n] == BLACK_ROOK)
-                    {
-                        for (int k = 0; k < 4; k++)
-                        {
-                            int path_i = m + rook_direction[k][0];
-                            int path_j = n + rook_direction[k][1];
-                            while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                            {
-                                if (Board::under_rook_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] >= 0)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[path_i][path_j] = BLACK_ROOK;
-                                    possible_position.board[m][n] = 0;
-                                    if (m == 0 && n == 0)
-                                    {
-                                        possible_position.can_castle_black[0] = false;
-                                    }
-                                    if (m == 0 && n == 7)
-                                    {
-                                        possible_position.can_castle_black[1] = false;
-                                    }
-                                    if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                    {
-                                        score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                        beta = min(beta, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                                // if next square is not empty, we stop
-                                if (position.board[path_i][path_j] != 0)
-                                {
-                                    break;
-                                }
-                                path_i += rook_direction[k][0];
-                                path_j += rook_direction[k][1];
-                            }
-                        }
-                    }
-
-                    if (position.board[m][n] == BLACK_QUEEN)
-                    {
-                        for (int k = 0; k < 8; k++)
-                        {
-                            int path_i = m + every_direction[k][0];
-                            int path_j = n + every_direction[k][1];
-                            while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                            {
-                                if (Board::under_queen_control(position.board, m, n, path_i, path_j) && position.board[path_i][path_j] >= 0)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[path_i][path_j] = BLACK_QUEEN;
-                                    possible_position.board[m][n] = 0;
-                                    if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                    {
-                                        score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                        beta = min(beta, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                                // if next square is not empty, we stop
-                                if (position.board[path_i][path_j] != 0)
-                                {
-                                    break;
-                                }
-                                path_i += every_direction[k][0];
-                                path_j += every_direction[k][1];
-                            }
-                        }
-                    }
-
-                    if (position.board[m][n] == BLACK_KING)
-                    {
-                        for (int k = 0; k < 8; k++)
-                        {
-                            int k_i = m + every_direction[k][0];
-                            int k_j = n + every_direction[k][1];
-                            if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8)
-                            {
-                                if (Board::under_king_control(m, n, k_i, k_j) && position.board[k_i][k_j] >= 0)
-                                {
-                                    possible_position = Board::copy_position(position);
-                                    possible_position.board[k_i][k_j] = BLACK_KING;
-                                    possible_position.board[m][n] = 0;
-                                    possible_position.can_castle_black[0] = false;
-                                    possible_position.can_castle_black[1] = false;
-                                    if (!Board::king_is_in_check(possible_position.board, BLACK))
-                                    {
-                                        score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                        beta = min(beta, score);
-                                        if (beta <= alpha)
-                                            break;
-                                    }
-                                }
-                            }
-                        }
-                        // castling kingside
-                        if (m == 0 && n == 4 && position.board[0][5] == 0 && position.board[0][6] == 0 && position.board[0][7] == BLACK_ROOK && !Board::under_control(position.board, 0, 4, WHITE) && !Board::under_control(position.board, 0, 5, WHITE) && !Board::under_control(position.board, 0, 6, WHITE) && position.can_castle_black[1])
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[0][6] = BLACK_KING;
-                            possible_position.board[0][4] = 0;
-                            possible_position.board[0][7] = 0;
-                            possible_position.board[0][5] = BLACK_ROOK;
-                            possible_position.can_castle_black[0] = false;
-                            possible_position.can_castle_black[1] = false;
-                            if (!Board::king_is_in_check(possible_position.board, BLACK))
-                            {
-                                score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                beta = min(beta, score);
-                                if (beta <= alpha)
-                                    break;
-                            }
-                        }
-                        // castling queenside
-                        if (m == 0 && n == 4 && position.board[0][1] == 0 && position.board[0][2] == 0 && position.board[0][3] == 0 && position.board[0][0] == BLACK_ROOK && !Board::under_control(position.board, 0, 2, WHITE) && !Board::under_control(position.board, 0, 3, WHITE) && !Board::under_control(position.board, 0, 4, WHITE) && position.can_castle_black[0])
-                        {
-                            possible_position = Board::copy_position(position);
-                            possible_position.board[0][2] = BLACK_KING;
-                            possible_position.board[0][4] = 0;
-                            possible_position.board[0][0] = 0;
-                            possible_position.board[0][3] = BLACK_ROOK;
-                            possible_position.can_castle_black[0] = false;
-                            possible_position.can_castle_black[1] = false;
-                            if (!Board::king_is_in_check(possible_position.board, BLACK))
-                            {
-                                score = min(score, adv_minimax(possible_position, depth - 1, true, alpha, beta));
-                                beta = min(beta, score);
-                                if (beta <= alpha)
-                                    break;
-                            }
-                        }
-                    }
-                }
+    MoveList moves;
+    {
+        PhaseTimer timer(worker.stats.movegen);
+        if (in_check)
+            generate_moves<Us>(position, moves);
+        else
+            generate_captures<Us>(position, moves);
+    }
+
+    int scores[MAX_MOVES];
+    score_moves(position, moves, NO_MOVE, worker.ordering, ply, scores);
+
+    int legal_moves = 0;
+    Undo undo;
+    for (int k = 0; k < moves.count; k++)
+    {
+        Move m = pick_move(moves, scores, k);
+
+        // --- Delta pruning: even winning the victim outright would not reach the window ---
+        if (!in_check && !is_promotion(m))
+        {
+            int victim = (move_flag(m) == EN_PASSANT_CAPTURE) ? PAWN : type_of(position.piece_on(move_to(m)));
+            int gain = PIECE_VALUE[victim] + DELTA_MARGIN;
+            if (Us == WHITE ? (stand_pat + gain <= alpha) : (stand_pat - gain >= beta))
+            {
+                continue;
             }
         }
-        return score;
+
+        position.make_move(m, undo);
+        if (position.in_check(Us))
+        {
+            position.unmake_move(m, undo);
+            continue;
+        }
+        legal_moves++;
+        update_accumulator(worker, position, m, undo, ply);
+
+        int child_score = quiescence<opposite(Us)>(worker, position, ply + 1, alpha, beta);
+        position.unmake_move(m, undo);
+
+        if (stopped)
+        {
+            return 0;
+        }
+
+        if (Us == WHITE)
+        {
+            score = max(score, child_score);
+            alpha = max(alpha, score);
+        }
+        else
+        {
+            score = min(score, child_score);
+            beta = min(beta, score);
+        }
+        if (beta <= alpha)
+            break;
+    }
+
+    // --- In check with no evasion is mate; without check, quiet moves were not tried ---
+    if (in_check && legal_moves == 0)
+    {
+        return mated_score(Us, ply);
     }
+    return score;
 }
 
 // --- Checks if the game is over due to checkmate or stalemate ---
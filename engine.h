@@ -2,10 +2,139 @@
 // engine.h
 // --- Declares the Engine class that controls the AI logic for chess moves.
 // --- Includes move evaluation, search (minimax + alpha-beta), and best move generation.
+// --- Searches deepen one ply at a time until the time or node budget runs out.
+// --- The root search keeps the best K lines (MultiPV, K = 1 for a normal move) using
+// --- aspiration windows and principal variation search.
+// --- Below the root the same zero-window search is used, with null move pruning, late move
+// --- reductions and check extensions to spend the nodes on the lines that matter.
+// --- With more than one thread the search runs "Lazy SMP": helper threads search the
+// --- same root at the same time and share results only through the transposition table.
+// --- Searches can also run in the background: the caller polls for progress (or gets a
+// --- callback per iteration), can force a move or cancel, and collects the result.
+// --- While the opponent thinks, the engine can ponder on the reply it expects.
+// --- With an opening book set, book positions are answered without any search.
+// --- With endgame tablebases set, won and lost endgames they cover are played straight
+// --- from the tables, and the search stops at any position they cover.
+// --- With a network file set (nnue.h), leaves are scored by the network instead of the
+// --- hand-written evaluation; each thread keeps an accumulator per ply in step with its moves.
+// --- Every search also gathers statistics (SearchStats) for tuning the search.
 // --------------------------------------------------------------------------------------
 
+#ifndef ENGINE_H
+#define ENGINE_H
+
 #include "evaluation.h"
+#include "movegen.h"
+#include "transposition.h"
+#include "moveorder.h"
+#include "book.h"
+#include "tablebase.h"
+#include "nnue.h"
 #include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+
+// --- Transposition table size used when none is given to the constructor ---
+const int DEFAULT_HASH_MB = 16;
+
+// --- Upper bound on search threads ---
+const int MAX_THREADS = 256;
+
+// --- Search budget defaults ---
+const int MAX_SEARCH_DEPTH = 64;       // --- Deepest iteration the search will start ---
+const int DEFAULT_MOVE_TIME_MS = 2000; // --- Thinking time per move ---
+
+// --- Mate scores: a side mated at distance ply from the root scores -(MATE_VALUE - ply) ---
+const int MATE_VALUE = 100000 + MAX_PLY;
+const int MATE_BOUND = 100000; // --- Any score beyond this (in absolute value) is a mate score ---
+const int INFINITE_SCORE = MATE_VALUE + 1; // --- Bound of the widest search window ---
+
+// --- A tablebase win ply plies from the root scores TB_WIN_SCORE - ply: below any mate,
+// --- above any evaluation ---
+const int TB_WIN_SCORE = MATE_BOUND - 1000;
+const int TB_WIN_BOUND = TB_WIN_SCORE - MAX_PLY; // --- Any score beyond this is a tablebase win or a mate ---
+
+// --- Aspiration windows: from this depth on, a root line is first searched within this
+// --- many centipawns of its previous score; the window doubles each time it fails ---
+const int ASPIRATION_MIN_DEPTH = 4;
+const int ASPIRATION_WINDOW = 25;
+
+// --- Null move pruning: from this depth on, a side whose static eval already beats the
+// --- window passes the turn, searched NULL_MOVE_REDUCTION + depth / 6 plies shallower ---
+const int NULL_MOVE_MIN_DEPTH = 3;
+const int NULL_MOVE_REDUCTION = 2;
+
+// --- Late move reductions: from this depth on, quiet moves after the first LMR_FULL_MOVES
+// --- legal ones are searched shallower first, the more so the later and deeper they are ---
+const int LMR_MIN_DEPTH = 3;
+const int LMR_FULL_MOVES = 3;
+
+// --- Hints: number of lines searched, and the worst score (for the side to move, in
+// --- pawns) a hint other than the best may have ---
+const int HINT_LINES = 3;
+const float HINT_MIN_EVAL = -0.5f;
+
+// --- Limits for one search; zero time or nodes means "no limit" ---
+// --- The first iteration always completes, so a move is found even on tiny budgets ---
+struct SearchLimits
+{
+    int depth = MAX_SEARCH_DEPTH;       // --- Maximum iteration depth ---
+    int time_ms = DEFAULT_MOVE_TIME_MS; // --- Wall-clock budget in milliseconds ---
+    long nodes = 0;                     // --- Node budget ---
+};
+
+// --- Plies tracked separately in SearchStats::nodes_by_ply; deeper nodes share the last slot ---
+const int STATS_PLIES = 32;
+
+// --- Time spent in one part of the search. Reading the clock around every call would cost
+// --- more than the calls themselves, so one call in TIMING_SAMPLE is timed and the total
+// --- is extrapolated from those ---
+const int TIMING_SAMPLE = 64;
+
+struct PhaseClock
+{
+    long calls = 0;       // --- All calls ---
+    long timed_calls = 0; // --- Calls that were timed ---
+    long timed_ns = 0;    // --- Nanoseconds spent in the timed calls ---
+
+    // --- Estimated milliseconds spent in all calls ---
+    double estimated_ms() const { return timed_calls > 0 ? (double)timed_ns * calls / timed_calls / 1e6 : 0; }
+};
+
+// --- Statistics of one search, summed over all search threads ---
+struct SearchStats
+{
+    long nodes = 0;                       // --- All nodes, quiescence included ---
+    long qnodes = 0;                      // --- Quiescence nodes ---
+    long nodes_by_ply[STATS_PLIES] = {};  // --- All nodes by distance from the root ---
+    long fail_highs = 0;                  // --- Main-search nodes that ended in a beta cutoff ---
+    long fail_highs_first = 0;            // --- ... of those, cut off by the first legal move ---
+    long tt_probes = 0;                   // --- Table lookups in the main search ---
+    long tt_hits = 0;                     // --- ... that found the position ---
+    long tt_cutoffs = 0;                  // --- ... whose stored score settled the node ---
+    long tb_hits = 0;                     // --- Nodes settled by a tablebase probe ---
+    int depth = 0;                        // --- Deepest completed iteration ---
+    double branching_factor = 0;          // --- Nodes of the last iteration over the one before ---
+    int time_ms = 0;                      // --- Wall-clock time of the whole search ---
+    PhaseClock movegen;                   // --- Move generation ---
+    PhaseClock eval;                      // --- Static evaluation ---
+
+    // --- Ratios in [0, 1]; 0 when nothing was counted ---
+    double fail_high_first_rate() const { return fail_highs > 0 ? (double)fail_highs_first / fail_highs : 0; }
+    double tt_hit_rate() const { return tt_probes > 0 ? (double)tt_hits / tt_probes : 0; }
+
+    // --- Remaining time: searching, ordering and making moves, summed over threads ---
+    double search_ms(int threads) const { return std::max(0.0, (double)time_ms * threads - movegen.estimated_ms() - eval.estimated_ms()); }
+
+    // --- Adds the counters of another thread ---
+    void add(const SearchStats &other);
+};
 
 // --- Structure to represent a move chosen by the engine ---
 struct EngineMove {
@@ -14,15 +143,185 @@ struct EngineMove {
     int to_i, to_j;         // --- Destination square (row, column) ---
     float eval = 0;         // --- Evaluation score for the move ---
     int nodes = 0;          // --- Number of nodes evaluated to make this move ---
+    Move move = NO_MOVE;    // --- The move in the encoding of move.h ---
+    SearchStats stats;      // --- Statistics of the search that chose this move ---
+    std::vector<Move> pv;   // --- Principal variation starting with this move ---
+};
+
+// --- Progress of a background search, updated after every completed iteration ---
+struct SearchInfo
+{
+    int depth = 0;          // --- Last completed iteration (0 while the first one runs) ---
+    float eval = 0;         // --- Score of the best move so far, from White's point of view ---
+    long nodes = 0;         // --- Nodes searched so far by all threads ---
+    int time_ms = 0;        // --- Milliseconds since the search started ---
+    std::string best_move;  // --- Notation of the best move so far ---
+    std::vector<Move> pv;   // --- Principal variation (best move first), followed through the table ---
+};
+
+// --- Called on the search thread after every completed iteration ---
+typedef std::function<void(const SearchInfo &)> SearchCallback;
+
+// --- State owned by one search thread ---
+struct SearchWorker
+{
+    int id;                   // --- 0 is the main thread, whose result is played ---
+    OrderingTables ordering;  // --- Killer and history tables, never shared between threads ---
+    PawnTable pawns;          // --- Pawn structure cache used by this thread's evaluations ---
+    SearchStats stats;        // --- This thread's counters for the current search ---
+    std::atomic<long> nodes;  // --- Nodes searched in the current search (written by this thread only) ---
+    Accumulator accumulators[MAX_PLY + 1]; // --- Network accumulator of the position at each ply ---
+
+    explicit SearchWorker(int worker_id) : id(worker_id), nodes(0) { ordering.clear(); }
 };
 
 class Engine
 {
 private:
-    const int DEPTH = 4;    // --- Search depth for the minimax algorithm ---
+    TranspositionTable tt;  // --- Results shared between transposed positions and threads ---
+    SearchLimits limits;    // --- Budget applied to every search ---
+    OpeningBook book;       // --- Consulted before every move search, if open ---
+    std::mt19937 book_rng;  // --- Picks among the book moves of a position ---
+    Tablebases tablebases;  // --- Endgame tables, probed at the root and in the search ---
+    Network network;        // --- Leaf evaluation when open, else Evaluation::evaluate ---
+
+    // --- Worker 0 runs on the calling thread, the others on helper threads ---
+    std::vector<std::unique_ptr<SearchWorker> > workers;
+    std::vector<std::thread> helpers;
+
+    // --- State of the running search ---
+    std::chrono::steady_clock::time_point search_start;
+    std::atomic<bool> stopped; // --- Set once the budget is spent; the iteration is discarded ---
+    bool can_stop;             // --- False until the main thread has completed its first iteration ---
+    std::atomic<bool> stop_requested; // --- Set from outside to end the search early (force move) ---
+    std::atomic<bool> pondering;      // --- Ignore the budget: searching on the opponent's time ---
+    uint64_t ponder_key;              // --- Key of the position the ponder search works on ---
+
+    // --- Background search started by search_async() or search_hints_async() ---
+    std::thread search_thread;
+    std::atomic<bool> async_running;
+    board_state async_position;              // --- Searched copy; holds the position after the move when done ---
+    EngineMove async_move;                   // --- Result of search_async() ---
+    std::vector<EngineMove> async_hints;     // --- Result of search_hints_async() ---
+
+    // --- Latest progress, shared between the search thread and pollers ---
+    mutable std::mutex info_mutex;
+    SearchInfo info;
+    SearchCallback callback;
+
+    // --- Resets the clock, stop flags and node counters at the start of a search ---
+    void start_search();
+
+    // --- Milliseconds since start_search() ---
+    int elapsed_ms() const;
+
+    // --- Sets stopped when the time or node budget has run out (main thread only) ---
+    void check_limits();
+
+    // --- Starts search_root() for side s on a thread, on a copy of the position ---
+    void launch_search(const board_state &position, side s);
+
+    // --- Publishes the result of a completed iteration to pollers and the callback ---
+    void report_iteration(int depth, int score, const std::string &best_move, const std::vector<Move> &pv);
+
+    // --- Follows the best moves stored in the table from the root, starting with best ---
+    std::vector<Move> principal_variation(Position root, Move best, int depth) const;
+
+    // --- Counts a node and checks the budget every 1024 nodes ---
+    void count_node(SearchWorker &worker);
+
+    // --- Total nodes searched by all threads in the current search ---
+    long searched_nodes() const;
+
+    // --- Sums the statistics of all threads once the helpers have stopped ---
+    // --- iteration_nodes holds the node total after each completed iteration ---
+    SearchStats collect_stats(const std::vector<long> &iteration_nodes) const;
+
+    // --- Launches helper threads on the root position, and stops and joins them ---
+    void start_helpers(const Position &root, const MoveList &moves, side s);
+    void stop_helpers();
+
+    // --- Iterative deepening loop run by each helper thread ---
+    void helper_search(SearchWorker &worker, Position root, MoveList moves, side s);
+
+    // --- Root search; scores and windows are from side s's point of view ---
+    // --- search_root_move() searches one move, search_root_moves() the moves from index
+    // --- first on with principal variation search, search_line() adds the aspiration window ---
+    int search_root_move(SearchWorker &worker, Position &root, Move m, int depth, side s, int alpha, int beta);
+    int search_root_moves(SearchWorker &worker, Position &root, MoveList &moves, int first, int depth, side s, int alpha, int beta, int &best_index);
+    int search_line(SearchWorker &worker, Position &root, MoveList &moves, int first, int depth, side s, int previous, int &best_index);
+
+    // --- Iterative deepening over the best `lines` moves of side s, best first ---
+    // --- fallback is the move to play if the search is stopped before it has any line ---
+    std::vector<EngineMove> search_multipv(const board_state &position, side s, int lines, Move &fallback);
+
+    // --- Searches all legal moves of one side and applies the best one ---
+    EngineMove search_root(board_state &position, side s);
+
+    // --- MultiPV search for the best lines of side s, without the ones that lose too much ---
+    std::vector<EngineMove> search_hints(const board_state &position, side s, int lines);
+
+    // --- Minimax function with alpha-beta pruning for evaluating board positions ---
+    // --- ply is the distance from the root, used by the killer table; null_allowed is
+    // --- false right after a null move, so two passes never follow each other.
+    // --- Templated on the side to move Us, so each colour has its own specialised copy ---
+    template <side Us>
+    int adv_minimax(SearchWorker &worker, Position &position, int depth, int ply, int alpha, int beta, bool null_allowed = true);
+
+    // --- Keeps the network accumulators in step with the search: the child at ply + 1 after
+    // --- m (already made, with its undo) or after a null move at ply ---
+    void update_accumulator(SearchWorker &worker, const Position &position, Move m, const Undo &undo, int ply);
+    void copy_accumulator(SearchWorker &worker, int ply);
+
+    // --- Leaf evaluation from White's point of view: the network if open, else the classical one ---
+    int evaluate(SearchWorker &worker, const Position &position, int ply);
+
+    // --- Capture-only search at the leaves so exchanges are resolved before evaluating ---
+    template <side Us>
+    int quiescence(SearchWorker &worker, Position &position, int ply, int alpha, int beta);
 
 public:
-    Engine(); // --- Constructor for the Engine class ---
+    // --- Constructor for the Engine class ---
+    // --- hash_mb sets the transposition table size, threads the number of search threads;
+    // --- network_path picks the network evaluation (empty, or a file that cannot be
+    // --- loaded, keeps the classical evaluation) ---
+    explicit Engine(int hash_mb = DEFAULT_HASH_MB, int threads = 1, const std::string &network_path = "");
+    ~Engine();
+
+    // --- Search budget used by all following searches ---
+    void set_limits(const SearchLimits &search_limits);
+    const SearchLimits &get_limits() const;
+
+    // --- Number of search threads (1 disables Lazy SMP) ---
+    void set_threads(int threads);
+    int get_threads() const;
+
+    // --- Transposition table size in megabytes; resizing drops all stored results ---
+    void set_hash(int hash_mb);
+    int get_hash() const;
+
+    // --- Forgets all stored results, e.g. before a new game ---
+    void clear_hash();
+
+    // --- Forgets the stored results and the move ordering statistics, so that the next
+    // --- searches do not depend on the ones before (e.g. for each game of an analysis) ---
+    void new_game();
+
+    // --- Opening book file played from before searching; an empty path switches it off ---
+    // --- Returns false (and plays without a book) if the file cannot be mapped ---
+    bool set_book(const std::string &path);
+    bool has_book() const;
+
+    // --- Directory of endgame table files (made by tools/tb_generate), each mapped when
+    // --- first needed; an empty path switches probing off. Not during a search ---
+    void set_tablebase_path(const std::string &directory);
+    bool has_tablebases() const;
+
+    // --- Network file (made by tools/nnue_build) that replaces the classical evaluation; an
+    // --- empty path goes back to it. False (and classical) if the file cannot be loaded.
+    // --- Not during a search ---
+    bool set_network(const std::string &path);
+    bool has_network() const;
 
     // --- Returns the best move for Black using minimax search ---
     EngineMove make_black_move(board_state &position);
@@ -33,9 +332,46 @@ public:
     // --- Returns a vector of top 1–3 best White moves sorted by evaluation ---
     std::vector<EngineMove> get_best_white_moves(board_state &position);
 
-    // --- Minimax function with alpha-beta pruning for evaluating board positions ---
-    int adv_minimax(board_state &position, int depth, bool maximizingPlayer, int alpha, int beta);
+    // --- Returns the best moves (up to lines of them) of side s, best first, each with
+    // --- its principal variation ---
+    std::vector<EngineMove> get_best_moves(board_state &position, side s, int lines = HINT_LINES);
+
+    // --- Background search: starts on a copy of the position and returns at once ---
+    // --- Only one search may run at a time; the blocking searches, set_limits(),
+    // --- set_threads() and set_hash() must not be called until it has finished ---
+    void search_async(const board_state &position, side s);
+    void search_hints_async(const board_state &position, side s = WHITE, int lines = HINT_LINES);
+
+    // --- Pondering: position is the one the opponent (side s) is to move in ---
+    // --- The expected reply is taken from the transposition table and the engine's answer
+    // --- to it is searched without a budget. A later search_async() on that very position
+    // --- takes the ponder search over (ponder hit); any other position cancels it ---
+    void ponder_async(const board_state &position, side s);
+    bool is_pondering() const;
+
+    // --- True while a background search is running ---
+    bool searching() const;
+
+    // --- Progress of the running (or last) search; nodes are counted live ---
+    SearchInfo get_search_info() const;
+
+    // --- Callback invoked on the search thread after each iteration (empty to disable) ---
+    void set_search_callback(const SearchCallback &on_iteration);
+
+    // --- Ends the running search early; its best move so far becomes the result ---
+    void force_move();
+
+    // --- Stops the running search and throws its result away ---
+    void cancel_search();
+
+    // --- Wait for the background search and collect its result ---
+    // --- finish_move() writes the position after the engine's move into position ---
+    EngineMove finish_move(board_state &position);
+    std::vector<EngineMove> finish_hints();
 
     // --- Checks if the game is over due to checkmate or stalemate ---
+    // --- Uses the full legality passes in board.cpp; the search does not call it ---
     bool game_is_over(board_state &position);
 };
+
+#endif
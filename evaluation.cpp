@@ -1,218 +1,57 @@
 // --------------------------------------------------------------------------------------
 // evaluation.cpp
-// --- Contains definitions and initialization for evaluation logic and piece-square tables.
-// --- These tables provide positional values for pieces to aid the evaluation function. ---
+// --- Contains the evaluation logic used by the GUI checks and the engine's search.
+// --- Material and piece-square values come from the packed tables in psqt.h, which a
+// --- Position sums up incrementally, so the search only blends the middlegame and
+// --- endgame halves by game phase and adds mobility and pawn structure on top.
+// --- Those two terms are popcounts over attack and pawn bitboards; on CPUs with AVX2
+// --- the popcounts run four bitboards at a time (chosen at runtime, like PEXT in
+// --- attacks.cpp), with a plain popcount loop as the fallback.
+// --- Pawn structure, including passed pawns, is cached per pawn configuration in the
+// --- search thread's pawn hash table (pawntable.h).
+// --- The per-side terms are templated on the side, so pawn directions and relative ranks
+// --- are constants and one body serves both colours.
 // --------------------------------------------------------------------------------------
 
 #include "evaluation.h"
+#include "attacks.h"
 #include <iostream>
 
-// --- Piece-square tables for White pieces (used to evaluate position bonuses) ---
-int Evaluation::PAWN_TABLE_WHITE[8][8];
-int Evaluation::KNIGHT_TABLE_WHITE[8][8];
-int Evaluation::BISHOP_TABLE_WHITE[8][8];
-int Evaluation::ROOK_TABLE_WHITE[8][8];
-int Evaluation::QUEEN_TABLE_WHITE[8][8];
-int Evaluation::KING_MIDDLE_TABLE_WHITE[8][8];
-int Evaluation::KING_END_TABLE_WHITE[8][8];
-
-// --- Piece-square tables for Black pieces (will be mirrored from White's tables) ---
-int Evaluation::PAWN_TABLE_BLACK[8][8];
-int Evaluation::KNIGHT_TABLE_BLACK[8][8];
-int Evaluation::BISHOP_TABLE_BLACK[8][8];
-int Evaluation::ROOK_TABLE_BLACK[8][8];
-int Evaluation::QUEEN_TABLE_BLACK[8][8];
-int Evaluation::KING_MIDDLE_TABLE_BLACK[8][8];
-int Evaluation::KING_END_TABLE_BLACK[8][8];
-
-// --- Copies a piece-square table from source to destination ---
-void Evaluation::copy_table(int source[8][8], int destination[8][8])
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+bool Evaluation::use_avx2 = false;
+
+// --- Squares in front of a pawn on its own and the adjacent files: a pawn with no enemy
+//     pawn there is passed ---
+static Bitboard PASSED_SPAN[2][64];
+
+// --- Passed pawn bonus by rank counted from the pawn's own side, middlegame and endgame ---
+static const int PASSED_MIDDLE[8] = {0, 0, 5, 10, 20, 35, 60, 0};
+static const int PASSED_END[8] = {0, 10, 15, 25, 45, 70, 110, 0};
+
+// --- Fills the packed piece-square tables (see psqt.h) and picks the popcount kernel ---
+void Evaluation::initialize_piece_square_tables()
 {
-    for (int i = 0; i < 8; i++)
+    PSQT::initialize();
+
+    for (int sq = 0; sq < 64; sq++)
     {
-        for (int j = 0; j < 8; j++)
-        {
-            destination[i][j] = source[i][j];
-        }
+        Bitboard files = FILE_A_BB << col_of(sq);
+        files |= ((files & ~FILE_A_BB) >> 1) | ((files & ~FILE_H_BB) << 1);
+
+        Bitboard above = (rank_of(sq) == 7) ? 0 : (~0ULL << (8 * (rank_of(sq) + 1)));
+        Bitboard below = (rank_of(sq) == 0) ? 0 : (~0ULL >> (8 * (8 - rank_of(sq))));
+        PASSED_SPAN[WHITE][sq] = files & above;
+        PASSED_SPAN[BLACK][sq] = files & below;
     }
-}
 
-// --- Initializes piece-square tables for all white and black pieces.
-// --- These tables are used for positional evaluation in the engine.
-void Evaluation::initialize_piece_square_tables()
-{
-    // --- White Pawn Position Table ---
-    int white_pawn[8][8] =
-        {
-            {0, 0, 0, 0, 0, 0, 0, 0},
-            {50, 50, 50, 50, 50, 50, 50, 50},
-            {10, 10, 20, 30, 30, 20, 10, 10},
-            {5, 5, 10, 25, 25, 10, 5, 5},
-            {0, 0, 0, 20, 20, 0, 0, 0},
-            {5, -5, -10, 0, 0, -10, -5, 5},
-            {5, 10, 10, -20, -20, 10, 10, 5},
-            {0, 0, 0, 0, 0, 0, 0, 0}};
-
-    // --- White Knight Position Table ---
-    int white_knight[8][8] =
-        {
-            {-50, -40, -30, -30, -30, -30, -40, -50},
-            {-40, -20, 0, 0, 0, 0, -20, -40},
-            {-30, 0, 10, 15, 15, 10, 0, -30},
-            {-30, 5, 15, 20, 20, 15, 5, -30},
-            {-30, 0, 15, 20, 20, 15, 0, -30},
-            {-30, 5, 10, 15, 15, 10, 5, -30},
-            {-40, -20, 0, 5, 5, 0, -20, -40},
-            {-50, -40, -30, -30, -30, -30, -40, -50}};
-
-    // --- White Bishop Position Table ---
-    int white_bishop[8][8] = {
-        {-20, -10, -10, -10, -10, -10, -10, -20},
-        {-10, 0, 0, 0, 0, 0, 0, -10},
-        {-10, 0, 5, 10, 10, 5, 0, -10},
-        {-10, 5, 5, 10, 10, 5, 5, -10},
-        {-10, 0, 10, 10, 10, 10, 0, -10},
-        {-10, 10, 10, 10, 10, 10, 10, -10},
-        {-10, 5, 0, 0, 0, 0, 5, -10},
-        {-20, -10, -10, -10, -10, -10, -10, -20}};
-
-    // --- White Rook Position Table ---
-    int white_rook[8][8] = {
-        {0, 0, 0, 0, 0, 0, 0, 0},
-        {5, 10, 10, 10, 10, 10, 10, 5},
-        {-5, 0, 0, 0, 0, 0, 0, -5},
-        {-5, 0, 0, 0, 0, 0, 0, -5},
-        {-5, 0, 0, 0, 0, 0, 0, -5},
-        {-5, 0, 0, 0, 0, 0, 0, -5},
-        {-5, 0, 0, 0, 0, 0, 0, -5},
-        {0, 0, 0, 5, 5, 3, 0, 0}};
-
-    // --- White Queen Position Table ---
-    int white_queen[8][8] = {
-        {-20, -10, -10, -5, -5, -10, -10, -20},
-        {-10, 0, 0, 0, 0, 0, 0, -10},
-        {-10, 0, 5, 5, 5, 5, 0, -10},
-        {-5, 0, 5, 5, 5, 5, 0, -5},
-        {0, 0, 5, 5, 5, 5, 0, -5},
-        {-10, 5, 5, 5, 5, 5, 0, -10},
-        {-10, 0, 5, 0, 0, 0, 0, -10},
-        {-20, -10, -10, -5, -5, -10, -10, -20}};
-
-    // --- White King Middle Game Position Table ---
-    int white_king_middle[8][8] = {
-        {-30, -40, -40, -50, -50, -40, -40, -30},
-        {-30, -40, -40, -50, -50, -40, -40, -30},
-        {-30, -40, -40, -50, -50, -40, -40, -30},
-        {-30, -40, -40, -50, -50, -40, -40, -30},
-        {-20, -30, -30, -40, -40, -30, -30, -20},
-        {-10, -20, -20, -20, -20, -20, -20, -10},
-        {20, 20, 0, 0, 0, 0, 20, 20},
-        {20, 30, 10, 0, 0, 10, 30, 20}};
-
-    // --- White King End Game Position Table ---
-    int white_king_end[8][8] = {
-        {-50, -40, -30, -20, -20, -30, -40, -50},
-        {-30, -20, -10, 0, 0, -10, -20, -30},
-        {-30, -10, 20, 30, 30, 20, -10, -30},
-        {-30, -10, 30, 40, 40, 30, -10, -30},
-        {-30, -10, 30, 40, 40, 30, -10, -30},
-        {-30, -10, 20, 30, 30, 20, -10, -30},
-        {-30, -30, 0, 0, 0, 0, -30, -30},
-        {-50, -30, -30, -30, -30, -30, -30, -50}};
-
-    // --- Black Pawn Position Table ---
-    int black_pawn[8][8] = {
-        {0, 0, 0, 0, 0, 0, 0, 0},
-        {5, 10, 10, -20, -20, 10, 10, 5},
-        {5, -5, -10, 0, 0, -10, -5, 5},
-        {0, 0, 0, 20, 20, 0, 0, 0},
-        {5, 5, 10, 25, 25, 10, 5, 5},
-        {10, 10, 20, 30, 30, 20, 10, 10},
-        {50, 50, 50, 50, 50, 50, 50, 50},
-        {0, 0, 0, 0, 0, 0, 0, 0}};
-
-    // --- Black Knight Position Table ---
-    int black_knight[8][8] = {
-        {-50, -40, -30, -30, -30, -30, -40, -50},
-        {-40, -20, 0, 5, 5, 0, -20, -40},
-        {-30, 5, 10, 15, 15, 10, 5, -30},
-        {-30, 0, 15, 20, 20, 15, 0, -30},
-        {-30, 5, 15, 20, 20, 15, 5, -30},
-        {-30, 0, 10, 15, 15, 10, 0, -30},
-        {-40, -20, 0, 0, 0, 0, -20, -40},
-        {-50, -40, -30, -30, -30, -30, -40, -50}};
-
-    // --- Black Bishop Position Table ---
-    int black_bishop[8][8] = {
-        {-20, -10, -10, -10, -10, -10, -10, -20},
-        {-10, 5, 0, 0, 0, 0, 5, -10},
-        {-10, 10, 10, 10, 10, 10, 10, -10},
-        {-10, 0, 10, 10, 10, 10, 0, -10},
-        {-10, 5, 5, 10, 10, 5, 5, -10},
-        {-10, 0, 5, 10, 10, 5, 0, -10},
-        {-10, 0, 0, 0, 0, 0, 0, -10},
-        {-20, -10, -10, -10, -10, -10, -10, -20}};
-
-    // --- Black Rook Position Table ---
-    int black_rook[8][8] = {
-        {0, 0, 0, 5, 5, 3, 0, 0},
-        {-5, 0, 0, 0, 0, 0, 0, -5},
-        {-5, 0, 0, 0, 0, 0, 0, -5},
-        {-5, 0, 0, 0, 0, 0, 0, -5},
-        {-5, 0, 0, 0, 0, 0, 0, -5},
-        {-5, 0, 0, 0, 0, 0, 0, -5},
-        {5, 10, 10, 10, 10, 10, 10, 5},
-        {0, 0, 0, 0, 0, 0, 0, 0}};
-
-    // --- Black Queen Position Table ---
-    int black_queen[8][8] = {
-        {-20, -10, -10, -5, -5, -10, -10, -20},
-        {-10, 0, 5, 0, 0, 0, 0, -10},
-        {-10, 5, 5, 5, 5, 5, 0, -10},
-        {0, 0, 5, 5, 5, 5, 0, -5},
-        {-5, 0, 5, 5, 5, 5, 0, -5},
-        {-10, 0, 5, 5, 5, 5, 0, -10},
-        {-10, 0, 0, 0, 0, 0, 0, -10},
-        {-20, -10, -10, -5, -5, -10, -10, -20}};
-
-    // --- Black King Middle Game Table ---
-    int black_king_middle[8][8] = {
-        {20, 30, 10, 0, 0, 10, 30, 20},
-        {20, 20, 0, 0, 0, 0, 20, 20},
-        {-10, -20, -20, -20, -20, -20, -20, -10},
-        {-20, -30, -30, -40, -40, -30, -30, -20},
-        {-30, -40, -40, -50, -50, -40, -40, -30},
-        {-30, -40, -40, -50, -50, -40, -40, -30},
-        {-30, -40, -40, -50, -50, -40, -40, -30},
-        {-30, -40, -40, -50, -50, -40, -40, -30}};
-
-    // --- Black King End Game Table ---
-    int black_king_end[8][8] = {
-        {-50, -30, -30, -30, -30, -30, -30, -50},
-        {-30, -30, 0, 0, 0, 0, -30, -30},
-        {-30, -10, 20, 30, 30, 20, -10, -30},
-        {-30, -10, 30, 40, 40, 30, -10, -30},
-        {-30, -10, 30, 40, 40, 30, -10, -30},
-        {-30, -10, 20, 30, 30, 20, -10, -30},
-        {-30, -20, -10, 0, 0, -10, -20, -30},
-        {-50, -40, -30, -20, -20, -30, -40, -50}};
-
-    // --- Copy to static member tables using helper function ---
-    copy_table(white_pawn, PAWN_TABLE_WHITE);
-    copy_table(white_knight, KNIGHT_TABLE_WHITE);
-    copy_table(white_bishop, BISHOP_TABLE_WHITE);
-    copy_table(white_rook, ROOK_TABLE_WHITE);
-    copy_table(white_queen, QUEEN_TABLE_WHITE);
-    copy_table(white_king_middle, KING_MIDDLE_TABLE_WHITE);
-    copy_table(white_king_end, KING_END_TABLE_WHITE);
-
-    copy_table(black_pawn, PAWN_TABLE_BLACK);
-    copy_table(black_knight, KNIGHT_TABLE_BLACK);
-    copy_table(black_bishop, BISHOP_TABLE_BLACK);
-    copy_table(black_rook, ROOK_TABLE_BLACK);
-    copy_table(black_queen, QUEEN_TABLE_BLACK);
-    copy_table(black_king_middle, KING_MIDDLE_TABLE_BLACK);
-    copy_table(black_king_end, KING_END_TABLE_BLACK);
+#if defined(__AVX2__)
+    use_avx2 = true;
+#elif defined(__x86_64__) || defined(__i386__)
+    use_avx2 = __builtin_cpu_supports("avx2");
+#endif
 }
 
 // --- Evaluates the board state and returns a score based on material, position,
@@ -236,306 +75,260 @@ int Evaluation::evaluate(board_state &position, int depth)
         return 100000 + depth;
     }
 
-    // --- Initialize evaluation parameters ---
-    int score = 0;
-    int legal_moves_white = 0;
-    int legal_moves_black = 0;
-
-    int wk_i = 0, wk_j = 0;
-    int bk_i = 0, bk_j = 0;
+    return evaluate_static(position);
+}
 
-    bool is_end_game = false;
-    bool white_queen_on_board = false;
-    bool black_queen_on_board = false;
-    int num_of_white_minor_pieces = 0;
-    int num_of_black_minor_pieces = 0;
+// --- Scores material, position, mobility and pawn structure without looking for
+//     checkmate or stalemate. The search detects those itself from having no legal
+//     moves and calls evaluate(const Position &) directly ---
+int Evaluation::evaluate_static(board_state &position)
+{
+    return evaluate(Position::from_board_state(position, WHITE));
+}
 
-    int white_pawns_in_file[8] = {0};
-    int black_pawns_in_file[8] = {0};
+// --- Most bitboards popcounted by one side's mobility term: 5 pawn sets, 1 king set
+//     and up to 10 each of knights, bishops and rooks, rounded up to whole AVX2 vectors ---
+static const int MAX_MOBILITY_SETS = 36;
 
-    // --- Traverse the board and evaluate all pieces ---
-    for (int m = 0; m < 8; m++)
+// --- Scalar kernels ---
+static int popcount_sum_scalar(const Bitboard *sets, int n)
+{
+    int total = 0;
+    for (int k = 0; k < n; k++)
     {
-        for (int n = 0; n < 8; n++)
-        {
-            // --- WHITE PAWN Evaluation ---
-            if (position.board[m][n] == WHITE_PAWN)
-            {
-                score += 100;
-                score += PAWN_TABLE_WHITE[m][n];
-                white_pawns_in_file[n]++;
-
-                // --- White Pawn mobility ---
-                if (position.board[m - 1][n] == 0)
-                    legal_moves_white++;
-                if (m == 6 && position.board[m - 1][n] == 0 && position.board[m - 2][n] == 0)
-                    legal_moves_white++;
-                if (n != 0 && position.board[m - 1][n - 1] < 0)
-                    legal_moves_white++;
-                if (n != 7 && position.board[m - 1][n + 1] < 0)
-                    legal_moves_white++;
-                if (n != 7 && position.board[m][n + 1] == -1 && position.pawn_two_squares_black[n + 1])
-                    legal_moves_white++;
-                if (n != 0 && position.board[m][n - 1] == -1 && position.pawn_two_squares_black[n - 1])
-                    legal_moves_white++;
-            }
-
-            // --- WHITE KNIGHT Evaluation ---
-            else if (position.board[m][n] == WHITE_KNIGHT)
-            {
-                score += 320;
-                score += KNIGHT_TABLE_WHITE[m][n];
-                num_of_white_minor_pieces++;
-
-                for (int k = 0; k < 8; k++)
-                {
-                    int k_i = m + knight_move[k][0];
-                    int k_j = n + knight_move[k][1];
-                    if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8 && position.board[k_i][k_j] <= 0)
-                        legal_moves_white++;
-                }
-            }
+        total += popcount(sets[k]);
+    }
+    return total;
+}
 
-            // --- WHITE BISHOP Evaluation ---
-            else if (position.board[m][n] == WHITE_BISHOP)
-            {
-                score += 330;
-                score += BISHOP_TABLE_WHITE[m][n];
-                num_of_white_minor_pieces++;
-
-                for (int k = 0; k < 4; k++)
-                {
-                    int path_i = m + bishop_direction[k][0];
-                    int path_j = n + bishop_direction[k][1];
-                    while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                    {
-                        if (position.board[path_i][path_j] <= 0)
-                            legal_moves_white++;
-                        if (position.board[path_i][path_j] != 0)
-                            break;
-                        path_i += bishop_direction[k][0];
-                        path_j += bishop_direction[k][1];
-                    }
-                }
-            }
+static void file_counts_scalar(Bitboard pawns, int counts[8])
+{
+    for (int f = 0; f < 8; f++)
+    {
+        counts[f] = popcount(pawns & (FILE_A_BB << f));
+    }
+}
 
-            // --- WHITE ROOK Evaluation ---
-            else if (position.board[m][n] == WHITE_ROOK)
-            {
-                score += 500;
-                score += ROOK_TABLE_WHITE[m][n];
-                num_of_white_minor_pieces++;
-
-                for (int k = 0; k < 4; k++)
-                {
-                    int path_i = m + rook_direction[k][0];
-                    int path_j = n + rook_direction[k][1];
-                    while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                    {
-                        if (position.board[path_i][path_j] <= 0)
-                            legal_moves_white++;
-                        if (position.board[path_i][path_j] != 0)
-                            break;
-                        path_i += rook_direction[k][0];
-                        path_j += rook_direction[k][1];
-                    }
-                }
-            }
+#if defined(__x86_64__) || defined(__i386__)
+// --- AVX2 kernels, compiled for AVX2 even when the rest of the build is not ---
+// --- Bytes are popcounted with a nibble lookup (vpshufb) and summed per 64-bit lane ---
+__attribute__((target("avx2"))) static inline __m256i popcount_lanes_avx2(__m256i v)
+{
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+
+    __m256i low = _mm256_and_si256(v, low_mask);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low), _mm256_shuffle_epi8(lookup, high));
+    return _mm256_sad_epu8(bytes, _mm256_setzero_si256());
+}
 
-            // --- WHITE QUEEN Evaluation ---
-            else if (position.board[m][n] == WHITE_QUEEN)
-            {
-                score += 900;
-                score += QUEEN_TABLE_WHITE[m][n];
-                white_queen_on_board = true;
-            }
+// --- n must be a multiple of 4; callers pad with empty sets ---
+__attribute__((target("avx2"))) static int popcount_sum_avx2(const Bitboard *sets, int n)
+{
+    __m256i total = _mm256_setzero_si256();
+    for (int k = 0; k < n; k += 4)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(sets + k));
+        total = _mm256_add_epi64(total, popcount_lanes_avx2(v));
+    }
 
-            // --- WHITE KING Evaluation ---
-            else if (position.board[m][n] == WHITE_KING)
-            {
-                wk_i = m;
-                wk_j = n;
-                for (int k = 0; k < 8; k++)
-                {
-                    int k_i = m + every_direction[k][0];
-                    int k_j = n + every_direction[k][1];
-                    if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8 &&
-                        position.board[k_i][k_j] <= 0 &&
-                        !Board::under_control(position.board, k_i, k_j, BLACK))
-                    {
-                        legal_moves_white++;
-                    }
-                }
-            }
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+    return (int)(_mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1));
+}
 
-            // --- BLACK PIECES (same logic, mirrored signs) ---
-            // --- BLACK PAWN Evaluation ---
-            else if (position.board[m][n] == BLACK_PAWN)
-            {
-                score -= 100;
-                score -= PAWN_TABLE_BLACK[m][n];
-                black_pawns_in_file[n]++;
-
-                if (position.board[m + 1][n] == 0)
-                    legal_moves_black++;
-                if (m == 1 && position.board[m + 1][n] == 0 && position.board[m + 2][n] == 0)
-                    legal_moves_black++;
-                if (n != 0 && position.board[m + 1][n - 1] > 0)
-                    legal_moves_black++;
-                if (n != 7 && position.board[m + 1][n + 1] > 0)
-                    legal_moves_black++;
-                if (n != 7 && position.board[m][n + 1] == 1 && position.pawn_two_squares_white[n + 1])
-                    legal_moves_black++;
-                if (n != 0 && position.board[m][n - 1] == 1 && position.pawn_two_squares_white[n - 1])
-                    legal_moves_black++;
-            }
+__attribute__((target("avx2"))) static void file_counts_avx2(Bitboard pawns, int counts[8])
+{
+    __m256i v = _mm256_set1_epi64x((long long)pawns);
+    __m256i low_files = _mm256_setr_epi64x((long long)FILE_A_BB, (long long)(FILE_A_BB << 1),
+                                           (long long)(FILE_A_BB << 2), (long long)(FILE_A_BB << 3));
+    __m256i high_files = _mm256_slli_epi64(low_files, 4);
+
+    alignas(32) long long lanes[8];
+    _mm256_store_si256((__m256i *)lanes, popcount_lanes_avx2(_mm256_and_si256(v, low_files)));
+    _mm256_store_si256((__m256i *)(lanes + 4), popcount_lanes_avx2(_mm256_and_si256(v, high_files)));
+    for (int f = 0; f < 8; f++)
+    {
+        counts[f] = (int)lanes[f];
+    }
+}
+#endif
 
-            // --- BLACK KNIGHT ---
-            else if (position.board[m][n] == BLACK_KNIGHT)
-            {
-                score -= 320;
-                score -= KNIGHT_TABLE_BLACK[m][n];
-                num_of_black_minor_pieces++;
-
-                for (int k = 0; k < 8; k++)
-                {
-                    int k_i = m + knight_move[k][0];
-                    int k_j = n + knight_move[k][1];
-                    if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8 && position.board[k_i][k_j] >= 0)
-                        legal_moves_black++;
-                }
-            }
+// --- Dispatch to the kernel chosen in initialize_piece_square_tables() ---
+static inline int popcount_sum(const Bitboard *sets, int n)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (Evaluation::use_avx2)
+    {
+        return popcount_sum_avx2(sets, n);
+    }
+#endif
+    return popcount_sum_scalar(sets, n);
+}
 
-            // --- BLACK BISHOP ---
-            else if (position.board[m][n] == BLACK_BISHOP)
-            {
-                score -= 330;
-                score -= BISHOP_TABLE_BLACK[m][n];
-                num_of_black_minor_pieces++;
-
-                for (int k = 0; k < 4; k++)
-                {
-                    int path_i = m + bishop_direction[k][0];
-                    int path_j = n + bishop_direction[k][1];
-                    while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                    {
-                        if (position.board[path_i][path_j] >= 0)
-                            legal_moves_black++;
-                        if (position.board[path_i][path_j] != 0)
-                            break;
-                        path_i += bishop_direction[k][0];
-                        path_j += bishop_direction[k][1];
-                    }
-                }
-            }
+static inline void file_counts(Bitboard pawns, int counts[8])
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (Evaluation::use_avx2)
+    {
+        file_counts_avx2(pawns, counts);
+        return;
+    }
+#endif
+    file_counts_scalar(pawns, counts);
+}
 
-            // --- BLACK ROOK ---
-            else if (position.board[m][n] == BLACK_ROOK)
-            {
-                score -= 500;
-                score -= ROOK_TABLE_BLACK[m][n];
-                num_of_black_minor_pieces++;
-
-                for (int k = 0; k < 4; k++)
-                {
-                    int path_i = m + rook_direction[k][0];
-                    int path_j = n + rook_direction[k][1];
-                    while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
-                    {
-                        if (position.board[path_i][path_j] >= 0)
-                            legal_moves_black++;
-                        if (position.board[path_i][path_j] != 0)
-                            break;
-                        path_i += rook_direction[k][0];
-                        path_j += rook_direction[k][1];
-                    }
-                }
-            }
+// --- Shifts a bitboard by a signed number of squares known at compile time ---
+template <int Delta>
+static inline Bitboard shift(Bitboard b)
+{
+    return Delta > 0 ? b << (Delta & 63) : b >> (-Delta & 63);
+}
 
-            // --- BLACK QUEEN ---
-            else if (position.board[m][n] == BLACK_QUEEN)
-            {
-                score -= 900;
-                score -= QUEEN_TABLE_BLACK[m][n];
-                black_queen_on_board = true;
-            }
+// --- Pseudo-legal move count of side S (queens excluded; the king avoids attacked squares) ---
+template <side S>
+static int mobility(const Position &position)
+{
+    const side them = opposite(S);
+    Bitboard own = position.occupancy[S];
+    Bitboard enemy = position.occupancy[them];
+    Bitboard empty = ~position.occupied;
+
+    Bitboard sets[MAX_MOBILITY_SETS];
+    int n = 0;
+
+    // --- Pawns: pushes, double pushes from the home rank, captures and en passant ---
+    const int up = pawn_push<S>();
+    Bitboard pawns = position.pieces[S][PAWN];
+    Bitboard single_push = shift<up>(pawns) & empty;
+
+    sets[n++] = single_push;
+    sets[n++] = shift<up>(single_push & relative_rank_bb<S>(2)) & empty;
+    sets[n++] = shift<up - 1>(pawns & ~FILE_A_BB) & enemy;
+    sets[n++] = shift<up + 1>(pawns & ~FILE_H_BB) & enemy;
+    sets[n++] = (position.to_move == S && position.en_passant != NO_SQUARE)
+                    ? Attacks::pawn(them, position.en_passant) & pawns
+                    : 0;
+
+    // --- Knights, bishops and rooks: attacked squares not holding an own piece ---
+    for (Bitboard b = position.pieces[S][KNIGHT]; b;)
+    {
+        sets[n++] = Attacks::knight(pop_lsb(b)) & ~own;
+    }
+    for (Bitboard b = position.pieces[S][BISHOP]; b;)
+    {
+        sets[n++] = Attacks::bishop(pop_lsb(b), position.occupied) & ~own;
+    }
+    for (Bitboard b = position.pieces[S][ROOK]; b;)
+    {
+        sets[n++] = Attacks::rook(pop_lsb(b), position.occupied) & ~own;
+    }
 
-            // --- BLACK KING ---
-            else if (position.board[m][n] == BLACK_KING)
+    // --- King: neighbouring squares the opponent does not attack ---
+    Bitboard king_moves = 0;
+    if (position.pieces[S][KING])
+    {
+        for (Bitboard b = Attacks::king(position.king_square(S)) & ~own; b;)
+        {
+            int sq = pop_lsb(b);
+            if (!position.is_attacked(sq, them))
             {
-                bk_i = m;
-                bk_j = n;
-                for (int k = 0; k < 8; k++)
-                {
-                    int k_i = m + every_direction[k][0];
-                    int k_j = n + every_direction[k][1];
-                    if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8 &&
-                        position.board[k_i][k_j] >= 0 &&
-                        !Board::under_control(position.board, k_i, k_j, WHITE))
-                    {
-                        legal_moves_black++;
-                    }
-                }
+                king_moves |= square_bb(sq);
             }
         }
     }
+    sets[n++] = king_moves;
 
-    // --- Add mobility bonus ---
-    score += 10 * (legal_moves_white - legal_moves_black);
-
-    // --- Determine if it's endgame based on queen + minor pieces ---
-    if ((!white_queen_on_board && !black_queen_on_board) ||
-        (white_queen_on_board && num_of_white_minor_pieces <= 1) ||
-        (black_queen_on_board && num_of_black_minor_pieces <= 1))
+    // --- Pad to whole vectors for the AVX2 kernel ---
+    while (n & 3)
     {
-        is_end_game = true;
+        sets[n++] = 0;
     }
+    return popcount_sum(sets, n);
+}
 
-    // --- Add king positional bonuses based on game phase ---
-    score += is_end_game ? KING_END_TABLE_WHITE[wk_i][wk_j] : KING_MIDDLE_TABLE_WHITE[wk_i][wk_j];
-    score -= is_end_game ? KING_END_TABLE_BLACK[bk_i][bk_j] : KING_MIDDLE_TABLE_BLACK[bk_i][bk_j];
-
-    // --- Evaluate pawn structure: doubled pawns, isolated pawns, and pawn islands ---
-    int white_pawn_islands = 0;
-    int black_pawn_islands = 0;
-    bool white_pawn_island_flag = false;
-    bool black_pawn_island_flag = false;
+// --- Doubled, isolated and island penalties for one side's pawns (positive = bad) ---
+// --- Only the b- to g-files count as isolated ---
+static int pawn_penalty(Bitboard pawns)
+{
+    int in_file[8];
+    file_counts(pawns, in_file);
 
-    for (int i = 0; i < 8; i++)
+    int penalty = 0;
+    unsigned files = 0;
+    for (int f = 0; f < 8; f++)
     {
-        if (white_pawns_in_file[i] > 1)
-            score -= white_pawns_in_file[i] * 15;
-        if (black_pawns_in_file[i] > 1)
-            score += black_pawns_in_file[i] * 15;
+        if (in_file[f] > 1)
+            penalty += in_file[f] * 15;
+        if (in_file[f] > 0)
+            files |= 1u << f;
+    }
 
-        if (white_pawns_in_file[i] > 0 && !white_pawn_island_flag)
-        {
-            white_pawn_islands++;
-            white_pawn_island_flag = true;
-        }
-        if (white_pawns_in_file[i] == 0)
-            white_pawn_island_flag = false;
+    unsigned isolated = files & ~(files << 1) & ~(files >> 1) & 0x7e;
+    unsigned islands = files & ~(files << 1);
+    penalty += 30 * popcount(isolated);
+    penalty += 10 * popcount(islands);
+    return penalty;
+}
 
-        if (black_pawns_in_file[i] > 0 && !black_pawn_island_flag)
+// --- Passed pawns of side S, worth more the further they have advanced; marks them in
+// --- the entry and returns their bonus for side S ---
+template <side S>
+static Score passed_pawns(const Position &position, PawnEntry &entry)
+{
+    Bitboard enemy_pawns = position.pieces[opposite(S)][PAWN];
+    Score bonus = 0;
+    entry.passed[S] = 0;
+    for (Bitboard b = position.pieces[S][PAWN]; b;)
+    {
+        int sq = pop_lsb(b);
+        if (!(PASSED_SPAN[S][sq] & enemy_pawns))
         {
-            black_pawn_islands++;
-            black_pawn_island_flag = true;
+            entry.passed[S] |= square_bb(sq);
+            bonus += make_score(PASSED_MIDDLE[relative_rank<S>(sq)], PASSED_END[relative_rank<S>(sq)]);
         }
-        if (black_pawns_in_file[i] == 0)
-            black_pawn_island_flag = false;
+    }
+    return bonus;
+}
 
-        if (i != 0 && i != 7)
-        {
-            if (white_pawns_in_file[i] > 0 && white_pawns_in_file[i - 1] == 0 && white_pawns_in_file[i + 1] == 0)
-                score -= 30;
-            if (black_pawns_in_file[i] > 0 && black_pawns_in_file[i - 1] == 0 && black_pawns_in_file[i + 1] == 0)
-                score += 30;
-        }
+// --- Scores the pawn structure of both sides into a pawn table entry ---
+static void evaluate_pawns(const Position &position, PawnEntry &entry)
+{
+    int structure = pawn_penalty(position.pieces[BLACK][PAWN]) - pawn_penalty(position.pieces[WHITE][PAWN]);
+    Score score = make_score(structure, structure);
+    score += passed_pawns<WHITE>(position, entry) - passed_pawns<BLACK>(position, entry);
+
+    entry.key = position.pawn_key;
+    entry.score = score;
+}
+
+int Evaluation::positional_terms(const Position &position)
+{
+    return 10 * (mobility<WHITE>(position) - mobility<BLACK>(position)) + pawn_penalty(position.pieces[BLACK][PAWN]) -
+           pawn_penalty(position.pieces[WHITE][PAWN]);
+}
+
+// --- Leaf evaluation of the search ---
+// --- Material and piece-square scores are already summed in the Position and pawn
+//     structure comes from the pawn table when one is given; the middlegame and endgame
+//     values are blended by phase (24 = opening, 0 = pawn ending) ---
+int Evaluation::evaluate(const Position &position, PawnTable *pawn_table)
+{
+    PawnEntry local;
+    PawnEntry *pawns = &local;
+    if (pawn_table)
+    {
+        pawns = pawn_table->entry(position.pawn_key);
+    }
+    if (!pawn_table || pawns->key != position.pawn_key)
+    {
+        evaluate_pawns(position, *pawns);
     }
 
-    // --- Apply pawn island penalties ---
-    score -= 10 * (white_pawn_islands - black_pawn_islands);
+    Score total = position.psq + pawns->score;
+    int phase = position.phase < MAX_PHASE ? position.phase : MAX_PHASE;
+    int score = (mg_value(total) * phase + eg_value(total) * (MAX_PHASE - phase)) / MAX_PHASE;
 
-    // --- Return final evaluation score ---
-    return score;
+    return score + 10 * (mobility<WHITE>(position) - mobility<BLACK>(position));
 }
\ No newline at end of file
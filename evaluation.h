@@ -1,46 +1,42 @@
 // --------------------------------------------------------------------------------------
 // evaluation.h
 // --- Header file for the Evaluation class responsible for scoring a board position. ---
-// --- Includes piece-square tables for both colors and evaluation logic.             ---
+// --- Material and piece-square values live in the tapered tables of psqt.h.         ---
+// --- Mobility and pawn structure are popcounts, with AVX2 kernels where available.  ---
+// --- Pawn structure scores are cached in a pawn hash table (pawntable.h).           ---
 // --------------------------------------------------------------------------------------
 
 #ifndef EVALUATION_H
 #define EVALUATION_H
 
 #include "board.h"
+#include "position.h"
+#include "pawntable.h"
 
 // --- Evaluation class handles static evaluation of a given board state ---
 class Evaluation
 {
-private:
-    // --- Piece-square tables for White ---
-    static int PAWN_TABLE_WHITE[8][8];
-    static int KNIGHT_TABLE_WHITE[8][8];
-    static int BISHOP_TABLE_WHITE[8][8];
-    static int ROOK_TABLE_WHITE[8][8];
-    static int QUEEN_TABLE_WHITE[8][8];
-    static int KING_MIDDLE_TABLE_WHITE[8][8];
-    static int KING_END_TABLE_WHITE[8][8];
-
-    // --- Piece-square tables for Black (mirrored from White) ---
-    static int PAWN_TABLE_BLACK[8][8];
-    static int KNIGHT_TABLE_BLACK[8][8];
-    static int BISHOP_TABLE_BLACK[8][8];
-    static int ROOK_TABLE_BLACK[8][8];
-    static int QUEEN_TABLE_BLACK[8][8];
-    static int KING_MIDDLE_TABLE_BLACK[8][8];
-    static int KING_END_TABLE_BLACK[8][8];
-
-    // --- Utility function to copy one table to another ---
-    static void copy_table(int source[8][8], int destination[8][8]);
-
 public:
-    // --- Initializes all piece-square tables (called once before evaluations) ---
+    // --- True when the mobility and pawn popcounts use the AVX2 kernels (runtime detection) ---
+    static bool use_avx2;
+
+    // --- Initializes all piece-square tables and picks the popcount kernels (called once) ---
     static void initialize_piece_square_tables();
 
     // --- Evaluates the current board state and returns an integer score ---
     static int evaluate(board_state &position, int d);
 
+    // --- Same score without the checkmate/stalemate checks ---
+    static int evaluate_static(board_state &position);
+
+    // --- Leaf evaluation used by the search, from the Position's incremental scores ---
+    // --- Pawn structure is looked up in (and stored to) pawn_table when one is given ---
+    static int evaluate(const Position &position, PawnTable *pawn_table = NULL);
+
+    // --- Mobility and doubled/isolated/island pawn terms alone, from White's point of view;
+    // --- eval_bench checks and times them against the 8x8 board pass they replaced ---
+    static int positional_terms(const Position &position);
+
     // --- Keeps track of move count used for evaluations/debugging ---
     static int moves;
 };
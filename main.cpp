@@ -12,6 +12,7 @@
 #include <vector>
 #include <string>
 #include <queue>
+#include <map>
 #include <fstream>
 #include <sstream>
 
@@ -33,15 +34,21 @@ using namespace std;
 
 // --- Game core objects ---
 Board board;
-Engine engine;
+Engine engine(DEFAULT_HASH_MB, (int)std::thread::hardware_concurrency()); // --- One search thread per core ---
 Human human;
 
 // --- GUI and game flow function declarations ---
 void load_images();
+void load_fonts();
+ALLEGRO_FONT *get_font(const char *file, int size);
+void destroy_assets();
 void display_start_menu();
 void handle_mouse_events();
 char select_player();
 void perform_engine_move();
+void finish_engine_move();
+void show_engine_hints();
+void poll_engine();
 void handle_vs_engine_moves();
 void handle_vs_human_moves();
 void handle_puzzle_mode_moves();
@@ -51,11 +58,14 @@ void handle_Learning_mode();
 void select_puzzle_mode();
 void setup_puzzle_on_board();
 void draw_screen();
+void draw_board_layer();
+string board_layer_key();
 void draw_piece(int i, int j);
 char show_promotion_menu(bool is_white);
 void draw_move_history(ALLEGRO_EVENT ev);
 void draw_evaluation_bar();
 void draw_details();
+void draw_search_stats();
 void pop_message(const string &title, const string &message, int type = 0);
 void al_draw_text_button(int x, int y, int w, int h, const char *label, ALLEGRO_FONT *font);
 string coords_to_string(int from_i, int from_j, int to_i, int to_j);
@@ -68,6 +78,8 @@ clock_t start_time;
 // --- Allegro library core components ---
 ALLEGRO_DISPLAY *display = NULL;
 ALLEGRO_EVENT_QUEUE *event_queue = NULL;
+ALLEGRO_TIMER *timer = NULL; // --- Ticks at FPS so the screen updates while the engine thinks ---
+const int SEARCH_REDRAW_TICKS = 6; // --- Timer ticks between redraws while the engine thinks (10 per second) ---
 ALLEGRO_EVENT ev;
 
 // --- Images for pieces and UI ---
@@ -87,6 +99,14 @@ ALLEGRO_BITMAP *black_queen_img = NULL;
 ALLEGRO_BITMAP *black_king_img = NULL;
 ALLEGRO_BITMAP *random_img = NULL;
 
+// --- Fonts, loaded once by load_fonts() and looked up by file and size ---
+std::map<std::pair<std::string, int>, ALLEGRO_FONT *> font_cache;
+
+// --- Board, highlights and pieces rendered offscreen, redrawn only when board_cache_key changes ---
+ALLEGRO_BITMAP *board_cache = NULL;
+ALLEGRO_DISPLAY *board_cache_display = NULL; // --- Display the cache was created for ---
+string board_cache_key;
+
 // --- Input and display state tracking ---
 bool suppress_mouse_input = false;
 bool piece_selected = false;
@@ -110,6 +130,17 @@ GameMode game_mode = VS_ENGINE;
 float evaluation = 0;
 int nodes = 0;
 float time_used = 0;
+int search_depth = 0;
+SearchStats search_stats; // --- Statistics of the engine's last finished search ---
+
+// --- What the engine is searching for in the background, if anything ---
+enum EngineTask
+{
+    ENGINE_IDLE,  // --- No search running ---
+    ENGINE_MOVE,  // --- Searching its own move, played by finish_engine_move() ---
+    ENGINE_HINTS  // --- Searching hint moves for the player, shown by show_engine_hints() ---
+};
+EngineTask engine_task = ENGINE_IDLE;
 
 // --- Puzzle Rush mode state ---
 struct PuzzleRushState
@@ -141,11 +172,19 @@ int main()
     al_install_mouse();    // Enable mouse input
     al_init_image_addon(); // Enable image loading support
 
+    // --- Initialize Allegro font and drawing addons ---
+    al_init_font_addon();
+    al_init_ttf_addon();
+    al_init_primitives_addon();
+
     // --- Create game window and event queue ---
     display = al_create_display(960, 960); // Set display size
     event_queue = al_create_event_queue(); // Create event queue for input and window events
 
     load_images(); // --- Load all piece and UI images into memory ---
+    load_fonts();  // --- Load every font size the UI uses ---
+    engine.set_book("files/book.bin"); // --- Opening book, if one has been built ---
+    engine.set_tablebase_path("files/tablebases"); // --- Endgame tables, opened as endgames are reached ---
 
     // --- Set display title and window icon ---
     al_set_window_title(display, "Chess");
@@ -171,6 +210,11 @@ int main()
     // --- Register additional event sources ---
     al_register_event_source(event_queue, al_get_display_event_source(display));
 
+    // --- Frame timer, used to follow background engine searches ---
+    timer = al_create_timer(1.0 / FPS);
+    al_register_event_source(event_queue, al_get_timer_event_source(timer));
+    al_start_timer(timer);
+
     // --- Main event/game loop ---
     while (true)
     {
@@ -190,6 +234,11 @@ int main()
         {
             redraw_screen = true; // Mark screen for redraw on mouse press
         }
+        // --- Follow the engine's background search ---
+        else if (ev.type == ALLEGRO_EVENT_TIMER)
+        {
+            poll_engine();
+        }
 
         // --- Redraw screen if needed and no pending events ---
         if (redraw_screen && al_is_event_queue_empty(event_queue))
@@ -202,8 +251,11 @@ int main()
     }
 
     // --- Cleanup resources before program exits ---
+    engine.cancel_search();
+    stop_puzzle_prefetch();
+    al_destroy_timer(timer);
     al_destroy_display(display);
-    al_destroy_bitmap(background_img);
+    destroy_assets();
     al_destroy_event_queue(event_queue);
 
     return 0;
@@ -236,20 +288,63 @@ void load_images()
     random_img = al_load_bitmap("pictures/random.png");
 }
 
+// --- Loads all fonts up front, so no screen has to open a TTF file while drawing ---
+void load_fonts()
+{
+    const int title_sizes[] = {140, 60, 42, 32, 28, 26, 24, 20};
+    for (int size : title_sizes)
+    {
+        get_font("files/gamefont2.ttf", size);
+    }
+    get_font("files/gamefont3.ttf", 30);
+}
+
+// --- Returns the font for a file and size, loading it the first time it is asked for ---
+ALLEGRO_FONT *get_font(const char *file, int size)
+{
+    std::pair<std::string, int> key(file, size);
+    std::map<std::pair<std::string, int>, ALLEGRO_FONT *>::iterator it = font_cache.find(key);
+    if (it != font_cache.end())
+    {
+        return it->second;
+    }
+
+    ALLEGRO_FONT *font = al_load_ttf_font(file, size, 0);
+    font_cache[key] = font;
+    return font;
+}
+
+// --- Frees the fonts, images and board cache at exit ---
+void destroy_assets()
+{
+    for (std::map<std::pair<std::string, int>, ALLEGRO_FONT *>::iterator it = font_cache.begin(); it != font_cache.end(); ++it)
+    {
+        if (it->second)
+            al_destroy_font(it->second);
+    }
+    font_cache.clear();
+
+    ALLEGRO_BITMAP *bitmaps[] = {background_img, icon_img, white_pawn_img, white_knight_img, white_bishop_img,
+                                 white_rook_img, white_queen_img, white_king_img, black_pawn_img, black_knight_img,
+                                 black_bishop_img, black_rook_img, black_queen_img, black_king_img, random_img,
+                                 board_cache};
+    for (ALLEGRO_BITMAP *bitmap : bitmaps)
+    {
+        if (bitmap)
+            al_destroy_bitmap(bitmap);
+    }
+    board_cache = NULL;
+}
+
 // --- Displays the main start menu and handles user selection of game mode ---
 void display_start_menu()
 {
     bool selection_made = false;
 
-    // --- Initialize Allegro font and drawing addons ---
-    al_init_font_addon();
-    al_init_ttf_addon();
-    al_init_primitives_addon();
-
     // --- Load fonts for title and options ---
-    ALLEGRO_FONT *title_font = al_load_ttf_font("files/gamefont2.ttf", 140, 0); // Large title
-    ALLEGRO_FONT *option_font = al_load_ttf_font("files/gamefont2.ttf", 60, 0); // Option labels
-    ALLEGRO_FONT *sign_font = al_load_ttf_font("files/gamefont3.ttf", 30, 0);   // Optional signature
+    ALLEGRO_FONT *title_font = get_font("files/gamefont2.ttf", 140); // Large title
+    ALLEGRO_FONT *option_font = get_font("files/gamefont2.ttf", 60); // Option labels
+    ALLEGRO_FONT *sign_font = get_font("files/gamefont3.ttf", 30);   // Optional signature
 
     // --- Draw background and translucent overlay ---
     al_draw_bitmap(background_img, 0, 0, 0);
@@ -293,9 +388,6 @@ void display_start_menu()
         if (ev.type == ALLEGRO_EVENT_DISPLAY_CLOSE)
         {
             // Cleanup on window close
-            al_destroy_font(title_font);
-            al_destroy_font(option_font);
-            al_destroy_font(sign_font);
             al_destroy_event_queue(tempQueue);
             al_destroy_display(display);
             exit(0);
@@ -380,9 +472,6 @@ void display_start_menu()
     }
 
     // --- Cleanup: destroy temporary resources ---
-    al_destroy_font(title_font);
-    al_destroy_font(option_font);
-    al_destroy_font(sign_font);
     al_destroy_event_queue(tempQueue);
 
     return;
@@ -400,6 +489,14 @@ void handle_mouse_events()
         return;                       // Skip this frame's input
     }
 
+    // --- Board is locked while the engine thinks; a right click makes it move now ---
+    if (engine_task != ENGINE_IDLE)
+    {
+        if (right_mouse_clicked())
+            engine.force_move();
+        return;
+    }
+
     // --- Handle Puzzle Mode: "Show Solution" button click ---
     if (game_mode == PUZZLE_MODE && ev.type == ALLEGRO_EVENT_MOUSE_BUTTON_UP && ev.mouse.x > 960)
     {
@@ -436,13 +533,11 @@ void handle_mouse_events()
         if (mx >= btn_x && mx <= btn_x + btn_w &&
             my >= btn_y && my <= btn_y + btn_h)
         {
-            top_white_moves = engine.get_best_white_moves(board.get_position());
-            draw_screen();
-            al_clear_to_color(al_map_rgb(0, 0, 0));  
-            draw_screen();
-            al_flip_display();
-            // Clear after drawing to show once
-            top_white_moves.clear();
+            // --- Search in the background; show_engine_hints() draws the result ---
+            start_time = clock();
+            engine.search_hints_async(board.get_position());
+            engine_task = ENGINE_HINTS;
+            redraw_screen = true;
             return;
         }
     }
@@ -509,7 +604,7 @@ char select_player()
     int box_y = (960 - box_size) / 2;
 
     // --- Load font for title text ---
-    ALLEGRO_FONT *title_font = al_load_ttf_font("files/gamefont2.ttf", 32, 0);
+    ALLEGRO_FONT *title_font = get_font("files/gamefont2.ttf", 32);
 
     // --- Define selection types and their corresponding images ---
     const char side_codes[3] = {'W', 'R', 'B'}; // White, Random, Black
@@ -583,25 +678,91 @@ char select_player()
     }
 
     // --- Cleanup: destroy temporary resources ---
-    al_destroy_font(title_font);
     al_destroy_event_queue(tempQueue);
 
     return selected;
 }
 
-// --- Executes engine's move based on current turn (White or Black) ---
+// --- Starts the engine's search for the current turn (White or Black) ---
+// --- The search runs in the background; poll_engine() plays the move once it is found ---
 void perform_engine_move()
 {
     start_time = clock();
+    search_depth = 0;
 
-    // --- Generate the best move from engine for the current turn ---
-    EngineMove move = (turn == WHITE)
-                          ? engine.make_white_move(board.get_position())
-                          : engine.make_black_move(board.get_position());
+    engine.search_async(board.get_position(), turn);
+    engine_task = ENGINE_MOVE;
+    redraw_screen = true;
+}
+
+// --- Called on every timer tick: shows live search progress and collects finished results ---
+void poll_engine()
+{
+    // --- Nothing left to ponder on once the game is over ---
+    if (game_over && engine.is_pondering())
+        engine.cancel_search();
+
+    if (engine_task == ENGINE_IDLE)
+        return;
+
+    if (engine.searching())
+    {
+        // --- Live "thinking" eval, once the first iteration has produced one ---
+        // --- A new depth is shown at once, the node and time counters only every few ticks ---
+        SearchInfo info = engine.get_search_info();
+        if (info.depth > 0 && (info.depth != search_depth || info.eval != evaluation))
+        {
+            evaluation = info.eval;
+            search_depth = info.depth;
+            redraw_screen = true;
+        }
+        if (ev.timer.count % SEARCH_REDRAW_TICKS == 0)
+        {
+            redraw_screen = true;
+        }
+        if (redraw_screen)
+        {
+            nodes = (int)info.nodes;
+            time_used = (float)((int)(float(clock() - start_time))) / 1000;
+        }
+        return;
+    }
+
+    EngineTask finished = engine_task;
+    engine_task = ENGINE_IDLE;
+
+    if (finished == ENGINE_MOVE)
+        finish_engine_move();
+    else
+        show_engine_hints();
+}
+
+// --- Draws the hint moves once; the next redraw removes them again ---
+void show_engine_hints()
+{
+    top_white_moves = engine.finish_hints();
+    if (!top_white_moves.empty())
+        search_stats = top_white_moves.front().stats;
+    time_used = (float)((int)(float(clock() - start_time))) / 1000;
+
+    al_clear_to_color(al_map_rgb(0, 0, 0));
+    draw_screen();
+    al_flip_display();
+
+    // Clear after drawing to show once
+    top_white_moves.clear();
+    redraw_screen = false;
+}
+
+// --- Plays the move found by the background search and switches turn ---
+void finish_engine_move()
+{
+    EngineMove move = engine.finish_move(board.get_position());
 
     // --- Save evaluation info for UI/analysis ---
     evaluation = move.eval;
     nodes = move.nodes;
+    search_stats = move.stats;
 
     // --- Store move notation and update internal state ---
     move_history.push_back(move.notation);
@@ -639,9 +800,14 @@ void perform_engine_move()
     }
 
     // --- Finalize engine move and switch turn ---
-    board.reset_en_passant(turn);
+    // --- Learning mode clears White's flags instead, keeping en passant against the engine ---
+    board.reset_en_passant(game_mode == LEARNING_MODE ? WHITE : turn);
     turn = (turn == WHITE ? BLACK : WHITE);
     piece_selected = false;
+
+    // --- Think on the player's time; perform_engine_move() picks the search up on a hit ---
+    if (game_mode == VS_ENGINE)
+        engine.ponder_async(board.get_position(), turn);
 }
 
 // --- Handles player interaction and alternating engine response in vs-engine mode ---
@@ -974,6 +1140,7 @@ void handle_puzzle_mode_moves()
                     {
                         puzzleRush.time_elapsed = (float)(clock() - puzzleRush.start_time) / CLOCKS_PER_SEC;
                         puzzleRush.active = false;
+                        stop_puzzle_prefetch();
 
                         // --- Load high score ---
                         int saved_score = 0;
@@ -1050,15 +1217,16 @@ void handle_puzzle_mode_moves()
 // --- Initializes and starts a new Puzzle Rush session ---
 void handle_puzzle_rush()
 {
-    // --- Start the puzzle rush timer ---
-    puzzleRush.start_time = clock();
+    // --- Keep the next puzzles loaded in the background, so loading never counts against the clock ---
+    start_puzzle_prefetch();
 
     // --- Initialize lives and activate puzzle rush mode ---
     puzzleRush.lives = 3;
     puzzleRush.active = true;
 
-    // --- Load and setup the first puzzle on the board ---
+    // --- Load the first puzzle, then start the puzzle rush timer and set it up on the board ---
     start_puzzle();
+    puzzleRush.start_time = clock();
     setup_puzzle_on_board();
 }
 
@@ -1124,48 +1292,10 @@ void handle_Learning_mode()
                 turn = BLACK;
                 piece_selected = false;
 
-                // --- Let the engine play as Black ---
+                // --- Let the engine play as Black (in the background, like VS Engine) ---
                 if (!game_over)
                 {
-                    // --- Start engine move timer ---
-                    start_time = clock();
-
-                    // --- Engine makes Black move ---
-                    EngineMove move = engine.make_black_move(board.get_position());
-                    evaluation = move.eval;
-                    nodes = move.nodes;
-                    move_history.push_back(move.notation);
-
-                    // --- Prepare for animation/selection of engine move ---
-                    selected_square_i = move.from_i;
-                    selected_square_j = move.from_j;
-                    i = move.to_i;
-                    j = move.to_j;
-                    piece_selected = true;
-
-                    if (!user_scrolled)
-                        move_history_offset = std::max(0, ((int)move_history.size() + 1) / 2 - MAX_VISIBLE_MOVES);
-                    user_scrolled = false;
-
-                    // --- Track engine move time ---
-                    time_used = (float)((int)(float(clock() - start_time))) / 1000;
-
-                    // --- Refresh screen ---
-                    al_clear_to_color(al_map_rgb(0, 0, 0));
-                    draw_screen();
-                    al_flip_display();
-
-                    // --- Check for checkmate after Black move ---
-                    if (board.king_is_in_check(WHITE) && board.is_checkmate(WHITE))
-                    {
-                        pop_message("Game Over", "Black Wins!", 1);
-                        game_over = true;
-                    }
-
-                    // --- Switch back to White's turn ---
-                    board.reset_en_passant(WHITE);
-                    turn = WHITE;
-                    piece_selected = false;
+                    perform_engine_move();
                 }
             }
             else
@@ -1218,8 +1348,8 @@ void select_puzzle_mode()
     int mode_start_x = (960 - (num_modes * box_size + (num_modes - 1) * padding)) / 2;
     int mode_y = diff_y + 240;
 
-    ALLEGRO_FONT *title_font = al_load_ttf_font("files/gamefont2.ttf", 32, 0);
-    ALLEGRO_FONT *font = al_load_ttf_font("files/gamefont3.ttf", 30, 0);
+    ALLEGRO_FONT *title_font = get_font("files/gamefont2.ttf", 32);
+    ALLEGRO_FONT *font = get_font("files/gamefont3.ttf", 30);
 
     // --- Draw difficulty title and buttons ---
     al_draw_text(title_font, al_map_rgb(255, 255, 255), 960 / 2, diff_y - 60, ALLEGRO_ALIGN_CENTER, "Select Difficulty Level:");
@@ -1276,8 +1406,6 @@ void select_puzzle_mode()
                     if (strcmp(modes[i], "Rush") == 0)
                     {
                         game_mode = PUZZLE_RUSH;
-                        al_destroy_font(title_font);
-                        al_destroy_font(font);
                         al_destroy_event_queue(tempQueue);
                         handle_puzzle_rush();
                         return;
@@ -1285,8 +1413,6 @@ void select_puzzle_mode()
                     else if (strcmp(modes[i], "WildStart") == 0)
                     {
                         game_mode = PUZZLE_ENDGAME;
-                        al_destroy_font(title_font);
-                        al_destroy_font(font);
                         al_destroy_event_queue(tempQueue);
                         handle_endgame_puzzle();
                         return;
@@ -1301,8 +1427,6 @@ void select_puzzle_mode()
     }
 
     // --- Cleanup: destroy temporary resources ---
-    al_destroy_font(title_font);
-    al_destroy_font(font);
     al_destroy_event_queue(tempQueue);
 
     if (!load_puzzle_by_difficulty(difficulty))
@@ -1352,8 +1476,137 @@ void setup_puzzle_on_board()
     }
 }
 
+// --- Everything draw_board_layer() depends on; the cached board is redrawn when it changes ---
+string board_layer_key()
+{
+    string key;
+    key.reserve(96);
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            key += board.get_piece(i, j);
+        }
+    }
+
+    if (piece_selected)
+    {
+        key += (char)('0' + selected_square_i);
+        key += (char)('0' + selected_square_j);
+        key += (char)('0' + i);
+        key += (char)('0' + j);
+    }
+
+    if (game_mode == LEARNING_MODE)
+    {
+        for (size_t idx = 0; idx < top_white_moves.size() && idx < 3; ++idx)
+        {
+            const EngineMove &move = top_white_moves[idx];
+            key += (char)('0' + move.from_i);
+            key += (char)('0' + move.from_j);
+            key += (char)('0' + move.to_i);
+            key += (char)('0' + move.to_j);
+        }
+    }
+    return key;
+}
+
 // --- Draws the entire chess screen, including board, pieces, highlights, UI, and overlays ---
 void draw_screen()
+{
+    // --- The cache is a display bitmap; the menus may have replaced the display since it was made ---
+    if (board_cache && board_cache_display != display)
+    {
+        al_destroy_bitmap(board_cache);
+        board_cache = NULL;
+    }
+    if (!board_cache)
+    {
+        board_cache = al_create_bitmap(960, 960);
+        board_cache_display = display;
+        board_cache_key.clear();
+    }
+
+    // --- Board, highlights and pieces, re-rendered only when the position or highlights changed ---
+    string key = board_layer_key();
+    if (!board_cache)
+    {
+        draw_board_layer();
+    }
+    else
+    {
+        if (key != board_cache_key || board_cache_key.empty())
+        {
+            ALLEGRO_BITMAP *target = al_get_target_bitmap();
+            al_set_target_bitmap(board_cache);
+            al_clear_to_color(al_map_rgb(0, 0, 0));
+            draw_board_layer();
+            al_set_target_bitmap(target);
+            board_cache_key = key;
+        }
+        al_draw_bitmap(board_cache, 0, 0, 0);
+    }
+
+    // --- Principal variation of each hint, in its border colour, along the top of the board ---
+    if (game_mode == LEARNING_MODE && !top_white_moves.empty())
+    {
+        ALLEGRO_COLOR border_colors[3] = {
+            al_map_rgb(255, 102, 102), // Red border
+            al_map_rgb(102, 255, 102), // Green border
+            al_map_rgb(255, 255, 102)  // Yellow border
+        };
+
+        ALLEGRO_FONT *pv_font = get_font("files/gamefont2.ttf", 20);
+        if (pv_font)
+        {
+            size_t shown = std::min<size_t>(top_white_moves.size(), 3);
+            al_draw_filled_rectangle(0, 0, 960, 8 + 24 * shown, al_map_rgba(0, 0, 0, 160));
+            for (size_t idx = 0; idx < shown; ++idx)
+            {
+                const EngineMove &move = top_white_moves[idx];
+                char header[40];
+                snprintf(header, sizeof(header), "%s (%.2f):", move.notation.c_str(), move.eval);
+                std::string line = header;
+                for (size_t k = 0; k < move.pv.size() && k < 10; ++k)
+                    line += " " + move_to_uci(move.pv[k]);
+
+                al_draw_text(pv_font, border_colors[idx], 10, 4 + 24 * idx, ALLEGRO_ALIGN_LEFT, line.c_str());
+            }
+        }
+    }
+
+    // --- Draw move history and evaluation bar if needed ---
+    draw_move_history(ev);
+
+    if (game_mode == VS_ENGINE || game_mode == LEARNING_MODE)
+    {
+        draw_evaluation_bar();
+
+        // --- Draw 'Hint' button in Learning Mode ---
+        if (game_mode == LEARNING_MODE)
+        {
+            ALLEGRO_FONT *font = get_font("files/gamefont2.ttf", 28);
+
+            al_draw_filled_rounded_rectangle(
+                btn_x, btn_y,
+                btn_x + btn_w, btn_y + btn_h,
+                10, 10, al_map_rgb(70, 70, 70));
+
+            al_draw_text(font, al_map_rgb(255, 255, 255),
+                         btn_x + btn_w / 2, btn_y + 8,
+                         ALLEGRO_ALIGN_CENTER, "Hint");
+        }
+    }
+
+    // --- Draw puzzle details in Puzzle Mode or Puzzle Rush, search statistics against the engine ---
+    if (game_mode == PUZZLE_MODE || game_mode == PUZZLE_RUSH || game_mode == VS_ENGINE)
+    {
+        draw_details();
+    }
+}
+
+// --- Draws the board, hint and selection highlights, and pieces to the current target bitmap ---
+void draw_board_layer()
 {
     // --- Draw background image ---
     al_draw_bitmap(background_img, 0, 0, 0);
@@ -1440,37 +1693,6 @@ void draw_screen()
             }
         }
     }
-
-    // --- Draw move history and evaluation bar if needed ---
-    draw_move_history(ev);
-
-    if (game_mode == VS_ENGINE || game_mode == LEARNING_MODE)
-    {
-        draw_evaluation_bar();
-
-        // --- Draw 'Hint' button in Learning Mode ---
-        if (game_mode == LEARNING_MODE)
-        {
-            ALLEGRO_FONT *font = al_load_ttf_font("files/gamefont2.ttf", 28, 0);
-
-            al_draw_filled_rounded_rectangle(
-                btn_x, btn_y,
-                btn_x + btn_w, btn_y + btn_h,
-                10, 10, al_map_rgb(70, 70, 70));
-
-            al_draw_text(font, al_map_rgb(255, 255, 255),
-                         btn_x + btn_w / 2, btn_y + 8,
-                         ALLEGRO_ALIGN_CENTER, "Hint");
-
-            al_destroy_font(font);
-        }
-    }
-
-    // --- Draw puzzle details if in Puzzle Mode or Puzzle Rush ---
-    if (game_mode == PUZZLE_MODE || game_mode == PUZZLE_RUSH)
-    {
-        draw_details();
-    }
 }
 
 // --- Draws a chess piece on the board at grid position (i, j) ---
@@ -1540,7 +1762,7 @@ char show_promotion_menu(bool is_white)
     const int box_y = (screen_height - box_size) / 2;
 
     // --- Load font for the title text ---
-    ALLEGRO_FONT *title_font = al_load_ttf_font("files/gamefont2.ttf", 32, 0);
+    ALLEGRO_FONT *title_font = get_font("files/gamefont2.ttf", 32);
 
     // --- Set up mouse and display event queue ---
     ALLEGRO_EVENT_QUEUE *temp_queue = al_create_event_queue();
@@ -1624,7 +1846,6 @@ char show_promotion_menu(bool is_white)
     }
 
     // --- Cleanup ---
-    al_destroy_font(title_font);
     al_destroy_event_queue(temp_queue);
 
     return selected;
@@ -1634,8 +1855,8 @@ char show_promotion_menu(bool is_white)
 void draw_move_history(ALLEGRO_EVENT ev)
 {
     // --- Load fonts for title and move text ---
-    ALLEGRO_FONT *title_font = al_load_ttf_font("files/gamefont2.ttf", 32, 0);
-    ALLEGRO_FONT *move_font = al_load_ttf_font("files/gamefont2.ttf", 26, 0);
+    ALLEGRO_FONT *title_font = get_font("files/gamefont2.ttf", 32);
+    ALLEGRO_FONT *move_font = get_font("files/gamefont2.ttf", 26);
 
     // --- Layout configuration ---
     int start_x = 980;
@@ -1717,17 +1938,13 @@ void draw_move_history(ALLEGRO_EVENT ev)
         move_number++;
         y += line_spacing;
     }
-
-    // --- Free resources ---
-    al_destroy_font(title_font);
-    al_destroy_font(move_font);
 }
 
 // --- Draws a horizontal evaluation bar at the bottom of the screen ---
 void draw_evaluation_bar()
 {
     // --- Load font for text labels ---
-    ALLEGRO_FONT *font = al_load_ttf_font("files/gamefont2.ttf", 24, 0);
+    ALLEGRO_FONT *font = get_font("files/gamefont2.ttf", 24);
 
     // --- Position and size settings ---
     int start_x = 0;
@@ -1757,8 +1974,12 @@ void draw_evaluation_bar()
     al_draw_rectangle(start_x, start_y, start_x + bar_width, start_y + bar_height, al_map_rgb(200, 200, 200), 5);
 
     // --- Prepare evaluation, node count, and time strings ---
+    // --- While the engine searches, the score of its best move so far is shown ---
     char eval_text[30];
-    snprintf(eval_text, sizeof(eval_text), "Evaluation: %.2f", evaluation);
+    if (engine_task != ENGINE_IDLE)
+        snprintf(eval_text, sizeof(eval_text), "Thinking (%d): %.2f", search_depth, evaluation);
+    else
+        snprintf(eval_text, sizeof(eval_text), "Evaluation: %.2f", evaluation);
 
     char nodes_text[30];
     snprintf(nodes_text, sizeof(nodes_text), "Nodes : %d", nodes);
@@ -1771,15 +1992,46 @@ void draw_evaluation_bar()
     al_draw_text(font, al_map_rgb(255, 255, 255), start_x + bar_width + 20, start_y - 29, ALLEGRO_ALIGN_LEFT, time_text);
     al_draw_text(font, al_map_rgb(255, 255, 255), start_x + bar_width + 20, start_y + 12, ALLEGRO_ALIGN_LEFT, eval_text);
 
-    // --- Clean up font resources ---
-    al_destroy_font(font);
+}
+
+// --- Draws the statistics of the engine's last search below the move history ---
+void draw_search_stats()
+{
+    if (search_stats.depth == 0)
+        return;
+
+    ALLEGRO_FONT *font = get_font("files/gamefont2.ttf", 20);
+    if (!font)
+        return;
+
+    int x = 980;
+    int y = 792;
+    char line[4][60];
+    snprintf(line[0], sizeof(line[0]), "Depth %d   EBF %.1f   First cut %.0f%%", search_stats.depth,
+             search_stats.branching_factor, search_stats.fail_high_first_rate() * 100);
+    snprintf(line[1], sizeof(line[1]), "TT hits %.0f%%   TT cutoffs %ld", search_stats.tt_hit_rate() * 100, search_stats.tt_cutoffs);
+    snprintf(line[2], sizeof(line[2]), "Quiescence %.0f%% of nodes",
+             search_stats.nodes > 0 ? 100.0 * search_stats.qnodes / search_stats.nodes : 0.0);
+    snprintf(line[3], sizeof(line[3]), "Movegen %.0f  Eval %.0f  Search %.0f ms", search_stats.movegen.estimated_ms(),
+             search_stats.eval.estimated_ms(), search_stats.search_ms(engine.get_threads()));
+
+    for (int k = 0; k < 4; k++)
+        al_draw_text(font, al_map_rgb(200, 200, 200), x, y + k * 22, ALLEGRO_ALIGN_LEFT, line[k]);
+
 }
 
 // --- Draws puzzle-related details and UI elements in the right panel ---
+// --- Against the engine the panel shows the last search's statistics instead ---
 void draw_details()
 {
+    if (game_mode == VS_ENGINE)
+    {
+        draw_search_stats();
+        return;
+    }
+
     // --- Load font for text display ---
-    ALLEGRO_FONT *font = al_load_ttf_font("files/gamefont2.ttf", 28, 0);
+    ALLEGRO_FONT *font = get_font("files/gamefont2.ttf", 28);
     if (!font)
         return;
 
@@ -1817,8 +2069,6 @@ void draw_details()
         al_draw_text(font, al_map_rgb(255, 255, 255), x + 10, y - 110, 0, score.c_str());
     }
 
-    // --- Clean up font resources ---
-    al_destroy_font(font);
 }
 
 // --- Reusable pop-up message with optional action buttons ---
@@ -1834,8 +2084,8 @@ void pop_message(const string &title, const string &message, int type)
     int box_y = (screen_height - box_height) / 2;
 
     // --- Load fonts for title and message ---
-    ALLEGRO_FONT *title_font = al_load_ttf_font("files/gamefont2.ttf", 42, 0);
-    ALLEGRO_FONT *text_font = al_load_ttf_font("files/gamefont2.ttf", 26, 0);
+    ALLEGRO_FONT *title_font = get_font("files/gamefont2.ttf", 42);
+    ALLEGRO_FONT *text_font = get_font("files/gamefont2.ttf", 26);
 
     // --- Prepare multiline message drawing ---
     int line_height = al_get_font_line_height(text_font);
@@ -1974,8 +2224,6 @@ void pop_message(const string &title, const string &message, int type)
     }
 
     // --- Cleanup ---
-    al_destroy_font(title_font);
-    al_destroy_font(text_font);
     al_destroy_event_queue(temp_queue);
 }
 
@@ -0,0 +1,131 @@
+// --------------------------------------------------------------------------------------
+// mappedfile.cpp
+// --- Implements MappedFile with CreateFileMapping on Windows and mmap elsewhere.
+// --------------------------------------------------------------------------------------
+
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : bytes(NULL), length(0)
+{
+#ifdef _WIN32
+    file_handle = INVALID_HANDLE_VALUE;
+    mapping_handle = NULL;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &path)
+{
+    close();
+
+    file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+
+    mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping_handle == NULL)
+    {
+        close();
+        return false;
+    }
+
+    bytes = (const unsigned char *)MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (bytes == NULL)
+    {
+        close();
+        return false;
+    }
+
+    length = (size_t)file_size.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (bytes)
+    {
+        UnmapViewOfFile(bytes);
+    }
+    if (mapping_handle)
+    {
+        CloseHandle(mapping_handle);
+    }
+    if (file_handle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file_handle);
+    }
+
+    bytes = NULL;
+    length = 0;
+    file_handle = INVALID_HANDLE_VALUE;
+    mapping_handle = NULL;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // --- The mapping stays valid after the descriptor is closed ---
+    void *mapping = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    bytes = (const unsigned char *)mapping;
+    length = (size_t)info.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (bytes)
+    {
+        munmap((void *)bytes, length);
+    }
+    bytes = NULL;
+    length = 0;
+}
+
+#endif
@@ -0,0 +1,44 @@
+// --------------------------------------------------------------------------------------
+// mappedfile.h
+// --- Declares MappedFile, a read-only memory mapping of a whole file.
+// --- Large data files (the binary puzzle database) are mapped instead of read, so
+// --- opening them costs nothing up front and only the pages actually touched are
+// --- loaded by the operating system.
+// --------------------------------------------------------------------------------------
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+class MappedFile
+{
+private:
+    const unsigned char *bytes; // --- Start of the mapping, NULL if nothing is mapped ---
+    size_t length;              // --- Size of the file in bytes ---
+#ifdef _WIN32
+    void *file_handle;
+    void *mapping_handle;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // --- Maps the file read-only, replacing any earlier mapping; false if it cannot be mapped ---
+    bool open(const std::string &path);
+
+    // --- Unmaps the file ---
+    void close();
+
+    bool is_open() const { return bytes != NULL; }
+    const unsigned char *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+};
+
+#endif
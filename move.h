@@ -0,0 +1,43 @@
+// --------------------------------------------------------------------------------------
+// move.h
+// --- Declares the compact 16-bit move encoding shared by the position, move generator
+// --- and search: origin square, target square and a 4-bit flag telling captures,
+// --- castling, en passant, double pushes and promotions apart.
+// --------------------------------------------------------------------------------------
+
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <cstdint>
+
+// --- Encoded move: bits 0-5 origin, bits 6-11 target, bits 12-15 flag ---
+typedef uint16_t Move;
+const Move NO_MOVE = 0;
+
+// --- Move flags (bit 2 marks captures, bit 3 marks promotions) ---
+const int QUIET_MOVE = 0;
+const int DOUBLE_PAWN_PUSH = 1;
+const int KING_CASTLE = 2;
+const int QUEEN_CASTLE = 3;
+const int CAPTURE = 4;
+const int EN_PASSANT_CAPTURE = 5;
+const int KNIGHT_PROMOTION = 8;
+const int BISHOP_PROMOTION = 9;
+const int ROOK_PROMOTION = 10;
+const int QUEEN_PROMOTION = 11;
+const int KNIGHT_PROMOTION_CAPTURE = 12;
+const int BISHOP_PROMOTION_CAPTURE = 13;
+const int ROOK_PROMOTION_CAPTURE = 14;
+const int QUEEN_PROMOTION_CAPTURE = 15;
+
+// --- Move encoding helpers ---
+inline Move encode_move(int from, int to, int flag) { return (Move)(from | (to << 6) | (flag << 12)); }
+inline int move_from(Move m) { return m & 63; }
+inline int move_to(Move m) { return (m >> 6) & 63; }
+inline int move_flag(Move m) { return m >> 12; }
+inline bool is_capture(Move m) { return (move_flag(m) & CAPTURE) != 0; }
+inline bool is_promotion(Move m) { return (move_flag(m) & 8) != 0; }
+// --- Promoted piece as a piece_type index (KNIGHT + 0..3) ---
+inline int promotion_index(Move m) { return 1 + (move_flag(m) & 3); }
+
+#endif
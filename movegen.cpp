@@ -0,0 +1,445 @@
+// --------------------------------------------------------------------------------------
+// movegen.cpp
+// --- Implements the shared pseudo-legal move generator.
+// --- Pawn moves are generated set-wise by shifting the pawn bitboard, piece moves by
+// --- looking attacks up in the tables from attacks.h.
+// --- The generator is templated on the side, so pawn directions, special ranks and
+// --- castling squares are constants in each colour's copy.
+// --------------------------------------------------------------------------------------
+
+#include "movegen.h"
+#include "attacks.h"
+#include <cstring>
+
+// --- Shifts a bitboard by a signed number of squares known at compile time ---
+// --- (the masks keep the branch not taken from shifting by a negative count) ---
+template <int Delta>
+static inline Bitboard shift(Bitboard b)
+{
+    return Delta > 0 ? b << (Delta & 63) : b >> (-Delta & 63);
+}
+
+// --- Adds the four promotions of one pawn move, queen first ---
+static inline void add_promotions(MoveList &list, int from, int to, bool capture)
+{
+    int base = capture ? KNIGHT_PROMOTION_CAPTURE : KNIGHT_PROMOTION;
+    list.add(encode_move(from, to, base + 3));
+    list.add(encode_move(from, to, base + 2));
+    list.add(encode_move(from, to, base + 1));
+    list.add(encode_move(from, to, base));
+}
+
+// --- Adds pawn moves for all targets in a set, given the origin offset ---
+template <int Delta>
+static inline void add_pawn_moves(MoveList &list, Bitboard targets, int flag, Bitboard promotion_rank)
+{
+    while (targets)
+    {
+        int to = pop_lsb(targets);
+        int from = to - Delta;
+
+        if (square_bb(to) & promotion_rank)
+        {
+            add_promotions(list, from, to, flag == CAPTURE);
+        }
+        else
+        {
+            list.add(encode_move(from, to, flag));
+        }
+    }
+}
+
+// --- Adds one move per target square, flagging captures ---
+static inline void add_piece_moves(MoveList &list, int from, Bitboard targets, Bitboard enemy)
+{
+    while (targets)
+    {
+        int to = pop_lsb(targets);
+        list.add(encode_move(from, to, (square_bb(to) & enemy) ? CAPTURE : QUIET_MOVE));
+    }
+}
+
+// --- Shared body of generate_moves and generate_captures for side S ---
+// --- With CapturesOnly set, quiet moves are left out except pawn pushes that promote ---
+template <side S, bool CapturesOnly>
+static void generate(const Position &pos, MoveList &list)
+{
+    const side them = opposite(S);
+    Bitboard enemy = pos.occupancy[them];
+    Bitboard empty = ~pos.occupied;
+    Bitboard targets = CapturesOnly ? enemy : ~pos.occupancy[S];
+
+    // --- Pawn directions and special ranks for this side ---
+    const int up = pawn_push<S>();
+    const Bitboard promotion_rank = relative_rank_bb<S>(7);
+    const Bitboard double_push_target = relative_rank_bb<S>(3);
+
+    // --- Pawn pushes ---
+    Bitboard pawns = pos.pieces[S][PAWN];
+    Bitboard single_push = shift<up>(pawns) & empty;
+    Bitboard double_push = shift<up>(single_push) & empty & double_push_target;
+
+    if (CapturesOnly)
+    {
+        single_push &= promotion_rank;
+        double_push = 0;
+    }
+
+    add_pawn_moves<up>(list, single_push, QUIET_MOVE, promotion_rank);
+    add_pawn_moves<2 * up>(list, double_push, DOUBLE_PAWN_PUSH, 0);
+
+    // --- Pawn captures towards the a-file and towards the h-file ---
+    Bitboard left = shift<up - 1>(pawns & ~FILE_A_BB) & enemy;
+    Bitboard right = shift<up + 1>(pawns & ~FILE_H_BB) & enemy;
+
+    add_pawn_moves<up - 1>(list, left, CAPTURE, promotion_rank);
+    add_pawn_moves<up + 1>(list, right, CAPTURE, promotion_rank);
+
+    // --- En passant ---
+    if (pos.en_passant != NO_SQUARE)
+    {
+        Bitboard capturers = Attacks::pawn(them, pos.en_passant) & pawns;
+        while (capturers)
+        {
+            list.add(encode_move(pop_lsb(capturers), pos.en_passant, EN_PASSANT_CAPTURE));
+        }
+    }
+
+    // --- Knights ---
+    Bitboard b = pos.pieces[S][KNIGHT];
+    while (b)
+    {
+        int from = pop_lsb(b);
+        add_piece_moves(list, from, Attacks::knight(from) & targets, enemy);
+    }
+
+    // --- Bishops ---
+    b = pos.pieces[S][BISHOP];
+    while (b)
+    {
+        int from = pop_lsb(b);
+        add_piece_moves(list, from, Attacks::bishop(from, pos.occupied) & targets, enemy);
+    }
+
+    // --- Rooks ---
+    b = pos.pieces[S][ROOK];
+    while (b)
+    {
+        int from = pop_lsb(b);
+        add_piece_moves(list, from, Attacks::rook(from, pos.occupied) & targets, enemy);
+    }
+
+    // --- Queens ---
+    b = pos.pieces[S][QUEEN];
+    while (b)
+    {
+        int from = pop_lsb(b);
+        add_piece_moves(list, from, Attacks::queen(from, pos.occupied) & targets, enemy);
+    }
+
+    // --- King ---
+    if (!pos.pieces[S][KING])
+    {
+        return;
+    }
+    int king = pos.king_square(S);
+    add_piece_moves(list, king, Attacks::king(king) & targets, enemy);
+
+    if (CapturesOnly)
+    {
+        return;
+    }
+
+    // --- Castling: path empty, king not in check and not passing through an attacked square ---
+    const int kingside = S == WHITE ? WHITE_KINGSIDE : BLACK_KINGSIDE;
+    const int queenside = S == WHITE ? WHITE_QUEENSIDE : BLACK_QUEENSIDE;
+    const int home = relative_square<S>(4);
+
+    if ((pos.castling & (kingside | queenside)) && king == home && !pos.is_attacked(home, them))
+    {
+        if ((pos.castling & kingside) &&
+            !(pos.occupied & (square_bb(home + 1) | square_bb(home + 2))) &&
+            !pos.is_attacked(home + 1, them) && !pos.is_attacked(home + 2, them))
+        {
+            list.add(encode_move(home, home + 2, KING_CASTLE));
+        }
+        if ((pos.castling & queenside) &&
+            !(pos.occupied & (square_bb(home - 1) | square_bb(home - 2) | square_bb(home - 3))) &&
+            !pos.is_attacked(home - 1, them) && !pos.is_attacked(home - 2, them))
+        {
+            list.add(encode_move(home, home - 2, QUEEN_CASTLE));
+        }
+    }
+}
+
+template <side S>
+void generate_moves(const Position &pos, MoveList &list)
+{
+    generate<S, false>(pos, list);
+}
+
+template <side S>
+void generate_captures(const Position &pos, MoveList &list)
+{
+    generate<S, true>(pos, list);
+}
+
+template void generate_moves<WHITE>(const Position &pos, MoveList &list);
+template void generate_moves<BLACK>(const Position &pos, MoveList &list);
+template void generate_captures<WHITE>(const Position &pos, MoveList &list);
+template void generate_captures<BLACK>(const Position &pos, MoveList &list);
+
+// --- Appends every pseudo-legal move of side s to the list ---
+void generate_moves(const Position &pos, side s, MoveList &list)
+{
+    if (s == WHITE)
+        generate_moves<WHITE>(pos, list);
+    else
+        generate_moves<BLACK>(pos, list);
+}
+
+// --- Appends only the pseudo-legal captures and promotions of side s ---
+void generate_captures(const Position &pos, side s, MoveList &list)
+{
+    if (s == WHITE)
+        generate_captures<WHITE>(pos, list);
+    else
+        generate_captures<BLACK>(pos, list);
+}
+
+// --- Coordinate notation of a move, promotion piece in lower case (e.g. e7e8q) ---
+std::string move_to_uci(Move m)
+{
+    std::string text;
+    text += (char)('a' + move_from(m) % 8);
+    text += (char)('1' + move_from(m) / 8);
+    text += (char)('a' + move_to(m) % 8);
+    text += (char)('1' + move_to(m) / 8);
+    if (is_promotion(m))
+    {
+        text += "pnbrqk"[promotion_index(m)];
+    }
+    return text;
+}
+
+// --- Matches the text against every pseudo-legal move, then checks the match is legal ---
+Move parse_uci_move(Position &pos, const std::string &text)
+{
+    MoveList moves;
+    generate_moves(pos, pos.to_move, moves);
+
+    for (int k = 0; k < moves.count; k++)
+    {
+        if (move_to_uci(moves.moves[k]) != text)
+        {
+            continue;
+        }
+
+        side us = pos.to_move;
+        Undo undo;
+        pos.make_move(moves.moves[k], undo);
+        bool legal = !pos.in_check(us);
+        pos.unmake_move(moves.moves[k], undo);
+        return legal ? moves.moves[k] : NO_MOVE;
+    }
+    return NO_MOVE;
+}
+
+// --- True if the pseudo-legal move m does not leave the mover's king in check ---
+static bool is_legal(Position &pos, Move m)
+{
+    side us = pos.to_move;
+    Undo undo;
+    pos.make_move(m, undo);
+    bool legal = !pos.in_check(us);
+    pos.unmake_move(m, undo);
+    return legal;
+}
+
+static bool has_legal_move(Position &pos)
+{
+    MoveList moves;
+    generate_moves(pos, pos.to_move, moves);
+    for (int k = 0; k < moves.count; k++)
+    {
+        if (is_legal(pos, moves.moves[k]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- Piece letters by piece_type, as SAN writes them ---
+static const char SAN_PIECES[] = "PNBRQK";
+
+std::string move_to_san(Position &pos, Move m)
+{
+    int from = move_from(m);
+    int to = move_to(m);
+    char piece = pos.squares[from];
+    piece_type pt = type_of(piece);
+
+    std::string text;
+    if (move_flag(m) == KING_CASTLE)
+    {
+        text = "O-O";
+    }
+    else if (move_flag(m) == QUEEN_CASTLE)
+    {
+        text = "O-O-O";
+    }
+    else
+    {
+        if (pt == PAWN)
+        {
+            if (is_capture(m))
+            {
+                text += (char)('a' + from % 8);
+            }
+        }
+        else
+        {
+            text += SAN_PIECES[pt];
+
+            // --- Another piece of the same kind reaching the target: name the origin file,
+            // --- else its rank, else both ---
+            bool ambiguous = false, same_file = false, same_rank = false;
+            MoveList moves;
+            generate_moves(pos, pos.to_move, moves);
+            for (int k = 0; k < moves.count; k++)
+            {
+                Move other = moves.moves[k];
+                int other_from = move_from(other);
+                if (move_to(other) != to || other_from == from || pos.squares[other_from] != piece || !is_legal(pos, other))
+                {
+                    continue;
+                }
+                ambiguous = true;
+                same_file = same_file || other_from % 8 == from % 8;
+                same_rank = same_rank || other_from / 8 == from / 8;
+            }
+            if (ambiguous && (!same_file || same_rank))
+            {
+                text += (char)('a' + from % 8);
+            }
+            if (ambiguous && same_file)
+            {
+                text += (char)('1' + from / 8);
+            }
+        }
+
+        if (is_capture(m))
+        {
+            text += 'x';
+        }
+        text += (char)('a' + to % 8);
+        text += (char)('1' + to / 8);
+        if (is_promotion(m))
+        {
+            text += '=';
+            text += SAN_PIECES[promotion_index(m)];
+        }
+    }
+
+    Undo undo;
+    pos.make_move(m, undo);
+    if (pos.in_check(pos.to_move))
+    {
+        text += has_legal_move(pos) ? '+' : '#';
+    }
+    pos.unmake_move(m, undo);
+    return text;
+}
+
+// --- Splits the text into piece, origin hints, target and promotion, then looks for the
+// --- one legal move fitting them ---
+Move parse_san_move(Position &pos, const std::string &text)
+{
+    std::string san = text;
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+    {
+        san.pop_back();
+    }
+
+    MoveList moves;
+    generate_moves(pos, pos.to_move, moves);
+
+    int castle = san == "O-O" || san == "0-0" ? KING_CASTLE : san == "O-O-O" || san == "0-0-0" ? QUEEN_CASTLE : -1;
+    if (castle >= 0)
+    {
+        for (int k = 0; k < moves.count; k++)
+        {
+            if (move_flag(moves.moves[k]) == castle && is_legal(pos, moves.moves[k]))
+            {
+                return moves.moves[k];
+            }
+        }
+        return NO_MOVE;
+    }
+
+    // --- Piece letter (none for pawns) ---
+    piece_type pt = PAWN;
+    size_t begin = 0;
+    const char *letter = san.empty() ? NULL : strchr(SAN_PIECES + 1, san[0]);
+    if (letter != NULL && *letter != '\0')
+    {
+        pt = (piece_type)(letter - SAN_PIECES);
+        begin = 1;
+    }
+
+    // --- Promotion piece, with or without '=' ---
+    int promotion = -1;
+    if (pt == PAWN && !san.empty() && strchr("NBRQ", san.back()) != NULL)
+    {
+        promotion = (int)(strchr(SAN_PIECES, san.back()) - SAN_PIECES);
+        san.pop_back();
+        if (!san.empty() && san.back() == '=')
+        {
+            san.pop_back();
+        }
+    }
+
+    // --- Target square, then what is left between the piece and the target ---
+    if (san.size() < begin + 2)
+    {
+        return NO_MOVE;
+    }
+    int to_file = san[san.size() - 2] - 'a';
+    int to_rank = san[san.size() - 1] - '1';
+    if (to_file < 0 || to_file > 7 || to_rank < 0 || to_rank > 7)
+    {
+        return NO_MOVE;
+    }
+    int from_file = -1, from_rank = -1;
+    for (size_t k = begin; k + 2 < san.size(); k++)
+    {
+        char c = san[k];
+        if (c >= 'a' && c <= 'h')
+            from_file = c - 'a';
+        else if (c >= '1' && c <= '8')
+            from_rank = c - '1';
+        else if (c != 'x' && c != '-' && c != ':')
+            return NO_MOVE;
+    }
+
+    Move found = NO_MOVE;
+    for (int k = 0; k < moves.count; k++)
+    {
+        Move m = moves.moves[k];
+        int from = move_from(m);
+        if (move_to(m) != to_rank * 8 + to_file || type_of(pos.squares[from]) != pt || move_flag(m) == KING_CASTLE ||
+            move_flag(m) == QUEEN_CASTLE || (from_file >= 0 && from % 8 != from_file) ||
+            (from_rank >= 0 && from / 8 != from_rank) || (is_promotion(m) ? promotion_index(m) != promotion : promotion >= 0) ||
+            !is_legal(pos, m))
+        {
+            continue;
+        }
+        if (found != NO_MOVE)
+        {
+            return NO_MOVE;
+        }
+        found = m;
+    }
+    return found;
+}
@@ -0,0 +1,58 @@
+// --------------------------------------------------------------------------------------
+// movegen.h
+// --- Declares the shared pseudo-legal move generator.
+// --- Moves (see move.h) are written into a fixed-capacity MoveList that lives on the
+// --- stack, so generating moves never touches the heap.
+// --- Also converts moves to and from coordinate notation (e2e4, e7e8q) as used by UCI,
+// --- and standard algebraic notation (Nbd7, exd6, e8=Q+) as used in PGN files.
+// --------------------------------------------------------------------------------------
+
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "position.h"
+#include <string>
+
+// --- Upper bound on the number of moves in any chess position is 218 ---
+const int MAX_MOVES = 256;
+
+// --- Fixed-capacity list of moves, no heap allocation ---
+struct MoveList
+{
+    Move moves[MAX_MOVES];
+    int count;
+
+    MoveList() : count(0) {}
+    void add(Move m) { moves[count++] = m; }
+};
+
+// --- Appends every pseudo-legal move of side s to the list ---
+// --- Moves may still leave the own king in check; callers filter with Position::in_check ---
+void generate_moves(const Position &pos, side s, MoveList &list);
+
+// --- Appends only captures (en passant included) and promotions, for quiescence search ---
+void generate_captures(const Position &pos, side s, MoveList &list);
+
+// --- The same for a side fixed at compile time, as the search calls them (instantiated
+// --- for WHITE and BLACK in movegen.cpp) ---
+template <side S> void generate_moves(const Position &pos, MoveList &list);
+template <side S> void generate_captures(const Position &pos, MoveList &list);
+
+// --- Coordinate notation of a move, promotion piece in lower case (e.g. e7e8q) ---
+std::string move_to_uci(Move m);
+
+// --- Finds the legal move of the side to move written in coordinate notation ---
+// --- Returns NO_MOVE if the text is not a legal move in this position ---
+Move parse_uci_move(Position &pos, const std::string &text);
+
+// --- Standard algebraic notation of a legal move of the side to move, with the check or
+// --- mate mark (e.g. Nbd7, exd6, e8=Q+, O-O#) ---
+std::string move_to_san(Position &pos, Move m);
+
+// --- Finds the legal move of the side to move written in standard algebraic notation ---
+// --- Marks after the move (+ # ! ?), a missing '=' before the promotion piece and
+// --- castling written with zeros are accepted; returns NO_MOVE if no legal move, or more
+// --- than one, matches ---
+Move parse_san_move(Position &pos, const std::string &text);
+
+#endif
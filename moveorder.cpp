@@ -0,0 +1,144 @@
+// --------------------------------------------------------------------------------------
+// moveorder.cpp
+// --- Implements move scoring, killer/history bookkeeping and lazy move picking.
+// --------------------------------------------------------------------------------------
+
+#include "moveorder.h"
+
+// --- Score bands, so each category is always tried before the next one ---
+static const int TT_MOVE_SCORE = 1000000;
+static const int CAPTURE_SCORE = 500000;
+static const int FIRST_KILLER_SCORE = 400000;
+static const int SECOND_KILLER_SCORE = 390000;
+static const int HISTORY_LIMIT = 300000;
+
+// --- Rough piece values used only for MVV-LVA ---
+static const int ORDER_VALUE[6] = {1, 3, 3, 5, 9, 20};
+
+// --- Empties killers and history ---
+void OrderingTables::clear()
+{
+    for (int ply = 0; ply < MAX_PLY; ply++)
+    {
+        killers[ply][0] = killers[ply][1] = NO_MOVE;
+    }
+    for (int s = 0; s < 2; s++)
+    {
+        for (int from = 0; from < 64; from++)
+        {
+            for (int to = 0; to < 64; to++)
+            {
+                history[s][from][to] = 0;
+            }
+        }
+    }
+}
+
+// --- Called at the start of a search: drops killers and halves history scores ---
+void OrderingTables::new_search()
+{
+    for (int ply = 0; ply < MAX_PLY; ply++)
+    {
+        killers[ply][0] = killers[ply][1] = NO_MOVE;
+    }
+    for (int s = 0; s < 2; s++)
+    {
+        for (int from = 0; from < 64; from++)
+        {
+            for (int to = 0; to < 64; to++)
+            {
+                history[s][from][to] /= 2;
+            }
+        }
+    }
+}
+
+// --- Records a quiet move that caused a beta cutoff ---
+void OrderingTables::update(side s, Move m, int depth, int ply)
+{
+    if (ply < MAX_PLY && killers[ply][0] != m)
+    {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = m;
+    }
+
+    // --- Deeper cutoffs count more; everything is halved before the bonus could overflow its band ---
+    int &h = history[s][move_from(m)][move_to(m)];
+    h += depth * depth;
+    if (h >= HISTORY_LIMIT)
+    {
+        for (int from = 0; from < 64; from++)
+        {
+            for (int to = 0; to < 64; to++)
+            {
+                history[s][from][to] /= 2;
+            }
+        }
+    }
+}
+
+// --- Scores every move of the list for ordering ---
+void score_moves(const Position &pos, const MoveList &list, Move tt_move, const OrderingTables &tables, int ply, int scores[])
+{
+    side s = pos.to_move;
+    const Move *killers = (ply < MAX_PLY) ? tables.killers[ply] : 0;
+
+    for (int k = 0; k < list.count; k++)
+    {
+        Move m = list.moves[k];
+
+        if (m == tt_move)
+        {
+            scores[k] = TT_MOVE_SCORE;
+        }
+        else if (is_capture(m) || move_flag(m) == QUEEN_PROMOTION)
+        {
+            // --- Queen promotions rank with captures; under-promotions fall through to history ---
+            int value = 0;
+            if (is_capture(m))
+            {
+                int attacker = type_of(pos.piece_on(move_from(m)));
+                int victim = (move_flag(m) == EN_PASSANT_CAPTURE) ? PAWN : type_of(pos.piece_on(move_to(m)));
+                value = 10 * ORDER_VALUE[victim] - ORDER_VALUE[attacker];
+            }
+            if (is_promotion(m))
+            {
+                value += 10 * ORDER_VALUE[promotion_index(m)];
+            }
+            scores[k] = CAPTURE_SCORE + value;
+        }
+        else if (killers && m == killers[0])
+        {
+            scores[k] = FIRST_KILLER_SCORE;
+        }
+        else if (killers && m == killers[1])
+        {
+            scores[k] = SECOND_KILLER_SCORE;
+        }
+        else
+        {
+            scores[k] = tables.history[s][move_from(m)][move_to(m)];
+        }
+    }
+}
+
+// --- Swaps the highest-scored move from index k onwards into place k and returns it ---
+Move pick_move(MoveList &list, int scores[], int k)
+{
+    int best = k;
+    for (int n = k + 1; n < list.count; n++)
+    {
+        if (scores[n] > scores[best])
+        {
+            best = n;
+        }
+    }
+
+    Move m = list.moves[best];
+    int score = scores[best];
+    list.moves[best] = list.moves[k];
+    scores[best] = scores[k];
+    list.moves[k] = m;
+    scores[k] = score;
+    return m;
+}
@@ -0,0 +1,41 @@
+// --------------------------------------------------------------------------------------
+// moveorder.h
+// --- Declares the move ordering used by the search.
+// --- Alpha-beta prunes most when the best move is tried first, so every generated
+// --- move gets a score: the transposition table move first, then captures by
+// --- MVV-LVA (most valuable victim, least valuable attacker), then the two killer
+// --- moves of the current ply, then quiet moves ranked by the history table.
+// --- Moves are then picked highest score first, sorting lazily as the search goes.
+// --------------------------------------------------------------------------------------
+
+#ifndef MOVEORDER_H
+#define MOVEORDER_H
+
+#include "movegen.h"
+
+// --- Deepest ply the ordering tables (and the search) keep state for ---
+const int MAX_PLY = 128;
+
+// --- Killer moves and history scores gathered during a search ---
+struct OrderingTables
+{
+    Move killers[MAX_PLY][2]; // --- Two most recent quiet moves that caused a cutoff per ply ---
+    int history[2][64][64];   // --- [side][from][to] bonus for quiet moves that caused cutoffs ---
+
+    // --- Empties killers and history ---
+    void clear();
+
+    // --- Called at the start of a search: drops killers and halves history scores ---
+    void new_search();
+
+    // --- Records a quiet move that caused a beta cutoff ---
+    void update(side s, Move m, int depth, int ply);
+};
+
+// --- Scores every move of the list for ordering ---
+void score_moves(const Position &pos, const MoveList &list, Move tt_move, const OrderingTables &tables, int ply, int scores[]);
+
+// --- Swaps the highest-scored move from index k onwards into place k and returns it ---
+Move pick_move(MoveList &list, int scores[], int k);
+
+#endif
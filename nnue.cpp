@@ -0,0 +1,385 @@
+// --------------------------------------------------------------------------------------
+// nnue.cpp
+// --- Implements the network evaluation declared in nnue.h: loading the weights, the
+// --- accumulator updates and the forward pass, each with scalar, AVX2 and NEON kernels.
+// --------------------------------------------------------------------------------------
+
+#include "nnue.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+bool Network::use_avx2 = false;
+
+// --- Most features a move adds or removes on one side: the moved piece, a captured
+// --- piece, and the rook of a castling move ---
+const int MAX_CHANGED_FEATURES = 3;
+
+// --- Most features of a position: every piece but the two kings ---
+const int MAX_ACTIVE_FEATURES = 30;
+
+size_t network_file_size()
+{
+    return sizeof(NetworkHeader) +
+           sizeof(int16_t) * NNUE_HIDDEN +
+           sizeof(int16_t) * NNUE_FEATURES * NNUE_HIDDEN +
+           sizeof(int32_t) * NNUE_FEATURES * NNUE_BUCKETS +
+           sizeof(int32_t) * NNUE_LAYER1 + sizeof(int8_t) * NNUE_LAYER1 * 2 * NNUE_HIDDEN +
+           sizeof(int32_t) * NNUE_LAYER2 + sizeof(int8_t) * NNUE_LAYER2 * NNUE_LAYER1 +
+           sizeof(int32_t) + sizeof(int8_t) * NNUE_LAYER2;
+}
+
+// --- Scalar kernels ---
+
+// --- out = in + the added rows - the removed rows, over one accumulator half ---
+static void update_rows_scalar(const int16_t *in, int16_t *out, const int16_t *weights,
+                               const int *added, int added_count, const int *removed, int removed_count)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i++)
+    {
+        int value = in[i];
+        for (int k = 0; k < added_count; k++)
+            value += weights[added[k] * NNUE_HIDDEN + i];
+        for (int k = 0; k < removed_count; k++)
+            value -= weights[removed[k] * NNUE_HIDDEN + i];
+        out[i] = (int16_t)value;
+    }
+}
+
+// --- Clips an accumulator half to 0..127 ---
+static void clip_scalar(const int16_t *in, uint8_t *out)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i++)
+    {
+        out[i] = (uint8_t)std::max(0, std::min(127, (int)in[i]));
+    }
+}
+
+// --- Dot product of n inputs (0..127) with a row of int8 weights; n is a multiple of 32 ---
+static int dot_scalar(const uint8_t *in, const int8_t *weights, int n)
+{
+    int sum = 0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += in[i] * weights[i];
+    }
+    return sum;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// --- AVX2 kernels, compiled for AVX2 even when the rest of the build is not ---
+__attribute__((target("avx2"))) static void update_rows_avx2(const int16_t *in, int16_t *out, const int16_t *weights,
+                                                             const int *added, int added_count, const int *removed, int removed_count)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 16)
+    {
+        __m256i value = _mm256_loadu_si256((const __m256i *)(in + i));
+        for (int k = 0; k < added_count; k++)
+            value = _mm256_add_epi16(value, _mm256_loadu_si256((const __m256i *)(weights + added[k] * NNUE_HIDDEN + i)));
+        for (int k = 0; k < removed_count; k++)
+            value = _mm256_sub_epi16(value, _mm256_loadu_si256((const __m256i *)(weights + removed[k] * NNUE_HIDDEN + i)));
+        _mm256_storeu_si256((__m256i *)(out + i), value);
+    }
+}
+
+// --- Saturating pack to int8, then the negative values to 0; the pack interleaves the
+// --- 128-bit lanes of its two sources, which the permute puts back in order ---
+__attribute__((target("avx2"))) static void clip_avx2(const int16_t *in, uint8_t *out)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < NNUE_HIDDEN; i += 32)
+    {
+        __m256i low = _mm256_loadu_si256((const __m256i *)(in + i));
+        __m256i high = _mm256_loadu_si256((const __m256i *)(in + i + 16));
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0xD8);
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_max_epi8(packed, zero));
+    }
+}
+
+// --- Products of unsigned inputs and signed weights summed in pairs (vpmaddubsw; two
+// --- products of at most 127 x 128 cannot saturate), then widened to int32 ---
+__attribute__((target("avx2"))) static int dot_avx2(const uint8_t *in, const int8_t *weights, int n)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 32)
+    {
+        __m256i products = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i *)(in + i)),
+                                                _mm256_loadu_si256((const __m256i *)(weights + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+
+    __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0x4E));
+    total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0xB1));
+    return _mm_cvtsi128_si32(total);
+}
+#elif defined(__ARM_NEON)
+// --- NEON kernels, always available where the compiler defines __ARM_NEON ---
+static void update_rows_neon(const int16_t *in, int16_t *out, const int16_t *weights,
+                             const int *added, int added_count, const int *removed, int removed_count)
+{
+    for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    {
+        int16x8_t value = vld1q_s16(in + i);
+        for (int k = 0; k < added_count; k++)
+            value = vaddq_s16(value, vld1q_s16(weights + added[k] * NNUE_HIDDEN + i));
+        for (int k = 0; k < removed_count; k++)
+            value = vsubq_s16(value, vld1q_s16(weights + removed[k] * NNUE_HIDDEN + i));
+        vst1q_s16(out + i, value);
+    }
+}
+
+static void clip_neon(const int16_t *in, uint8_t *out)
+{
+    const int8x8_t zero = vdup_n_s8(0);
+    for (int i = 0; i < NNUE_HIDDEN; i += 8)
+    {
+        int8x8_t packed = vmax_s8(vqmovn_s16(vld1q_s16(in + i)), zero);
+        vst1_u8(out + i, vreinterpret_u8_s8(packed));
+    }
+}
+
+// --- Inputs are at most 127, so they can be read as int8; two products fit in int16 ---
+static int dot_neon(const uint8_t *in, const int8_t *weights, int n)
+{
+    int32x4_t sum = vdupq_n_s32(0);
+    for (int i = 0; i < n; i += 16)
+    {
+        int8x16_t x = vreinterpretq_s8_u8(vld1q_u8(in + i));
+        int8x16_t w = vld1q_s8(weights + i);
+        int16x8_t products = vmull_s8(vget_low_s8(x), vget_low_s8(w));
+        products = vmlal_s8(products, vget_high_s8(x), vget_high_s8(w));
+        sum = vpadalq_s16(sum, products);
+    }
+    return vgetq_lane_s32(sum, 0) + vgetq_lane_s32(sum, 1) + vgetq_lane_s32(sum, 2) + vgetq_lane_s32(sum, 3);
+}
+#endif
+
+// --- Kernel selection ---
+static void update_rows(const int16_t *in, int16_t *out, const int16_t *weights,
+                        const int *added, int added_count, const int *removed, int removed_count)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (Network::use_avx2)
+    {
+        update_rows_avx2(in, out, weights, added, added_count, removed, removed_count);
+        return;
+    }
+#elif defined(__ARM_NEON)
+    update_rows_neon(in, out, weights, added, added_count, removed, removed_count);
+    return;
+#endif
+    update_rows_scalar(in, out, weights, added, added_count, removed, removed_count);
+}
+
+static void clip(const int16_t *in, uint8_t *out)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (Network::use_avx2)
+    {
+        clip_avx2(in, out);
+        return;
+    }
+#elif defined(__ARM_NEON)
+    clip_neon(in, out);
+    return;
+#endif
+    clip_scalar(in, out);
+}
+
+static int dot(const uint8_t *in, const int8_t *weights, int n)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (Network::use_avx2)
+    {
+        return dot_avx2(in, weights, n);
+    }
+#elif defined(__ARM_NEON)
+    return dot_neon(in, weights, n);
+#endif
+    return dot_scalar(in, weights, n);
+}
+
+// --- The piece-square term has eight int32 buckets, too few to be worth a kernel ---
+static void update_psqt(const int32_t *in, int32_t *out, const int32_t *psqt,
+                        const int *added, int added_count, const int *removed, int removed_count)
+{
+    for (int b = 0; b < NNUE_BUCKETS; b++)
+    {
+        int32_t value = in[b];
+        for (int k = 0; k < added_count; k++)
+            value += psqt[added[k] * NNUE_BUCKETS + b];
+        for (int k = 0; k < removed_count; k++)
+            value -= psqt[removed[k] * NNUE_BUCKETS + b];
+        out[b] = value;
+    }
+}
+
+// --- A dense layer: outputs = clip((bias + weights . inputs) >> NNUE_LAYER_SHIFT) ---
+static void dense_layer(const uint8_t *in, int inputs, const int32_t *bias, const int8_t *weights, int outputs, uint8_t *out)
+{
+    for (int j = 0; j < outputs; j++)
+    {
+        int sum = bias[j] + dot(in, weights + j * inputs, inputs);
+        out[j] = (uint8_t)std::max(0, std::min(127, sum >> NNUE_LAYER_SHIFT));
+    }
+}
+
+Network::Network()
+    : feature_bias(NULL), feature_weights(NULL), feature_psqt(NULL), layer1_bias(NULL), layer1_weights(NULL),
+      layer2_bias(NULL), layer2_weights(NULL), output_bias(NULL), output_weights(NULL)
+{
+}
+
+bool Network::open(const std::string &path)
+{
+    close();
+    if (!file.open(path) || file.size() != network_file_size())
+    {
+        file.close();
+        return false;
+    }
+
+    const NetworkHeader *header = (const NetworkHeader *)file.data();
+    if (header->magic != NNUE_MAGIC || header->version != NNUE_VERSION || header->features != (uint32_t)NNUE_FEATURES ||
+        header->hidden != (uint32_t)NNUE_HIDDEN || header->layer1 != (uint32_t)NNUE_LAYER1 ||
+        header->layer2 != (uint32_t)NNUE_LAYER2 || header->buckets != (uint32_t)NNUE_BUCKETS)
+    {
+        file.close();
+        return false;
+    }
+
+#if defined(__AVX2__)
+    use_avx2 = true;
+#elif defined(__x86_64__) || defined(__i386__)
+    use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    // --- Every section is a multiple of 4 bytes long, so all of them stay aligned ---
+    const unsigned char *p = file.data() + sizeof(NetworkHeader);
+    feature_bias = (const int16_t *)p;
+    p += sizeof(int16_t) * NNUE_HIDDEN;
+    feature_weights = (const int16_t *)p;
+    p += sizeof(int16_t) * NNUE_FEATURES * NNUE_HIDDEN;
+    feature_psqt = (const int32_t *)p;
+    p += sizeof(int32_t) * NNUE_FEATURES * NNUE_BUCKETS;
+    layer1_bias = (const int32_t *)p;
+    p += sizeof(int32_t) * NNUE_LAYER1;
+    layer1_weights = (const int8_t *)p;
+    p += NNUE_LAYER1 * 2 * NNUE_HIDDEN;
+    layer2_bias = (const int32_t *)p;
+    p += sizeof(int32_t) * NNUE_LAYER2;
+    layer2_weights = (const int8_t *)p;
+    p += NNUE_LAYER2 * NNUE_LAYER1;
+    output_bias = (const int32_t *)p;
+    p += sizeof(int32_t);
+    output_weights = (const int8_t *)p;
+    return true;
+}
+
+void Network::close()
+{
+    file.close();
+    feature_bias = feature_weights = NULL;
+    feature_psqt = layer1_bias = layer2_bias = output_bias = NULL;
+    layer1_weights = layer2_weights = output_weights = NULL;
+}
+
+void Network::refresh(const Position &pos, side perspective, Accumulator &acc) const
+{
+    int features[MAX_ACTIVE_FEATURES];
+    int count = 0;
+    int king_sq = pos.king_square(perspective);
+    Bitboard pieces = pos.occupied & ~(pos.pieces[WHITE][KING] | pos.pieces[BLACK][KING]);
+    while (pieces && count < MAX_ACTIVE_FEATURES)
+    {
+        int sq = pop_lsb(pieces);
+        features[count++] = nnue_feature(perspective, king_sq, pos.squares[sq], sq);
+    }
+
+    static const int32_t no_psqt[NNUE_BUCKETS] = {0};
+    update_rows(feature_bias, acc.values[perspective], feature_weights, features, count, NULL, 0);
+    update_psqt(no_psqt, acc.psqt[perspective], feature_psqt, features, count, NULL, 0);
+}
+
+void Network::refresh(const Position &pos, Accumulator &acc) const
+{
+    refresh(pos, WHITE, acc);
+    refresh(pos, BLACK, acc);
+}
+
+void Network::update(const Accumulator &before, Accumulator &after, const Position &pos, Move m, char captured) const
+{
+    int from = move_from(m);
+    int to = move_to(m);
+    int flag = move_flag(m);
+    char piece = pos.squares[to];
+    side us = side_of(piece);
+    char moved = is_promotion(m) ? make_piece(us, PAWN) : piece;
+
+    for (int p = 0; p < 2; p++)
+    {
+        side perspective = (side)p;
+
+        // --- Every feature of a side holds its king square, so a king move starts over ---
+        if (type_of(piece) == KING && perspective == us)
+        {
+            refresh(pos, perspective, after);
+            continue;
+        }
+
+        int king_sq = pos.king_square(perspective);
+        int added[MAX_CHANGED_FEATURES], removed[MAX_CHANGED_FEATURES];
+        int added_count = 0, removed_count = 0;
+
+        // --- Kings are not features; the other side only sees the castling rook move ---
+        if (type_of(piece) != KING)
+        {
+            removed[removed_count++] = nnue_feature(perspective, king_sq, moved, from);
+            added[added_count++] = nnue_feature(perspective, king_sq, piece, to);
+        }
+        if (captured != EMPTY)
+        {
+            int capture_sq = flag == EN_PASSANT_CAPTURE ? (to ^ 8) : to;
+            removed[removed_count++] = nnue_feature(perspective, king_sq, captured, capture_sq);
+        }
+        if (flag == KING_CASTLE || flag == QUEEN_CASTLE)
+        {
+            char rook = make_piece(us, ROOK);
+            removed[removed_count++] = nnue_feature(perspective, king_sq, rook, flag == KING_CASTLE ? to + 1 : to - 2);
+            added[added_count++] = nnue_feature(perspective, king_sq, rook, flag == KING_CASTLE ? to - 1 : to + 1);
+        }
+
+        update_rows(before.values[p], after.values[p], feature_weights, added, added_count, removed, removed_count);
+        update_psqt(before.psqt[p], after.psqt[p], feature_psqt, added, added_count, removed, removed_count);
+    }
+}
+
+int Network::evaluate(const Position &pos, const Accumulator &acc) const
+{
+    side us = pos.to_move;
+    side them = opposite(us);
+
+    // --- The side to move's half goes first, so the layers score for the side to move ---
+    alignas(32) uint8_t input[2 * NNUE_HIDDEN];
+    alignas(32) uint8_t hidden1[NNUE_LAYER1];
+    alignas(32) uint8_t hidden2[NNUE_LAYER2];
+    clip(acc.values[us], input);
+    clip(acc.values[them], input + NNUE_HIDDEN);
+    dense_layer(input, 2 * NNUE_HIDDEN, layer1_bias, layer1_weights, NNUE_LAYER1, hidden1);
+    dense_layer(hidden1, NNUE_LAYER1, layer2_bias, layer2_weights, NNUE_LAYER2, hidden2);
+    int output = *output_bias + dot(hidden2, output_weights, NNUE_LAYER2);
+
+    // --- Each half's piece-square term counts its own pieces for and the other's against ---
+    int bucket = std::min(NNUE_BUCKETS - 1, (popcount(pos.occupied) - 1) / 4);
+    int psqt = (acc.psqt[us][bucket] - acc.psqt[them][bucket]) / 2;
+
+    int score = std::max(-NNUE_MAX_SCORE, std::min(NNUE_MAX_SCORE, output / NNUE_OUTPUT_SCALE + psqt));
+    return us == WHITE ? score : -score;
+}
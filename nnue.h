@@ -0,0 +1,122 @@
+// --------------------------------------------------------------------------------------
+// nnue.h
+// --- Declares the neural network evaluation, an alternative to Evaluation::evaluate.
+// --- Inputs are (king square, piece, square) features: for each side's point of view,
+// --- one per non-king piece, combined with the square of that side's own king. The
+// --- first layer is a sum of weight rows over the active features (the accumulator),
+// --- so the search only adds and subtracts the rows of the pieces a move touches; a
+// --- king move rebuilds its own side's half.
+// --- The accumulator halves of the side to move and the other side are clipped to
+// --- 0..127 and run through two small int8 layers to a score, to which a direct
+// --- piece-square term from the features (per bucket of piece counts) is added.
+// --- Weights are int16 in the first layer and int8 after it; the kernels use AVX2
+// --- (chosen at runtime) or NEON, with plain loops as the fallback.
+// --- Network files are memory-mapped; tools/nnue_build writes one (see there).
+// --------------------------------------------------------------------------------------
+
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstdint>
+#include <string>
+#include "position.h"
+#include "mappedfile.h"
+
+const uint32_t NNUE_MAGIC = 0x4e4e4543; // --- "CENN" ---
+const uint32_t NNUE_VERSION = 1;
+
+// --- Layer sizes ---
+const int NNUE_FEATURES = 64 * 10 * 64; // --- King square x 10 non-king pieces x square ---
+const int NNUE_HIDDEN = 256;            // --- Accumulator width of each point of view ---
+const int NNUE_LAYER1 = 32;
+const int NNUE_LAYER2 = 32;
+const int NNUE_BUCKETS = 8;             // --- Piece-square term buckets, by pieces on the board ---
+
+// --- Right shift from a layer's int32 sums to its 0..127 outputs, and from the output
+// --- layer's sum to centipawns ---
+const int NNUE_LAYER_SHIFT = 6;
+const int NNUE_OUTPUT_SCALE = 16;
+
+// --- Largest score the network returns, well inside the mate and tablebase scores ---
+const int NNUE_MAX_SCORE = 30000;
+
+// --- File header; the weights follow in this order, little-endian:
+// ---   int16 feature_bias[HIDDEN], int16 feature_weights[FEATURES][HIDDEN],
+// ---   int32 feature_psqt[FEATURES][BUCKETS],
+// ---   int32 layer1_bias[LAYER1], int8 layer1_weights[LAYER1][2 * HIDDEN],
+// ---   int32 layer2_bias[LAYER2], int8 layer2_weights[LAYER2][LAYER1],
+// ---   int32 output_bias, int8 output_weights[LAYER2] ---
+struct NetworkHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t features; // --- The layer sizes above, checked when loading ---
+    uint32_t hidden;
+    uint32_t layer1;
+    uint32_t layer2;
+    uint32_t buckets;
+    uint32_t reserved[9];
+};
+
+// --- Size of a network file ---
+size_t network_file_size();
+
+// --- Feature of a piece on sq seen from side `perspective`, whose king is on king_sq.
+// --- Black's point of view is turned upside down, so both see their pieces as White ---
+inline int nnue_feature(side perspective, int king_sq, char piece, int sq)
+{
+    int flip = perspective == WHITE ? 0 : 56;
+    int kind = type_of(piece) + (side_of(piece) == perspective ? 0 : 5);
+    return (((king_sq ^ flip) * 10 + kind) << 6) + (sq ^ flip);
+}
+
+// --- First layer outputs of a position, one half per point of view ([side]) ---
+struct Accumulator
+{
+    int16_t values[2][NNUE_HIDDEN];
+    int32_t psqt[2][NNUE_BUCKETS];
+};
+
+class Network
+{
+private:
+    MappedFile file;
+
+    // --- Pointers into the mapping, NULL while no network is loaded ---
+    const int16_t *feature_bias;
+    const int16_t *feature_weights;
+    const int32_t *feature_psqt;
+    const int32_t *layer1_bias;
+    const int8_t *layer1_weights;
+    const int32_t *layer2_bias;
+    const int8_t *layer2_weights;
+    const int32_t *output_bias;
+    const int8_t *output_weights;
+
+    // --- Rebuilds one point of view from the bias and all pieces on the board ---
+    void refresh(const Position &pos, side perspective, Accumulator &acc) const;
+
+public:
+    // --- True when the kernels use AVX2 (runtime detection, as in Evaluation) ---
+    static bool use_avx2;
+
+    Network();
+
+    // --- Maps a network file; false (and no network) if it is missing or does not match
+    // --- the layer sizes above ---
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const { return feature_bias != NULL; }
+
+    // --- Builds the accumulator of a position from scratch ---
+    void refresh(const Position &pos, Accumulator &acc) const;
+
+    // --- Accumulator of the position after m, from the one before it; pos is the position
+    // --- after the move and captured the piece it took (EMPTY if none) ---
+    void update(const Accumulator &before, Accumulator &after, const Position &pos, Move m, char captured) const;
+
+    // --- Score of a position from White's point of view, in centipawns ---
+    int evaluate(const Position &pos, const Accumulator &acc) const;
+};
+
+#endif
@@ -0,0 +1,23 @@
+// --------------------------------------------------------------------------------------
+// pawntable.cpp
+// --- Implements the per-thread pawn hash table declared in pawntable.h.
+// --------------------------------------------------------------------------------------
+
+#include "pawntable.h"
+
+PawnTable::PawnTable() : entries(new PawnEntry[PAWN_TABLE_SIZE])
+{
+    clear();
+}
+
+// --- Empties every entry ---
+// --- A cleared entry is also the correct entry for "no pawns at all" (key 0, score 0) ---
+void PawnTable::clear()
+{
+    for (int k = 0; k < PAWN_TABLE_SIZE; k++)
+    {
+        entries[k].key = 0;
+        entries[k].score = 0;
+        entries[k].passed[WHITE] = entries[k].passed[BLACK] = 0;
+    }
+}
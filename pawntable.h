@@ -0,0 +1,43 @@
+// --------------------------------------------------------------------------------------
+// pawntable.h
+// --- Declares the pawn hash table used by the evaluation.
+// --- Pawn structure changes far less often than the rest of the position, so its score
+// --- and the passed pawns it contains are stored under a key built from the pawns
+// --- alone (Position::pawn_key) and reused by every position with the same pawns.
+// --- Each search thread owns its own table, so no synchronisation is needed.
+// --------------------------------------------------------------------------------------
+
+#ifndef PAWNTABLE_H
+#define PAWNTABLE_H
+
+#include <cstdint>
+#include <memory>
+#include "position.h"
+
+// --- Cached pawn structure of one pawn configuration ---
+struct PawnEntry
+{
+    uint64_t key;       // --- Pawn-only Zobrist key ---
+    Score score;        // --- Doubled, isolated, island and passed pawn terms, from White's view ---
+    Bitboard passed[2]; // --- Passed pawns of each side ---
+};
+
+// --- 8192 entries of 32 bytes: 256 KB per search thread ---
+const int PAWN_TABLE_SIZE = 8192;
+
+class PawnTable
+{
+private:
+    std::unique_ptr<PawnEntry[]> entries;
+
+public:
+    PawnTable();
+
+    // --- Empties every entry ---
+    void clear();
+
+    // --- Slot for a pawn key; its contents belong to that key only if entry->key matches ---
+    PawnEntry *entry(uint64_t pawn_key) { return &entries[pawn_key & (PAWN_TABLE_SIZE - 1)]; }
+};
+
+#endif
@@ -0,0 +1,64 @@
+// --------------------------------------------------------------------------------------
+// perft.cpp
+// --- Implements perft and divide over the shared move generator in movegen.h.
+// --- The generator is pseudo-legal, so every move is played and kept only if it does
+// --- not leave the own king in check, exactly as the search filters its moves.
+// --------------------------------------------------------------------------------------
+
+#include "perft.h"
+
+// --- Number of leaf nodes depth plies below the position (1 at depth 0) ---
+uint64_t perft(Position &pos, int depth, bool bulk)
+{
+    if (depth == 0)
+    {
+        return 1;
+    }
+
+    MoveList moves;
+    side us = pos.to_move;
+    generate_moves(pos, us, moves);
+
+    uint64_t nodes = 0;
+    Undo undo;
+    for (int k = 0; k < moves.count; k++)
+    {
+        pos.make_move(moves.moves[k], undo);
+        if (!pos.in_check(us))
+        {
+            // --- Bulk counting: a legal move at the last ply is one leaf, no need to recurse ---
+            nodes += (bulk && depth == 1) ? 1 : perft(pos, depth - 1, bulk);
+        }
+        pos.unmake_move(moves.moves[k], undo);
+    }
+    return nodes;
+}
+
+// --- perft of every legal root move, in generation order ---
+std::vector<PerftEntry> divide(Position &pos, int depth, bool bulk)
+{
+    std::vector<PerftEntry> entries;
+    if (depth < 1)
+    {
+        return entries;
+    }
+
+    MoveList moves;
+    side us = pos.to_move;
+    generate_moves(pos, us, moves);
+
+    Undo undo;
+    for (int k = 0; k < moves.count; k++)
+    {
+        pos.make_move(moves.moves[k], undo);
+        if (!pos.in_check(us))
+        {
+            PerftEntry entry;
+            entry.move = moves.moves[k];
+            entry.nodes = perft(pos, depth - 1, bulk);
+            entries.push_back(entry);
+        }
+        pos.unmake_move(moves.moves[k], undo);
+    }
+    return entries;
+}
@@ -0,0 +1,32 @@
+// --------------------------------------------------------------------------------------
+// perft.h
+// --- Declares perft ("performance test"): counts the leaf nodes of the legal move tree
+// --- to a fixed depth. The counts of well-known positions are published, so perft
+// --- checks the move generator and make/unmake for correctness, and timing it measures
+// --- move generation speed without any search or evaluation in the way.
+// --- Divide splits the count up by root move to find where a wrong count comes from.
+// --------------------------------------------------------------------------------------
+
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "movegen.h"
+#include <cstdint>
+#include <vector>
+
+// --- Leaf count below one root move, as reported by divide ---
+struct PerftEntry
+{
+    Move move;
+    uint64_t nodes;
+};
+
+// --- Number of leaf nodes depth plies below the position (1 at depth 0) ---
+// --- bulk counts the legal moves at the last ply instead of playing each one out; the
+// --- result is the same, only the time differs ---
+uint64_t perft(Position &pos, int depth, bool bulk = true);
+
+// --- perft of every legal root move, in generation order ---
+std::vector<PerftEntry> divide(Position &pos, int depth, bool bulk = true);
+
+#endif
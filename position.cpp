@@ -0,0 +1,367 @@
+// --------------------------------------------------------------------------------------
+// position.cpp
+// --- Implements the bitboard Position declared in position.h.
+// --- Handles piece placement and conversion between `board_state` (8x8 array with
+// --- per-file en passant flags) and the bitboard form used by the engine.
+// --------------------------------------------------------------------------------------
+
+#include "position.h"
+#include "attacks.h"
+#include "zobrist.h"
+
+// --- Empties the board and clears all flags ---
+void Position::clear()
+{
+    for (int s = 0; s < 2; s++)
+    {
+        for (int pt = 0; pt < 6; pt++)
+        {
+            pieces[s][pt] = 0;
+        }
+        occupancy[s] = 0;
+    }
+    occupied = 0;
+
+    for (int sq = 0; sq < 64; sq++)
+    {
+        squares[sq] = EMPTY;
+    }
+
+    to_move = WHITE;
+    en_passant = NO_SQUARE;
+    castling = 0;
+    key = 0;
+    pawn_key = 0;
+    psq = 0;
+    phase = 0;
+}
+
+// --- Places a piece on an empty square ---
+void Position::put_piece(char piece, int sq)
+{
+    side s = side_of(piece);
+    Bitboard b = square_bb(sq);
+
+    pieces[s][type_of(piece)] |= b;
+    occupancy[s] |= b;
+    occupied |= b;
+    squares[sq] = piece;
+    key ^= Zobrist::PIECES[s][type_of(piece)][sq];
+    if (type_of(piece) == PAWN)
+    {
+        pawn_key ^= Zobrist::PIECES[s][PAWN][sq];
+    }
+    psq += PSQT::TABLE[s][type_of(piece)][sq];
+    phase += PHASE_WEIGHT[type_of(piece)];
+}
+
+// --- Removes whatever piece stands on the square ---
+void Position::remove_piece(int sq)
+{
+    char piece = squares[sq];
+    if (piece == EMPTY)
+    {
+        return;
+    }
+
+    side s = side_of(piece);
+    Bitboard b = square_bb(sq);
+
+    pieces[s][type_of(piece)] &= ~b;
+    occupancy[s] &= ~b;
+    occupied &= ~b;
+    squares[sq] = EMPTY;
+    key ^= Zobrist::PIECES[s][type_of(piece)][sq];
+    if (type_of(piece) == PAWN)
+    {
+        pawn_key ^= Zobrist::PIECES[s][PAWN][sq];
+    }
+    psq -= PSQT::TABLE[s][type_of(piece)][sq];
+    phase -= PHASE_WEIGHT[type_of(piece)];
+}
+
+// --- Returns all pieces of either side attacking sq, given an occupancy ---
+Bitboard Position::attackers_to(int sq, Bitboard occupied_mask) const
+{
+    Bitboard bishops_queens = pieces[WHITE][BISHOP] | pieces[BLACK][BISHOP] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+    Bitboard rooks_queens = pieces[WHITE][ROOK] | pieces[BLACK][ROOK] | pieces[WHITE][QUEEN] | pieces[BLACK][QUEEN];
+
+    return (Attacks::pawn(BLACK, sq) & pieces[WHITE][PAWN]) |
+           (Attacks::pawn(WHITE, sq) & pieces[BLACK][PAWN]) |
+           (Attacks::knight(sq) & (pieces[WHITE][KNIGHT] | pieces[BLACK][KNIGHT])) |
+           (Attacks::king(sq) & (pieces[WHITE][KING] | pieces[BLACK][KING])) |
+           (Attacks::bishop(sq, occupied_mask) & bishops_queens) |
+           (Attacks::rook(sq, occupied_mask) & rooks_queens);
+}
+
+// --- Returns true if any piece of side 'by' attacks sq ---
+bool Position::is_attacked(int sq, side by) const
+{
+    // --- A pawn of 'by' attacks sq exactly when a pawn of the other side on sq would attack it ---
+    if (Attacks::pawn(opposite(by), sq) & pieces[by][PAWN])
+        return true;
+    if (Attacks::knight(sq) & pieces[by][KNIGHT])
+        return true;
+    if (Attacks::king(sq) & pieces[by][KING])
+        return true;
+    if (Attacks::bishop(sq, occupied) & (pieces[by][BISHOP] | pieces[by][QUEEN]))
+        return true;
+    if (Attacks::rook(sq, occupied) & (pieces[by][ROOK] | pieces[by][QUEEN]))
+        return true;
+    return false;
+}
+
+// --- Returns true if side s's king is attacked (false if s has no king) ---
+bool Position::in_check(side s) const
+{
+    if (!pieces[s][KING])
+    {
+        return false;
+    }
+    return is_attacked(king_square(s), opposite(s));
+}
+
+// --- Castling rights that survive a move touching each square (a1, e1, h1, a8, e8, h8) ---
+static int castling_mask_of(int sq)
+{
+    switch (sq)
+    {
+    case 0:
+        return ~WHITE_QUEENSIDE;
+    case 4:
+        return ~(WHITE_KINGSIDE | WHITE_QUEENSIDE);
+    case 7:
+        return ~WHITE_KINGSIDE;
+    case 56:
+        return ~BLACK_QUEENSIDE;
+    case 60:
+        return ~(BLACK_KINGSIDE | BLACK_QUEENSIDE);
+    case 63:
+        return ~BLACK_KINGSIDE;
+    default:
+        return ~0;
+    }
+}
+
+// --- Plays a pseudo-legal move in place and hands the turn to the other side ---
+void Position::make_move(Move m, Undo &undo)
+{
+    int from = move_from(m);
+    int to = move_to(m);
+    int flag = move_flag(m);
+    side us = to_move;
+    char piece = squares[from];
+
+    undo.castling = castling;
+    undo.en_passant = en_passant;
+    undo.key = key;
+    undo.captured = EMPTY;
+
+    // --- Hash out the old rights and en passant square, the new ones go in at the end ---
+    key ^= Zobrist::CASTLING[castling];
+    if (en_passant != NO_SQUARE)
+    {
+        key ^= Zobrist::EN_PASSANT[col_of(en_passant)];
+    }
+
+    castling &= castling_mask_of(from) & castling_mask_of(to);
+    en_passant = NO_SQUARE;
+
+    // --- Captured piece (en passant takes the pawn behind the target square) ---
+    if (flag == EN_PASSANT_CAPTURE)
+    {
+        undo.captured = squares[to ^ 8];
+        remove_piece(to ^ 8);
+    }
+    else if (is_capture(m))
+    {
+        undo.captured = squares[to];
+        remove_piece(to);
+    }
+
+    remove_piece(from);
+    put_piece(is_promotion(m) ? make_piece(us, (piece_type)promotion_index(m)) : piece, to);
+
+    if (flag == DOUBLE_PAWN_PUSH)
+    {
+        en_passant = (from + to) / 2;
+    }
+    else if (flag == KING_CASTLE)
+    {
+        char rook = squares[to + 1];
+        remove_piece(to + 1);
+        put_piece(rook, to - 1);
+    }
+    else if (flag == QUEEN_CASTLE)
+    {
+        char rook = squares[to - 2];
+        remove_piece(to - 2);
+        put_piece(rook, to + 1);
+    }
+
+    key ^= Zobrist::CASTLING[castling] ^ Zobrist::BLACK_TO_MOVE;
+    if (en_passant != NO_SQUARE)
+    {
+        key ^= Zobrist::EN_PASSANT[col_of(en_passant)];
+    }
+
+    to_move = opposite(us);
+}
+
+// --- Hands the turn over without moving; an en passant right lapses as after any move ---
+void Position::make_null_move(Undo &undo)
+{
+    undo.castling = castling;
+    undo.en_passant = en_passant;
+    undo.key = key;
+    undo.captured = EMPTY;
+
+    if (en_passant != NO_SQUARE)
+    {
+        key ^= Zobrist::EN_PASSANT[col_of(en_passant)];
+    }
+    en_passant = NO_SQUARE;
+    key ^= Zobrist::BLACK_TO_MOVE;
+    to_move = opposite(to_move);
+}
+
+void Position::unmake_null_move(const Undo &undo)
+{
+    to_move = opposite(to_move);
+    en_passant = undo.en_passant;
+    key = undo.key;
+}
+
+// --- Takes back the last move played with make_move ---
+void Position::unmake_move(Move m, const Undo &undo)
+{
+    int from = move_from(m);
+    int to = move_to(m);
+    int flag = move_flag(m);
+    side us = opposite(to_move);
+    char piece = squares[to];
+
+    to_move = us;
+    castling = undo.castling;
+    en_passant = undo.en_passant;
+
+    if (flag == KING_CASTLE)
+    {
+        char rook = squares[to - 1];
+        remove_piece(to - 1);
+        put_piece(rook, to + 1);
+    }
+    else if (flag == QUEEN_CASTLE)
+    {
+        char rook = squares[to + 1];
+        remove_piece(to + 1);
+        put_piece(rook, to - 2);
+    }
+
+    remove_piece(to);
+    put_piece(is_promotion(m) ? make_piece(us, PAWN) : piece, from);
+
+    if (undo.captured != EMPTY)
+    {
+        put_piece(undo.captured, flag == EN_PASSANT_CAPTURE ? (to ^ 8) : to);
+    }
+
+    // --- The placements above toggled piece keys back; restore the full key in one go ---
+    // --- psq and phase are sums, so the placements already restored them ---
+    key = undo.key;
+}
+
+// --- Places the pieces of an 8x8 board array onto an empty Position ---
+void Position::load_board(const char board[8][8])
+{
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            if (board[i][j] != EMPTY)
+            {
+                put_piece(board[i][j], square_of(i, j));
+            }
+        }
+    }
+}
+
+// --- Builds a Position from a board_state and the side to move ---
+// --- Castling rights are only kept if king and rook still stand on their home squares ---
+Position Position::from_board_state(const board_state &state, side to_move)
+{
+    Position pos;
+    pos.clear();
+    pos.to_move = to_move;
+    pos.load_board(state.board);
+
+    // --- can_castle_*[1] is the kingside (h-rook) right, [0] the queenside (a-rook) right ---
+    if (state.board[7][4] == WHITE_KING)
+    {
+        if (state.can_castle_white[1] && state.board[7][7] == WHITE_ROOK)
+            pos.castling |= WHITE_KINGSIDE;
+        if (state.can_castle_white[0] && state.board[7][0] == WHITE_ROOK)
+            pos.castling |= WHITE_QUEENSIDE;
+    }
+    if (state.board[0][4] == BLACK_KING)
+    {
+        if (state.can_castle_black[1] && state.board[0][7] == BLACK_ROOK)
+            pos.castling |= BLACK_KINGSIDE;
+        if (state.can_castle_black[0] && state.board[0][0] == BLACK_ROOK)
+            pos.castling |= BLACK_QUEENSIDE;
+    }
+
+    // --- The en passant flags belong to the side that just pushed a pawn two squares ---
+    for (int n = 0; n < 8; n++)
+    {
+        if (to_move == BLACK && state.pawn_two_squares_white[n] && state.board[4][n] == WHITE_PAWN)
+        {
+            pos.en_passant = square_of(5, n);
+        }
+        if (to_move == WHITE && state.pawn_two_squares_black[n] && state.board[3][n] == BLACK_PAWN)
+        {
+            pos.en_passant = square_of(2, n);
+        }
+    }
+
+    // --- Piece keys were added by put_piece, the remaining state goes in here ---
+    pos.key ^= Zobrist::CASTLING[pos.castling];
+    if (pos.en_passant != NO_SQUARE)
+    {
+        pos.key ^= Zobrist::EN_PASSANT[col_of(pos.en_passant)];
+    }
+    if (to_move == BLACK)
+    {
+        pos.key ^= Zobrist::BLACK_TO_MOVE;
+    }
+
+    return pos;
+}
+
+// --- Writes this Position back into a board_state ---
+// --- Only the side that just moved can have an en passant flag set ---
+void Position::to_board_state(board_state &state) const
+{
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            state.board[i][j] = squares[square_of(i, j)];
+        }
+        state.pawn_two_squares_white[i] = false;
+        state.pawn_two_squares_black[i] = false;
+    }
+
+    state.can_castle_white[1] = (castling & WHITE_KINGSIDE) != 0;
+    state.can_castle_white[0] = (castling & WHITE_QUEENSIDE) != 0;
+    state.can_castle_black[1] = (castling & BLACK_KINGSIDE) != 0;
+    state.can_castle_black[0] = (castling & BLACK_QUEENSIDE) != 0;
+
+    if (en_passant != NO_SQUARE)
+    {
+        if (to_move == BLACK)
+            state.pawn_two_squares_white[col_of(en_passant)] = true;
+        else
+            state.pawn_two_squares_black[col_of(en_passant)] = true;
+    }
+}
@@ -0,0 +1,137 @@
+// --------------------------------------------------------------------------------------
+// position.h
+// --- Declares the bitboard-based Position used by the engine's search.
+// --- Every piece type and colour has its own 64-bit mask, with per-side and total
+// --- occupancy masks kept alongside and a small mailbox for "what is on this square".
+// --- Positions convert to and from `board_state`, so the GUI and FEN loader keep
+// --- working on the 8x8 array while the engine works on bitboards.
+// --- Each Position also carries its Zobrist key, kept in sync by every placement,
+// --- and likewise the sum of its packed piece-square scores plus its game phase.
+// --------------------------------------------------------------------------------------
+
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <cstdint>
+#include "board.h"
+#include "move.h"
+#include "psqt.h"
+
+// --- One bit per square ---
+typedef uint64_t Bitboard;
+
+// --- Piece types, used as the second index of Position::pieces ---
+// --- Equal to abs(board.h piece constant) - 1 ---
+enum piece_type
+{
+    PAWN,
+    KNIGHT,
+    BISHOP,
+    ROOK,
+    QUEEN,
+    KING
+};
+
+// --- Squares are numbered a1 = 0, b1 = 1, ... h8 = 63 ---
+const int NO_SQUARE = -1;
+
+// --- Castling right bits stored in Position::castling ---
+const int WHITE_KINGSIDE = 1;
+const int WHITE_QUEENSIDE = 2;
+const int BLACK_KINGSIDE = 4;
+const int BLACK_QUEENSIDE = 8;
+
+// --- Useful masks ---
+const Bitboard FILE_A_BB = 0x0101010101010101ULL;
+const Bitboard FILE_H_BB = FILE_A_BB << 7;
+const Bitboard RANK_1_BB = 0xFFULL;
+const Bitboard RANK_8_BB = RANK_1_BB << 56;
+
+// --- Conversions between board_state (row i, column j) and square numbers ---
+// --- Row 0 of board_state is the 8th rank, so the rank is flipped ---
+inline int square_of(int i, int j) { return (7 - i) * 8 + j; }
+inline int row_of(int sq) { return 7 - (sq >> 3); }
+inline int col_of(int sq) { return sq & 7; }
+inline int rank_of(int sq) { return sq >> 3; }
+
+// --- Bit helpers ---
+inline Bitboard square_bb(int sq) { return 1ULL << sq; }
+inline int popcount(Bitboard b) { return __builtin_popcountll(b); }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int pop_lsb(Bitboard &b)
+{
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// --- Builds a board.h piece code (e.g. BLACK_ROOK) from a side and piece type ---
+inline char make_piece(side s, piece_type pt) { return s == WHITE ? (char)(pt + 1) : (char)(-(pt + 1)); }
+inline piece_type type_of(char piece) { return (piece_type)((piece > 0 ? piece : -piece) - 1); }
+inline side side_of(char piece) { return piece > 0 ? WHITE : BLACK; }
+constexpr side opposite(side s) { return s == WHITE ? BLACK : WHITE; }
+
+// --- Side-relative constants for code templated on a side (template <side S>), so each
+// --- colour gets its own copy with them folded in at compile time ---
+template <side S> constexpr int pawn_push() { return S == WHITE ? 8 : -8; }
+template <side S> constexpr int relative_square(int sq) { return S == WHITE ? sq : sq ^ 56; }
+template <side S> constexpr int relative_rank(int sq) { return S == WHITE ? sq >> 3 : 7 - (sq >> 3); }
+template <side S> constexpr Bitboard relative_rank_bb(int rank) { return RANK_1_BB << 8 * (S == WHITE ? rank : 7 - rank); }
+
+// --- State a move destroys, kept so unmake_move can restore it ---
+struct Undo
+{
+    char captured;  // --- Piece taken by the move, EMPTY if none ---
+    int castling;   // --- Castling rights before the move ---
+    int en_passant; // --- En passant square before the move ---
+    uint64_t key;   // --- Zobrist key before the move (the pawn key is restored by the placements) ---
+};
+
+// --- Bitboard position: piece masks, occupancy and game-state flags ---
+struct Position
+{
+    Bitboard pieces[2][6];  // --- [side][piece_type] ---
+    Bitboard occupancy[2];  // --- All pieces of one side ---
+    Bitboard occupied;      // --- All pieces of both sides ---
+    char squares[64];       // --- Mailbox with board.h piece codes, EMPTY if vacant ---
+    side to_move;           // --- Side to move (board_state does not store this) ---
+    int en_passant;         // --- Square a pawn may capture onto en passant, or NO_SQUARE ---
+    int castling;           // --- Combination of the castling right bits ---
+    uint64_t key;           // --- Zobrist key, updated incrementally (see zobrist.h) ---
+    uint64_t pawn_key;      // --- Zobrist key of the pawns alone, for the pawn hash table ---
+    Score psq;              // --- Material and piece-square score, updated incrementally (see psqt.h) ---
+    int phase;              // --- Sum of PHASE_WEIGHT over all pieces ---
+
+    // --- Empties the board and clears all flags ---
+    void clear();
+
+    // --- Piece placement (keeps masks and mailbox in sync) ---
+    void put_piece(char piece, int sq);
+    void remove_piece(int sq);
+
+    // --- Queries ---
+    char piece_on(int sq) const { return squares[sq]; }
+    Bitboard pieces_of(side s, piece_type pt) const { return pieces[s][pt]; }
+    int king_square(side s) const { return lsb(pieces[s][KING]); }
+
+    // --- Attack detection through the tables in attacks.h ---
+    Bitboard attackers_to(int sq, Bitboard occupied_mask) const;
+    bool is_attacked(int sq, side by) const;
+    bool in_check(side s) const;
+
+    // --- Plays a pseudo-legal move in place and hands the turn to the other side ---
+    void make_move(Move m, Undo &undo);
+    // --- Takes back the last move played with make_move ---
+    void unmake_move(Move m, const Undo &undo);
+
+    // --- Passes the turn without moving (for null move pruning), and takes the pass back ---
+    void make_null_move(Undo &undo);
+    void unmake_null_move(const Undo &undo);
+
+    // --- Conversion from and to the GUI representation ---
+    void load_board(const char board[8][8]);
+    static Position from_board_state(const board_state &state, side to_move);
+    void to_board_state(board_state &state) const;
+};
+
+#endif
@@ -0,0 +1,112 @@
+// --------------------------------------------------------------------------------------
+// psqt.cpp
+// --- Defines the piece-square tables declared in psqt.h.
+// --- Tables are written from White's side with row 0 as the 8th rank, like board_state.
+// --- Only the king has separate middlegame and endgame tables; the other pieces use the
+// --- same values in both phases.
+// --------------------------------------------------------------------------------------
+
+#include "psqt.h"
+#include "position.h"
+
+Score PSQT::TABLE[2][6][64];
+
+// --- Material values in centipawns (the king is never captured) ---
+static const int MATERIAL[6] = {100, 320, 330, 500, 900, 0};
+
+// --- Pawn Position Table ---
+static const int PAWN_TABLE[8][8] = {
+    {0, 0, 0, 0, 0, 0, 0, 0},
+    {50, 50, 50, 50, 50, 50, 50, 50},
+    {10, 10, 20, 30, 30, 20, 10, 10},
+    {5, 5, 10, 25, 25, 10, 5, 5},
+    {0, 0, 0, 20, 20, 0, 0, 0},
+    {5, -5, -10, 0, 0, -10, -5, 5},
+    {5, 10, 10, -20, -20, 10, 10, 5},
+    {0, 0, 0, 0, 0, 0, 0, 0}};
+
+// --- Knight Position Table ---
+static const int KNIGHT_TABLE[8][8] = {
+    {-50, -40, -30, -30, -30, -30, -40, -50},
+    {-40, -20, 0, 0, 0, 0, -20, -40},
+    {-30, 0, 10, 15, 15, 10, 0, -30},
+    {-30, 5, 15, 20, 20, 15, 5, -30},
+    {-30, 0, 15, 20, 20, 15, 0, -30},
+    {-30, 5, 10, 15, 15, 10, 5, -30},
+    {-40, -20, 0, 5, 5, 0, -20, -40},
+    {-50, -40, -30, -30, -30, -30, -40, -50}};
+
+// --- Bishop Position Table ---
+static const int BISHOP_TABLE[8][8] = {
+    {-20, -10, -10, -10, -10, -10, -10, -20},
+    {-10, 0, 0, 0, 0, 0, 0, -10},
+    {-10, 0, 5, 10, 10, 5, 0, -10},
+    {-10, 5, 5, 10, 10, 5, 5, -10},
+    {-10, 0, 10, 10, 10, 10, 0, -10},
+    {-10, 10, 10, 10, 10, 10, 10, -10},
+    {-10, 5, 0, 0, 0, 0, 5, -10},
+    {-20, -10, -10, -10, -10, -10, -10, -20}};
+
+// --- Rook Position Table ---
+static const int ROOK_TABLE[8][8] = {
+    {0, 0, 0, 0, 0, 0, 0, 0},
+    {5, 10, 10, 10, 10, 10, 10, 5},
+    {-5, 0, 0, 0, 0, 0, 0, -5},
+    {-5, 0, 0, 0, 0, 0, 0, -5},
+    {-5, 0, 0, 0, 0, 0, 0, -5},
+    {-5, 0, 0, 0, 0, 0, 0, -5},
+    {-5, 0, 0, 0, 0, 0, 0, -5},
+    {0, 0, 0, 5, 5, 3, 0, 0}};
+
+// --- Queen Position Table ---
+static const int QUEEN_TABLE[8][8] = {
+    {-20, -10, -10, -5, -5, -10, -10, -20},
+    {-10, 0, 0, 0, 0, 0, 0, -10},
+    {-10, 0, 5, 5, 5, 5, 0, -10},
+    {-5, 0, 5, 5, 5, 5, 0, -5},
+    {0, 0, 5, 5, 5, 5, 0, -5},
+    {-10, 5, 5, 5, 5, 5, 0, -10},
+    {-10, 0, 5, 0, 0, 0, 0, -10},
+    {-20, -10, -10, -5, -5, -10, -10, -20}};
+
+// --- King Middle Game Position Table ---
+static const int KING_MIDDLE_TABLE[8][8] = {
+    {-30, -40, -40, -50, -50, -40, -40, -30},
+    {-30, -40, -40, -50, -50, -40, -40, -30},
+    {-30, -40, -40, -50, -50, -40, -40, -30},
+    {-30, -40, -40, -50, -50, -40, -40, -30},
+    {-20, -30, -30, -40, -40, -30, -30, -20},
+    {-10, -20, -20, -20, -20, -20, -20, -10},
+    {20, 20, 0, 0, 0, 0, 20, 20},
+    {20, 30, 10, 0, 0, 10, 30, 20}};
+
+// --- King End Game Position Table ---
+static const int KING_END_TABLE[8][8] = {
+    {-50, -40, -30, -20, -20, -30, -40, -50},
+    {-30, -20, -10, 0, 0, -10, -20, -30},
+    {-30, -10, 20, 30, 30, 20, -10, -30},
+    {-30, -10, 30, 40, 40, 30, -10, -30},
+    {-30, -10, 30, 40, 40, 30, -10, -30},
+    {-30, -10, 20, 30, 30, 20, -10, -30},
+    {-30, -30, 0, 0, 0, 0, -30, -30},
+    {-50, -30, -30, -30, -30, -30, -30, -50}};
+
+// --- Middlegame and endgame tables per piece type ---
+static const int (*const MIDDLE_TABLES[6])[8] = {PAWN_TABLE, KNIGHT_TABLE, BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE, KING_MIDDLE_TABLE};
+static const int (*const END_TABLES[6])[8] = {PAWN_TABLE, KNIGHT_TABLE, BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE, KING_END_TABLE};
+
+// --- Packs material and position values; Black looks up the square mirrored to White's side ---
+void PSQT::initialize()
+{
+    for (int pt = 0; pt < 6; pt++)
+    {
+        for (int sq = 0; sq < 64; sq++)
+        {
+            int i = row_of(sq), j = col_of(sq);
+            Score white = make_score(MATERIAL[pt] + MIDDLE_TABLES[pt][i][j], MATERIAL[pt] + END_TABLES[pt][i][j]);
+
+            TABLE[WHITE][pt][sq] = white;
+            TABLE[BLACK][pt][sq ^ 56] = -white;
+        }
+    }
+}
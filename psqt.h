@@ -0,0 +1,37 @@
+// --------------------------------------------------------------------------------------
+// psqt.h
+// --- Declares the packed, tapered piece-square tables used by the evaluation.
+// --- Every entry holds a middlegame and an endgame value (material included) packed into
+// --- one 32-bit Score, so a Position can add them up incrementally as pieces move and
+// --- the evaluation only has to blend the two halves by game phase.
+// --- Black's entries are White's, mirrored over the board's middle rank and negated.
+// --- Tables are filled once by PSQT::initialize(), which Engine::Engine() calls.
+// --------------------------------------------------------------------------------------
+
+#ifndef PSQT_H
+#define PSQT_H
+
+#include <cstdint>
+
+// --- Middlegame value in the lower 16 bits, endgame value in the upper 16 bits ---
+// --- Packed scores can be added and subtracted like plain integers ---
+typedef int32_t Score;
+
+inline Score make_score(int mg, int eg) { return (Score)((uint32_t)eg << 16) + mg; }
+inline int mg_value(Score s) { return (int16_t)(uint16_t)(uint32_t)s; }
+inline int eg_value(Score s) { return (int16_t)(uint16_t)((uint32_t)(s + 0x8000) >> 16); }
+
+// --- Game phase: 24 with all pieces on the board, 0 with only kings and pawns ---
+const int PHASE_WEIGHT[6] = {0, 1, 1, 2, 4, 0}; // --- Indexed by piece_type ---
+const int MAX_PHASE = 24;
+
+class PSQT
+{
+public:
+    static Score TABLE[2][6][64]; // --- [side][piece_type][square], from White's point of view ---
+
+    // --- Fills the tables; safe to call more than once ---
+    static void initialize();
+};
+
+#endif
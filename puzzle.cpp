@@ -4,6 +4,7 @@
 // --------------------------------------------------------------------------------------
 
 #include "puzzle.h"
+#include "puzzledb.h"
 #include "board.h"
 #include <fstream>
 #include <sstream>
@@ -11,6 +12,9 @@
 #include <ctime>
 #include <iostream>
 #include <random>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
 
 // --- External board instance shared across modules ---
 extern Board board;
@@ -18,100 +22,292 @@ extern Board board;
 // --- Global instance to hold the currently active puzzle ---
 Puzzle currentPuzzle;
 
-// --- Loads a puzzle from a CSV file based on given difficulty level.
-// --- Returns true if puzzle is successfully loaded; false otherwise.
-bool load_puzzle_by_difficulty(int difficulty)
+// --- Puzzle files per difficulty level (1 = Easy .. 4 = Endgame), without extension.
+// --- "<name>.bin" is the indexed database made by tools/puzzle_convert, "<name>.csv" the source ---
+static const char *PUZZLE_FILES[] = {
+    "puzzles/puzzles_easy",
+    "puzzles/puzzles_medium",
+    "puzzles/puzzles_hard",
+    "puzzles/endgame_puzzles",
+};
+const int PUZZLE_FILE_COUNT = sizeof(PUZZLE_FILES) / sizeof(PUZZLE_FILES[0]);
+
+// --- Databases stay mapped once opened; a missing .bin is only looked for once ---
+static PuzzleDatabase puzzle_databases[PUZZLE_FILE_COUNT];
+static bool puzzle_database_checked[PUZZLE_FILE_COUNT];
+
+// --- One generator for all picks, so two puzzles loaded in the same second differ ---
+static std::mt19937 puzzle_rng(static_cast<unsigned int>(time(nullptr)));
+
+// --- Returns the mapped database for a difficulty, or NULL if there is no usable .bin ---
+static const PuzzleDatabase *puzzle_database(int difficulty)
 {
-    std::string file;
+    if (difficulty < 1 || difficulty > PUZZLE_FILE_COUNT)
+        return NULL;
 
-    // --- Select file based on difficulty ---
-    switch (difficulty)
+    int n = difficulty - 1;
+    if (!puzzle_database_checked[n])
     {
-    case 1:
-        file = "puzzles/puzzles_easy.csv";
-        break;
-    case 2:
-        file = "puzzles/puzzles_medium.csv";
-        break;
-    case 3:
-        file = "puzzles/puzzles_hard.csv";
-        break;
-    case 4:
-        file = "puzzles/endgame_puzzles.csv";
-        break;
-    default:
-        return false;
+        puzzle_database_checked[n] = true;
+        puzzle_databases[n].open(std::string(PUZZLE_FILES[n]) + ".bin");
     }
+    return puzzle_databases[n].size() > 0 ? &puzzle_databases[n] : NULL;
+}
 
-    // --- Open the file ---
-    std::ifstream in(file);
-    if (!in.is_open())
-    {
-        std::cerr << "Failed to open " << file << "\n";
+// --- Fills a Puzzle from one CSV row: id, FEN, moves, rating, popularity, themes, difficulty ---
+bool parse_puzzle_csv_line(const std::string &line, Puzzle &puzzle, std::string *themes)
+{
+    std::stringstream ss(line);
+    std::string id, fen, moves, rating, popularity, theme_list, difficulty;
+
+    std::getline(ss, id, ',');
+    std::getline(ss, fen, ',');
+    std::getline(ss, moves, ',');
+    std::getline(ss, rating, ',');
+    std::getline(ss, popularity, ',');
+    std::getline(ss, theme_list, ',');
+    std::getline(ss, difficulty, ',');
+
+    if (!difficulty.empty() && difficulty[difficulty.size() - 1] == '\r')
+        difficulty.erase(difficulty.size() - 1);
+    if (fen.empty() || moves.empty())
         return false;
+
+    // --- Store puzzle metadata ---
+    puzzle.id = id;
+    puzzle.fen = fen;
+    puzzle.rating = rating;
+    puzzle.themes = difficulty;
+    if (themes)
+        *themes = theme_list;
+
+    // --- Clear move history ---
+    puzzle.bestMoves.clear();
+    puzzle.playerMoves.clear();
+
+    // --- Generate internal board representation from FEN ---
+    reset_board_state(puzzle.puzzle_board_state);
+    set_board_from_fen(fen, puzzle.puzzle_board_state);
+
+    // --- Parse best move sequence into vector ---
+    std::stringstream moveStream(moves);
+    std::string move;
+    while (moveStream >> move)
+    {
+        puzzle.bestMoves.push_back(move);
     }
 
-    // --- Skip CSV header line ---
-    std::string header;
-    std::getline(in, header);
+    return true;
+}
+
+// --- Rows of each difficulty's CSV, read once, for when there is no .bin database ---
+static std::vector<std::string> csv_rows[PUZZLE_FILE_COUNT];
+static bool csv_read[PUZZLE_FILE_COUNT];
+
+// --- Guards the databases, the cached CSV rows and puzzle_rng: the Puzzle Rush prefetch
+// --- thread loads puzzles while the GUI thread may load one for another mode ---
+static std::mutex puzzle_load_mutex;
+
+// --- Loads a random puzzle of the given difficulty level into puzzle.
+// --- Uses the indexed .bin database when there is one, otherwise the CSV's rows ---
+static bool load_random_puzzle(int difficulty, Puzzle &puzzle)
+{
+    if (difficulty < 1 || difficulty > PUZZLE_FILE_COUNT)
+        return false;
+
+    std::lock_guard<std::mutex> lock(puzzle_load_mutex);
 
-    std::vector<std::string> lines;
-    std::string line;
+    // --- O(1): one record of the mapped database ---
+    const PuzzleDatabase *db = puzzle_database(difficulty);
+    if (db)
+    {
+        std::uniform_int_distribution<uint32_t> dist(0, db->size() - 1);
+        return db->load(dist(puzzle_rng), puzzle);
+    }
 
-    // --- Read all non-empty lines into vector ---
-    while (std::getline(in, line))
+    std::vector<std::string> &lines = csv_rows[difficulty - 1];
+    if (!csv_read[difficulty - 1])
     {
-        if (!line.empty())
-            lines.push_back(line);
+        csv_read[difficulty - 1] = true;
+        std::string file = std::string(PUZZLE_FILES[difficulty - 1]) + ".csv";
+
+        // --- Open the file ---
+        std::ifstream in(file);
+        if (!in.is_open())
+        {
+            std::cerr << "Failed to open " << file << "\n";
+            return false;
+        }
+
+        // --- Skip CSV header line ---
+        std::string header;
+        std::getline(in, header);
+
+        // --- Read all non-empty lines into vector ---
+        std::string line;
+        while (std::getline(in, line))
+        {
+            if (!line.empty())
+                lines.push_back(line);
+        }
     }
 
     if (lines.empty())
         return false;
 
     // --- Pick a random puzzle line ---
-    std::mt19937 rng(static_cast<unsigned int>(time(nullptr)));
     std::uniform_int_distribution<> dist(0, lines.size() - 1);
-    std::string chosen = lines[dist(rng)];
+    return parse_puzzle_csv_line(lines[dist(puzzle_rng)], puzzle);
+}
 
-    // --- Extract fields from CSV line ---
-    std::stringstream ss(chosen);
-    std::string id, fen, moves, rating, popularity, themes, difficulty;
+// --- Picks a random puzzle rated min_rating..max_rating from a difficulty's database ---
+bool load_puzzle_by_rating(int difficulty, int min_rating, int max_rating)
+{
+    std::lock_guard<std::mutex> lock(puzzle_load_mutex);
 
-    std::getline(ss, id, ',');
-    std::getline(ss, fen, ',');
-    std::getline(ss, moves, ',');
-    std::getline(ss, rating, ',');
-    std::getline(ss, popularity, ',');
-    std::getline(ss, themes, ',');
-    std::getline(ss, difficulty, ',');
+    const PuzzleDatabase *db = puzzle_database(difficulty);
+    if (!db)
+        return false;
 
-    // --- Store puzzle metadata ---
-    currentPuzzle.id = id;
-    currentPuzzle.fen = fen;
-    currentPuzzle.rating = rating;
-    currentPuzzle.themes = difficulty;
+    uint32_t first, last;
+    db->rating_range(min_rating, max_rating, first, last);
+    if (first >= last)
+        return false;
 
-    // --- Clear move history ---
-    currentPuzzle.bestMoves.clear();
-    currentPuzzle.playerMoves.clear();
+    std::uniform_int_distribution<uint32_t> dist(first, last - 1);
+    return db->load(dist(puzzle_rng), currentPuzzle);
+}
 
-    // --- Generate internal board representation from FEN ---
-    set_board_from_fen(fen, currentPuzzle.puzzle_board_state);
+// --- Loads a puzzle from the given difficulty level into currentPuzzle.
+// --- Returns true if puzzle is successfully loaded; false otherwise.
+bool load_puzzle_by_difficulty(int difficulty)
+{
+    return load_random_puzzle(difficulty, currentPuzzle);
+}
+
+// --- Puzzle Rush prefetch: a producer thread keeps a ring of parsed puzzles of random
+// --- difficulty filled, so start_puzzle() hands out the next one without touching a file ---
+const int PREFETCH_SLOTS = 4;
+
+class PuzzlePrefetcher
+{
+private:
+    Puzzle ring[PREFETCH_SLOTS];
+    int head = 0;         // --- Slot of the oldest ready puzzle ---
+    int count = 0;        // --- Ready puzzles ---
+    bool stopping = false;
+    bool failed = false;  // --- No difficulty could be loaded; the producer has given up ---
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread producer;
+
+    void run();
+
+public:
+    ~PuzzlePrefetcher() { stop(); }
+
+    void start();
+    void stop();
+    bool running() { return producer.joinable(); }
+
+    // --- Moves the next ready puzzle into puzzle, waiting if the ring is empty ---
+    bool next(Puzzle &puzzle);
+};
+
+void PuzzlePrefetcher::run()
+{
+    std::mt19937 gen(std::random_device{}());
+    std::uniform_int_distribution<> dist(1, 3);
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [this]
+                         { return stopping || count < PREFETCH_SLOTS; });
+            if (stopping)
+                return;
+        }
+
+        // --- Random difficulty between 1 and 3, or one of the others if its file is missing ---
+        Puzzle puzzle;
+        int first = dist(gen);
+        bool loaded = false;
+        for (int n = 0; n < 3 && !loaded; n++)
+        {
+            loaded = load_random_puzzle((first - 1 + n) % 3 + 1, puzzle);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!loaded)
+        {
+            failed = true;
+            changed.notify_all();
+            return;
+        }
+        ring[(head + count) % PREFETCH_SLOTS] = std::move(puzzle);
+        count++;
+        changed.notify_all();
+    }
+}
+
+void PuzzlePrefetcher::start()
+{
+    if (producer.joinable())
+        return;
+
+    head = count = 0;
+    stopping = failed = false;
+    producer = std::thread(&PuzzlePrefetcher::run, this);
+}
+
+void PuzzlePrefetcher::stop()
+{
+    if (!producer.joinable())
+        return;
 
-    // --- Parse best move sequence into vector ---
-    std::stringstream moveStream(moves);
-    std::string move;
-    while (moveStream >> move)
     {
-        currentPuzzle.bestMoves.push_back(move);
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
     }
+    changed.notify_all();
+    producer.join();
+}
+
+bool PuzzlePrefetcher::next(Puzzle &puzzle)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]
+                 { return count > 0 || failed || stopping; });
+    if (count == 0)
+        return false;
 
+    puzzle = std::move(ring[head]);
+    head = (head + 1) % PREFETCH_SLOTS;
+    count--;
+    changed.notify_all();
     return true;
 }
 
-// --- Initializes puzzle rush mode by randomly selecting a difficulty and loading a puzzle ---
+static PuzzlePrefetcher puzzle_prefetcher;
+
+void start_puzzle_prefetch()
+{
+    puzzle_prefetcher.start();
+}
+
+void stop_puzzle_prefetch()
+{
+    puzzle_prefetcher.stop();
+}
+
+// --- Loads the next Puzzle Rush puzzle: a prefetched one when the producer is running,
+// --- otherwise one of a randomly selected difficulty loaded right here ---
 void start_puzzle()
 {
+    if (puzzle_prefetcher.running() && puzzle_prefetcher.next(currentPuzzle))
+        return;
+
     // --- Randomly select a difficulty between 1 and 3 ---
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -207,18 +403,29 @@ void set_board_from_fen(const std::string &fen, board_state &bs)
             bs.can_castle_black[0] = true; // Black queenside
     }
 
-    // --- Parse en passant square ---
+    // --- Parse en passant square: a target on the 3rd rank means White just pushed two squares ---
     if (enpassant != "-")
     {
         int file = enpassant[0] - 'a';
         int rank = enpassant[1] - '1';
         if (rank == 2)
-            bs.pawn_two_squares_black[file] = true;
-        else if (rank == 5)
             bs.pawn_two_squares_white[file] = true;
+        else if (rank == 5)
+            bs.pawn_two_squares_black[file] = true;
     }
 }
 
+Position position_from_fen(const std::string &fen)
+{
+    // --- set_board_from_fen() leaves empty squares alone, so start from an empty board ---
+    board_state state = {};
+    set_board_from_fen(fen, state);
+
+    std::string placement, turn;
+    std::istringstream(fen) >> placement >> turn;
+    return Position::from_board_state(state, turn == "b" ? BLACK : WHITE);
+}
+
 // --- Resets the given board_state to an empty/default state.
 // --- Clears board, castling rights, and en passant flags.
 void reset_board_state(board_state &bs)
@@ -9,6 +9,7 @@
 #include <vector>
 #include <string>
 #include "board.h"  // --- Required for board_state struct ---
+#include "position.h"
 
 // --- Represents a single chess puzzle ---
 struct Puzzle
@@ -28,12 +29,22 @@ struct Puzzle
 extern Puzzle currentPuzzle;
 
 // --- Puzzle Lifecycle Functions ---
-// --- Loads a puzzle based on difficulty level (e.g., 0 = Easy, 1 = Medium, 2 = Hard) ---
+// --- Loads a puzzle based on difficulty level (1 = Easy, 2 = Medium, 3 = Hard, 4 = Endgame) ---
 bool load_puzzle_by_difficulty(int difficulty);
 
-// --- Initializes the current puzzle (resets board state, move counters, etc.) ---
+// --- Loads a random puzzle rated min_rating..max_rating; needs the difficulty's .bin database ---
+bool load_puzzle_by_rating(int difficulty, int min_rating, int max_rating);
+
+// --- Parses one puzzle CSV row into puzzle; the row's theme list goes to *themes if given ---
+bool parse_puzzle_csv_line(const std::string &line, Puzzle &puzzle, std::string *themes = nullptr);
+
+// --- Loads the next Puzzle Rush puzzle into currentPuzzle, from the prefetch ring when it runs ---
 void start_puzzle();
 
+// --- Starts / stops the background thread that keeps Puzzle Rush puzzles loaded ahead ---
+void start_puzzle_prefetch();
+void stop_puzzle_prefetch();
+
 // --- Move Handling Functions ---
 // --- Executes a move in the current puzzle given algebraic move notation ---
 void play_move(const std::string &move_str);
@@ -45,5 +56,8 @@ int piece_char_to_int(char c);
 // --- Parses a FEN string and updates a board_state object accordingly ---
 void set_board_from_fen(const std::string& fen, board_state& bs);
 
+// --- Builds the engine Position for a FEN; the side to move is the FEN's second field ---
+Position position_from_fen(const std::string &fen);
+
 // --- Resets the board_state object to an empty/default state ---
 void reset_board_state(board_state &bs);
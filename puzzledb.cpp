@@ -0,0 +1,440 @@
+// --------------------------------------------------------------------------------------
+// puzzledb.cpp
+// --- Implements the binary puzzle database declared in puzzledb.h: the reader that
+// --- maps the file and the writer used by the offline converter.
+// --------------------------------------------------------------------------------------
+
+#include "puzzledb.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+static_assert(sizeof(PuzzleDbHeader) == 80, "PuzzleDbHeader layout is part of the file format");
+static_assert(sizeof(PuzzleRecord) == 48, "PuzzleRecord layout is part of the file format");
+static_assert(sizeof(PuzzleDbTheme) == 16, "PuzzleDbTheme layout is part of the file format");
+
+static const char *PROMOTION_LETTERS = " nbrq";
+static const char *FEN_LETTERS = " PNBRQKpnbrqk";
+
+// --- Board piece code (-6..6) to record nibble and back ---
+static uint8_t nibble_of(char piece)
+{
+    return piece > 0 ? (uint8_t)piece : piece < 0 ? (uint8_t)(6 - piece) : 0;
+}
+
+static char piece_of(uint8_t nibble)
+{
+    return nibble == 0 ? EMPTY : nibble <= 6 ? (char)nibble : (char)(6 - nibble);
+}
+
+static int clamp_rating(int rating)
+{
+    return std::max(0, std::min(RATING_SLOTS - 1, rating));
+}
+
+uint16_t pack_puzzle_move(const std::string &uci)
+{
+    if (uci.size() < 4)
+    {
+        return 0;
+    }
+
+    int from = (uci[0] - 'a') + 8 * (uci[1] - '1');
+    int to = (uci[2] - 'a') + 8 * (uci[3] - '1');
+    int promotion = 0;
+    if (uci.size() > 4)
+    {
+        const char *letter = strchr(PROMOTION_LETTERS + 1, uci[4]);
+        promotion = letter ? (int)(letter - PROMOTION_LETTERS) : 0;
+    }
+    return (uint16_t)((from & 63) | (to & 63) << 6 | promotion << 12);
+}
+
+std::string unpack_puzzle_move(uint16_t packed)
+{
+    int from = packed & 63;
+    int to = (packed >> 6) & 63;
+    int promotion = (packed >> 12) & 7;
+
+    std::string uci;
+    uci += (char)('a' + from % 8);
+    uci += (char)('1' + from / 8);
+    uci += (char)('a' + to % 8);
+    uci += (char)('1' + to / 8);
+    if (promotion >= 1 && promotion <= 4)
+    {
+        uci += PROMOTION_LETTERS[promotion];
+    }
+    return uci;
+}
+
+// --- Writes a record's position as FEN, so the loaded Puzzle carries the usual text form ---
+static std::string record_fen(const board_state &bs, const PuzzleRecord &record)
+{
+    std::string fen;
+    for (int i = 0; i < 8; i++)
+    {
+        int empty = 0;
+        for (int j = 0; j < 8; j++)
+        {
+            uint8_t n = nibble_of(bs.board[i][j]);
+            if (n == 0)
+            {
+                empty++;
+                continue;
+            }
+            if (empty)
+            {
+                fen += (char)('0' + empty);
+                empty = 0;
+            }
+            fen += FEN_LETTERS[n];
+        }
+        if (empty)
+        {
+            fen += (char)('0' + empty);
+        }
+        if (i < 7)
+        {
+            fen += '/';
+        }
+    }
+
+    bool black = (record.flags & PUZZLE_BLACK_TO_MOVE) != 0;
+    fen += black ? " b " : " w ";
+
+    std::string castling;
+    if (record.flags & PUZZLE_CASTLE_WHITE_KINGSIDE)
+        castling += 'K';
+    if (record.flags & PUZZLE_CASTLE_WHITE_QUEENSIDE)
+        castling += 'Q';
+    if (record.flags & PUZZLE_CASTLE_BLACK_KINGSIDE)
+        castling += 'k';
+    if (record.flags & PUZZLE_CASTLE_BLACK_QUEENSIDE)
+        castling += 'q';
+    fen += castling.empty() ? "-" : castling;
+
+    // --- The target square lies behind the pawn: rank 3 after a white push, rank 6 after a black one ---
+    if (record.en_passant < 8)
+    {
+        fen += ' ';
+        fen += (char)('a' + record.en_passant);
+        fen += black ? '3' : '6';
+    }
+    else
+    {
+        fen += " -";
+    }
+    return fen + " 0 1";
+}
+
+PuzzleDatabase::PuzzleDatabase()
+    : header(NULL), records(NULL), rating_start(NULL), themes(NULL), theme_records(NULL), moves(NULL), text(NULL)
+{
+}
+
+bool PuzzleDatabase::open(const std::string &path)
+{
+    close();
+    if (!file.open(path))
+    {
+        return false;
+    }
+
+    const unsigned char *base = file.data();
+    const PuzzleDbHeader *h = (const PuzzleDbHeader *)base;
+    if (file.size() < sizeof(PuzzleDbHeader) || h->magic != PUZZLE_DB_MAGIC || h->version != PUZZLE_DB_VERSION)
+    {
+        close();
+        return false;
+    }
+
+    // --- Every section has to lie inside the file ---
+    uint64_t size = file.size();
+    if (h->records_offset + (uint64_t)h->puzzle_count * sizeof(PuzzleRecord) > size ||
+        h->rating_index_offset + (RATING_SLOTS + 1) * sizeof(uint32_t) > size ||
+        h->themes_offset + (uint64_t)h->theme_count * sizeof(PuzzleDbTheme) > size ||
+        h->theme_records_offset + (uint64_t)h->theme_record_count * sizeof(uint32_t) > size ||
+        h->moves_offset + (uint64_t)h->move_count * sizeof(uint16_t) > size ||
+        h->text_offset + h->text_size > size)
+    {
+        close();
+        return false;
+    }
+
+    header = h;
+    records = (const PuzzleRecord *)(base + h->records_offset);
+    rating_start = (const uint32_t *)(base + h->rating_index_offset);
+    themes = (const PuzzleDbTheme *)(base + h->themes_offset);
+    theme_records = (const uint32_t *)(base + h->theme_records_offset);
+    moves = (const uint16_t *)(base + h->moves_offset);
+    text = (const char *)(base + h->text_offset);
+    return true;
+}
+
+void PuzzleDatabase::close()
+{
+    file.close();
+    header = NULL;
+    records = NULL;
+    rating_start = NULL;
+    themes = NULL;
+    theme_records = NULL;
+    moves = NULL;
+    text = NULL;
+}
+
+bool PuzzleDatabase::load(uint32_t index, Puzzle &puzzle) const
+{
+    if (!header || index >= header->puzzle_count)
+    {
+        return false;
+    }
+
+    const PuzzleRecord &record = records[index];
+    if ((uint64_t)record.first_move + record.move_count > header->move_count ||
+        (uint64_t)record.text_start + record.id_length + record.label_length > header->text_size)
+    {
+        return false;
+    }
+
+    board_state &bs = puzzle.puzzle_board_state;
+    for (int sq = 0; sq < 64; sq++)
+    {
+        uint8_t n = (sq & 1) ? record.squares[sq / 2] >> 4 : record.squares[sq / 2] & 15;
+        bs.board[sq / 8][sq % 8] = piece_of(n);
+    }
+
+    bs.can_castle_white[0] = (record.flags & PUZZLE_CASTLE_WHITE_QUEENSIDE) != 0;
+    bs.can_castle_white[1] = (record.flags & PUZZLE_CASTLE_WHITE_KINGSIDE) != 0;
+    bs.can_castle_black[0] = (record.flags & PUZZLE_CASTLE_BLACK_QUEENSIDE) != 0;
+    bs.can_castle_black[1] = (record.flags & PUZZLE_CASTLE_BLACK_KINGSIDE) != 0;
+
+    bool black = (record.flags & PUZZLE_BLACK_TO_MOVE) != 0;
+    for (int n = 0; n < 8; n++)
+    {
+        bs.pawn_two_squares_white[n] = black && record.en_passant == n;
+        bs.pawn_two_squares_black[n] = !black && record.en_passant == n;
+    }
+
+    const char *id = text + record.text_start;
+    puzzle.id.assign(id, record.id_length);
+    puzzle.themes.assign(id + record.id_length, record.label_length);
+    puzzle.rating = std::to_string(record.rating);
+    puzzle.fen = record_fen(bs, record);
+
+    puzzle.bestMoves.clear();
+    puzzle.playerMoves.clear();
+    for (int m = 0; m < record.move_count; m++)
+    {
+        puzzle.bestMoves.push_back(unpack_puzzle_move(moves[record.first_move + m]));
+    }
+    return true;
+}
+
+void PuzzleDatabase::rating_range(int min_rating, int max_rating, uint32_t &first, uint32_t &last) const
+{
+    first = last = 0;
+    if (!header || min_rating > max_rating)
+    {
+        return;
+    }
+    first = rating_start[clamp_rating(min_rating)];
+    last = rating_start[clamp_rating(max_rating) + 1];
+}
+
+int PuzzleDatabase::find_theme(const std::string &name) const
+{
+    for (uint32_t t = 0; header && t < header->theme_count; t++)
+    {
+        if (name.size() == themes[t].name_length && name.compare(0, name.size(), text + themes[t].name_start, themes[t].name_length) == 0)
+        {
+            return (int)t;
+        }
+    }
+    return -1;
+}
+
+uint32_t PuzzleDatabase::theme_size(int theme) const
+{
+    if (!header || theme < 0 || (uint32_t)theme >= header->theme_count)
+    {
+        return 0;
+    }
+    return themes[theme].record_count;
+}
+
+uint32_t PuzzleDatabase::theme_puzzle(int theme, uint32_t n) const
+{
+    return theme_records[themes[theme].first_record + n];
+}
+
+side PuzzleDatabase::to_move(uint32_t index) const
+{
+    return (records[index].flags & PUZZLE_BLACK_TO_MOVE) ? BLACK : WHITE;
+}
+
+uint32_t PuzzleDatabaseWriter::add_text(const std::string &s)
+{
+    uint32_t start = (uint32_t)text.size();
+    text += s;
+    return start;
+}
+
+uint32_t PuzzleDatabaseWriter::theme_id(const std::string &name)
+{
+    std::map<std::string, uint32_t>::iterator it = theme_lookup.find(name);
+    if (it != theme_lookup.end())
+    {
+        return it->second;
+    }
+    theme_names.push_back(name);
+    theme_lookup[name] = (uint32_t)theme_names.size() - 1;
+    return (uint32_t)theme_names.size() - 1;
+}
+
+void PuzzleDatabaseWriter::add(const Puzzle &puzzle, side to_move, const std::string &theme_list)
+{
+    Entry entry;
+    PuzzleRecord &record = entry.record;
+    memset(&record, 0, sizeof(record));
+
+    const board_state &bs = puzzle.puzzle_board_state;
+    for (int sq = 0; sq < 64; sq++)
+    {
+        uint8_t n = nibble_of(bs.board[sq / 8][sq % 8]);
+        record.squares[sq / 2] |= (sq & 1) ? (uint8_t)(n << 4) : n;
+    }
+
+    record.flags = to_move == BLACK ? PUZZLE_BLACK_TO_MOVE : 0;
+    if (bs.can_castle_white[0])
+        record.flags |= PUZZLE_CASTLE_WHITE_QUEENSIDE;
+    if (bs.can_castle_white[1])
+        record.flags |= PUZZLE_CASTLE_WHITE_KINGSIDE;
+    if (bs.can_castle_black[0])
+        record.flags |= PUZZLE_CASTLE_BLACK_QUEENSIDE;
+    if (bs.can_castle_black[1])
+        record.flags |= PUZZLE_CASTLE_BLACK_KINGSIDE;
+
+    // --- Only the side that just moved can have pushed a pawn two squares ---
+    record.en_passant = NO_FILE;
+    for (int n = 0; n < 8; n++)
+    {
+        if ((to_move == BLACK && bs.pawn_two_squares_white[n]) || (to_move == WHITE && bs.pawn_two_squares_black[n]))
+        {
+            record.en_passant = (uint8_t)n;
+        }
+    }
+
+    record.rating = (uint16_t)clamp_rating(atoi(puzzle.rating.c_str()));
+
+    size_t move_count = std::min<size_t>(puzzle.bestMoves.size(), 255);
+    record.first_move = (uint32_t)moves.size();
+    record.move_count = (uint8_t)move_count;
+    for (size_t m = 0; m < move_count; m++)
+    {
+        moves.push_back(pack_puzzle_move(puzzle.bestMoves[m]));
+    }
+
+    std::string id = puzzle.id.substr(0, 65535);
+    std::string label = puzzle.themes.substr(0, 255);
+    record.text_start = add_text(id);
+    record.id_length = (uint16_t)id.size();
+    add_text(label);
+    record.label_length = (uint8_t)label.size();
+
+    std::istringstream names(theme_list);
+    std::string name;
+    while (names >> name)
+    {
+        entry.theme_ids.push_back(theme_id(name));
+    }
+
+    entries.push_back(entry);
+}
+
+bool PuzzleDatabaseWriter::write(const std::string &path)
+{
+    // --- Sort by rating (stable, so equal ratings keep the CSV order) ---
+    std::vector<uint32_t> order(entries.size());
+    for (size_t n = 0; n < order.size(); n++)
+    {
+        order[n] = (uint32_t)n;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+                     { return entries[a].record.rating < entries[b].record.rating; });
+
+    std::vector<PuzzleRecord> records(entries.size());
+    for (size_t n = 0; n < order.size(); n++)
+    {
+        records[n] = entries[order[n]].record;
+    }
+
+    // --- rating_start[r] = first record rated r or higher ---
+    std::vector<uint32_t> rating_start(RATING_SLOTS + 1);
+    size_t next = 0;
+    for (int r = 0; r <= RATING_SLOTS; r++)
+    {
+        while (next < records.size() && records[next].rating < r)
+        {
+            next++;
+        }
+        rating_start[r] = (uint32_t)next;
+    }
+
+    // --- Theme names go into the text pool; their record lists follow in record order ---
+    std::vector<std::vector<uint32_t>> members(theme_names.size());
+    for (size_t n = 0; n < order.size(); n++)
+    {
+        const std::vector<uint32_t> &ids = entries[order[n]].theme_ids;
+        for (size_t t = 0; t < ids.size(); t++)
+        {
+            members[ids[t]].push_back((uint32_t)n);
+        }
+    }
+
+    std::vector<PuzzleDbTheme> themes(theme_names.size());
+    std::vector<uint32_t> theme_records;
+    for (size_t t = 0; t < theme_names.size(); t++)
+    {
+        themes[t].name_start = add_text(theme_names[t]);
+        themes[t].name_length = (uint32_t)theme_names[t].size();
+        themes[t].first_record = (uint32_t)theme_records.size();
+        themes[t].record_count = (uint32_t)members[t].size();
+        theme_records.insert(theme_records.end(), members[t].begin(), members[t].end());
+    }
+
+    PuzzleDbHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = PUZZLE_DB_MAGIC;
+    header.version = PUZZLE_DB_VERSION;
+    header.puzzle_count = (uint32_t)records.size();
+    header.theme_count = (uint32_t)themes.size();
+    header.theme_record_count = (uint32_t)theme_records.size();
+    header.move_count = (uint32_t)moves.size();
+    header.text_size = (uint32_t)text.size();
+    header.records_offset = sizeof(PuzzleDbHeader);
+    header.rating_index_offset = header.records_offset + records.size() * sizeof(PuzzleRecord);
+    header.themes_offset = header.rating_index_offset + rating_start.size() * sizeof(uint32_t);
+    header.theme_records_offset = header.themes_offset + themes.size() * sizeof(PuzzleDbTheme);
+    header.moves_offset = header.theme_records_offset + theme_records.size() * sizeof(uint32_t);
+    header.text_offset = header.moves_offset + moves.size() * sizeof(uint16_t);
+
+    FILE *out = fopen(path.c_str(), "wb");
+    if (!out)
+    {
+        return false;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    ok = ok && (records.empty() || fwrite(records.data(), sizeof(PuzzleRecord), records.size(), out) == records.size());
+    ok = ok && fwrite(rating_start.data(), sizeof(uint32_t), rating_start.size(), out) == rating_start.size();
+    ok = ok && (themes.empty() || fwrite(themes.data(), sizeof(PuzzleDbTheme), themes.size(), out) == themes.size());
+    ok = ok && (theme_records.empty() || fwrite(theme_records.data(), sizeof(uint32_t), theme_records.size(), out) == theme_records.size());
+    ok = ok && (moves.empty() || fwrite(moves.data(), sizeof(uint16_t), moves.size(), out) == moves.size());
+    ok = ok && (text.empty() || fwrite(text.data(), 1, text.size(), out) == text.size());
+    ok = fclose(out) == 0 && ok;
+    return ok;
+}
@@ -0,0 +1,153 @@
+// --------------------------------------------------------------------------------------
+// puzzledb.h
+// --- Declares the indexed binary puzzle database.
+// --- tools/puzzle_convert.cpp turns a puzzle CSV into one file holding pre-parsed
+// --- positions, packed solution moves, a rating index and a theme index. The game maps
+// --- that file and builds a Puzzle straight from one fixed-size record, so picking a
+// --- random puzzle, or one in a rating range, costs O(1) whatever the file size.
+// --- File layout (little-endian), in this order:
+// ---   PuzzleDbHeader
+// ---   PuzzleRecord[puzzle_count]           sorted by rating
+// ---   uint32_t rating_start[RATING_SLOTS+1] first record with rating >= r
+// ---   PuzzleDbTheme[theme_count]
+// ---   uint32_t theme_records[...]           record indices per theme, ascending
+// ---   uint16_t moves[move_count]            packed solution moves
+// ---   char text[text_size]                  ids, labels and theme names
+// --------------------------------------------------------------------------------------
+
+#ifndef PUZZLEDB_H
+#define PUZZLEDB_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "puzzle.h"
+#include "mappedfile.h"
+
+const uint32_t PUZZLE_DB_MAGIC = 0x425a5043; // --- "CPZB" ---
+const uint32_t PUZZLE_DB_VERSION = 1;
+const int RATING_SLOTS = 4096;               // --- Ratings are clamped to 0..4095 ---
+
+struct PuzzleDbHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t puzzle_count;
+    uint32_t theme_count;
+    uint32_t theme_record_count;
+    uint32_t move_count;
+    uint32_t text_size;
+    uint32_t reserved;
+    uint64_t records_offset;       // --- Byte offsets of the sections from the start of the file ---
+    uint64_t rating_index_offset;
+    uint64_t themes_offset;
+    uint64_t theme_records_offset;
+    uint64_t moves_offset;
+    uint64_t text_offset;
+};
+
+// --- One puzzle. squares holds board[i][j] at i * 8 + j, two squares per byte with the
+// --- even square in the low nibble: 0 empty, 1-6 white pawn to king, 7-12 black ---
+struct PuzzleRecord
+{
+    uint8_t squares[32];
+    uint8_t flags;          // --- PUZZLE_BLACK_TO_MOVE and the PUZZLE_CASTLE_* bits ---
+    uint8_t en_passant;     // --- File of a pawn the side not to move just pushed two squares, or NO_FILE ---
+    uint8_t move_count;     // --- Number of packed moves in the solution ---
+    uint8_t label_length;   // --- Difficulty label ("Easy", "Medium", "Hard"), after the id in text ---
+    uint16_t rating;
+    uint16_t id_length;
+    uint32_t first_move;    // --- Index of the first solution move in moves ---
+    uint32_t text_start;    // --- Offset of the id in text ---
+};
+
+// --- A theme and the slice of theme_records listing its puzzles ---
+struct PuzzleDbTheme
+{
+    uint32_t name_start;
+    uint32_t name_length;
+    uint32_t first_record;
+    uint32_t record_count;
+};
+
+const uint8_t PUZZLE_BLACK_TO_MOVE = 1;
+const uint8_t PUZZLE_CASTLE_WHITE_QUEENSIDE = 2;
+const uint8_t PUZZLE_CASTLE_WHITE_KINGSIDE = 4;
+const uint8_t PUZZLE_CASTLE_BLACK_QUEENSIDE = 8;
+const uint8_t PUZZLE_CASTLE_BLACK_KINGSIDE = 16;
+const uint8_t NO_FILE = 0xFF;
+
+// --- Solution moves are stored as from (bits 0-5) | to (bits 6-11) | promotion (bits 12-14),
+// --- squares numbered a1 = 0 .. h8 = 63 and promotion 0 none, 1-4 knight, bishop, rook, queen ---
+uint16_t pack_puzzle_move(const std::string &uci);
+std::string unpack_puzzle_move(uint16_t packed);
+
+// --- Read-only view of a mapped database file ---
+class PuzzleDatabase
+{
+private:
+    MappedFile file;
+    const PuzzleDbHeader *header;
+    const PuzzleRecord *records;
+    const uint32_t *rating_start;
+    const PuzzleDbTheme *themes;
+    const uint32_t *theme_records;
+    const uint16_t *moves;
+    const char *text;
+
+public:
+    PuzzleDatabase();
+
+    // --- Maps a file written by PuzzleDatabaseWriter; false if it is missing or malformed ---
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const { return header != NULL; }
+
+    uint32_t size() const { return header ? header->puzzle_count : 0; }
+
+    // --- Fills puzzle from record index (0 = lowest rated); false if out of range ---
+    bool load(uint32_t index, Puzzle &puzzle) const;
+
+    // --- Index range [first, last) of the puzzles rated min_rating..max_rating ---
+    void rating_range(int min_rating, int max_rating, uint32_t &first, uint32_t &last) const;
+
+    // --- Theme lookup; -1 if no puzzle has the theme ---
+    int find_theme(const std::string &name) const;
+    uint32_t theme_size(int theme) const;
+    uint32_t theme_puzzle(int theme, uint32_t n) const; // --- Record index of the theme's n-th puzzle ---
+
+    // --- Side to move in the puzzle's starting position ---
+    side to_move(uint32_t index) const;
+};
+
+// --- Collects puzzles and writes them out in the database format ---
+class PuzzleDatabaseWriter
+{
+private:
+    struct Entry
+    {
+        PuzzleRecord record;
+        std::vector<uint32_t> theme_ids;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<uint16_t> moves;
+    std::string text;
+    std::vector<std::string> theme_names;
+    std::map<std::string, uint32_t> theme_lookup; // --- Name to index in theme_names ---
+
+    uint32_t add_text(const std::string &s);
+    uint32_t theme_id(const std::string &name);
+
+public:
+    // --- Adds one puzzle; themes is the space-separated theme list of its CSV row ---
+    void add(const Puzzle &puzzle, side to_move, const std::string &themes);
+
+    size_t size() const { return entries.size(); }
+
+    // --- Sorts by rating, builds the indexes and writes the file; false on I/O error ---
+    bool write(const std::string &path);
+};
+
+#endif
@@ -0,0 +1,379 @@
+// --------------------------------------------------------------------------------------
+// tablebase.cpp
+// --- Implements the endgame table layout and the probing code declared in tablebase.h.
+// --------------------------------------------------------------------------------------
+
+#include "tablebase.h"
+#include "movegen.h"
+#include <algorithm>
+#include <vector>
+
+// --- Piece letters by piece_type, and the order pieces of one side are listed in ---
+static const char PIECE_LETTERS[] = "PNBRQK";
+static const piece_type LISTED_ORDER[5] = {QUEEN, ROOK, BISHOP, KNIGHT, PAWN};
+
+// --- The ten squares a1-d1-d4 the white king is brought to in endgames without pawns ---
+static const int TRIANGLE_SQUARES[10] = {0, 1, 2, 3, 9, 10, 11, 18, 19, 27};
+
+uint32_t material_code(const Position &pos, side s)
+{
+    uint32_t code = 0;
+    for (int pt = PAWN; pt < KING; pt++)
+    {
+        code |= (uint32_t)popcount(pos.pieces[s][pt]) << (3 * pt);
+    }
+    return code;
+}
+
+// --- Slot of the white king's square in the index, -1 outside the stored region ---
+static int king_slot(int sq, bool pawns)
+{
+    if (pawns)
+    {
+        return col_of(sq) <= 3 ? rank_of(sq) * 4 + col_of(sq) : -1;
+    }
+    for (int k = 0; k < 10; k++)
+    {
+        if (TRIANGLE_SQUARES[k] == sq)
+        {
+            return k;
+        }
+    }
+    return -1;
+}
+
+static int king_slots(bool pawns)
+{
+    return pawns ? 32 : 10;
+}
+
+// --- Symmetry t of the board: bit 4 swaps files and ranks, bit 1 mirrors the files,
+// --- bit 2 the ranks. Only t = 0 and 1 keep pawns moving the right way ---
+static int transform_square(int sq, int t)
+{
+    if (t & 4)
+        sq = (sq & 7) << 3 | sq >> 3;
+    if (t & 1)
+        sq ^= 7;
+    if (t & 2)
+        sq ^= 56;
+    return sq;
+}
+
+bool TablebaseLayout::parse(const std::string &name)
+{
+    size_t split = name.find('v');
+    if (split == std::string::npos)
+    {
+        return false;
+    }
+
+    count = 0;
+    pawns = false;
+    uint32_t codes[2] = {0, 0};
+    for (int s = 0; s < 2; s++)
+    {
+        std::string letters = s == 0 ? name.substr(0, split) : name.substr(split + 1);
+        if (letters.empty() || letters[0] != 'K' || count + (int)letters.size() > TB_MAX_PIECES)
+        {
+            return false;
+        }
+
+        // --- Count the pieces by type, then list them king first and queen to pawn ---
+        int counts[6] = {0, 0, 0, 0, 0, 0};
+        for (size_t k = 1; k < letters.size(); k++)
+        {
+            const char *letter = std::char_traits<char>::find(PIECE_LETTERS, 5, letters[k]);
+            if (!letter)
+            {
+                return false;
+            }
+            counts[letter - PIECE_LETTERS]++;
+        }
+
+        side owner = s == 0 ? WHITE : BLACK;
+        pieces[count++] = make_piece(owner, KING);
+        for (int n = 0; n < 5; n++)
+        {
+            piece_type pt = LISTED_ORDER[n];
+            for (int c = 0; c < counts[pt]; c++)
+            {
+                pieces[count++] = make_piece(owner, pt);
+            }
+            codes[s] |= (uint32_t)counts[pt] << (3 * pt);
+        }
+
+        // --- Without opposing pawns no en passant capture is ever possible ---
+        if (counts[PAWN] > 0)
+        {
+            if (pawns)
+            {
+                return false;
+            }
+            pawns = true;
+        }
+    }
+    return codes[WHITE] >= codes[BLACK];
+}
+
+std::string TablebaseLayout::name() const
+{
+    std::string text;
+    for (int k = 0; k < count; k++)
+    {
+        if (k > 0 && type_of(pieces[k]) == KING)
+        {
+            text += 'v';
+        }
+        text += PIECE_LETTERS[type_of(pieces[k])];
+    }
+    return text;
+}
+
+uint32_t TablebaseLayout::material() const
+{
+    uint32_t codes[2] = {0, 0};
+    for (int k = 0; k < count; k++)
+    {
+        if (type_of(pieces[k]) != KING)
+        {
+            codes[side_of(pieces[k])] += 1u << (3 * type_of(pieces[k]));
+        }
+    }
+    return codes[WHITE] << 16 | codes[BLACK];
+}
+
+uint64_t TablebaseLayout::size() const
+{
+    uint64_t entries = 2 * king_slots(pawns);
+    for (int k = 1; k < count; k++)
+    {
+        entries *= 64;
+    }
+    return entries;
+}
+
+// --- The smallest index over the symmetries that bring the white king into its region ---
+uint64_t TablebaseLayout::index(side to_move, const int squares[]) const
+{
+    uint64_t best = UINT64_MAX;
+    int symmetries = pawns ? 2 : 8;
+    for (int t = 0; t < symmetries; t++)
+    {
+        int slot = king_slot(transform_square(squares[0], t), pawns);
+        if (slot < 0)
+        {
+            continue;
+        }
+
+        int moved[TB_MAX_PIECES];
+        for (int k = 1; k < count; k++)
+        {
+            moved[k] = transform_square(squares[k], t);
+            for (int j = k; j > 1 && pieces[j] == pieces[j - 1] && moved[j] < moved[j - 1]; j--)
+            {
+                std::swap(moved[j], moved[j - 1]);
+            }
+        }
+
+        uint64_t position_index = (uint64_t)(to_move == BLACK ? 1 : 0) * king_slots(pawns) + slot;
+        for (int k = 1; k < count; k++)
+        {
+            position_index = position_index * 64 + moved[k];
+        }
+        best = std::min(best, position_index);
+    }
+    return best;
+}
+
+uint64_t TablebaseLayout::index(const Position &pos, bool flipped) const
+{
+    int squares[TB_MAX_PIECES];
+    int n = 0;
+    for (int s = 0; s < 2; s++)
+    {
+        side owner = (s == 0) != flipped ? WHITE : BLACK;
+        squares[n++] = pos.king_square(owner) ^ (flipped ? 56 : 0);
+        for (int k = 0; k < 5; k++)
+        {
+            Bitboard bb = pos.pieces[owner][LISTED_ORDER[k]];
+            while (bb)
+            {
+                squares[n++] = pop_lsb(bb) ^ (flipped ? 56 : 0);
+            }
+        }
+    }
+    return index(flipped ? opposite(pos.to_move) : pos.to_move, squares);
+}
+
+void TablebaseLayout::decode(uint64_t position_index, side &to_move, int squares[]) const
+{
+    for (int k = count - 1; k > 0; k--)
+    {
+        squares[k] = (int)(position_index % 64);
+        position_index /= 64;
+    }
+    int slot = (int)(position_index % king_slots(pawns));
+    to_move = position_index / king_slots(pawns) == 0 ? WHITE : BLACK;
+    squares[0] = pawns ? (slot / 4) * 8 + slot % 4 : TRIANGLE_SQUARES[slot];
+}
+
+// --- Every multiset of up to `left` non-king pieces, strongest first, as letters ---
+static void list_extra_pieces(std::vector<std::string> &out, const std::string &prefix, int first, int left)
+{
+    out.push_back(prefix);
+    for (int n = first; left > 0 && n < 5; n++)
+    {
+        list_extra_pieces(out, prefix + PIECE_LETTERS[LISTED_ORDER[n]], n, left - 1);
+    }
+}
+
+std::vector<TablebaseLayout> list_tablebases()
+{
+    std::vector<std::string> extras;
+    list_extra_pieces(extras, "", 0, TB_MAX_PIECES - 2);
+
+    std::vector<TablebaseLayout> layouts;
+    for (size_t w = 0; w < extras.size(); w++)
+    {
+        for (size_t b = 0; b < extras.size(); b++)
+        {
+            TablebaseLayout layout;
+            if (extras[w].size() + extras[b].size() > 0 && layout.parse("K" + extras[w] + "vK" + extras[b]))
+            {
+                layouts.push_back(layout);
+            }
+        }
+    }
+    return layouts;
+}
+
+void Tablebases::set_path(const std::string &directory)
+{
+    tables.clear();
+    enabled = !directory.empty();
+    if (!enabled)
+    {
+        return;
+    }
+
+    // --- One entry per endgame; the files themselves are opened on first probe ---
+    std::vector<TablebaseLayout> layouts = list_tablebases();
+    for (size_t k = 0; k < layouts.size(); k++)
+    {
+        std::unique_ptr<Table> table(new Table);
+        table->layout = layouts[k];
+        table->path = directory + "/" + layouts[k].name() + ".tb";
+        tables[layouts[k].material()] = std::move(table);
+    }
+}
+
+Tablebases::Table *Tablebases::find(const Position &pos, bool &flipped) const
+{
+    uint32_t white = material_code(pos, WHITE), black = material_code(pos, BLACK);
+    flipped = black > white;
+    std::map<uint32_t, std::unique_ptr<Table> >::const_iterator it = tables.find(flipped ? black << 16 | white : white << 16 | black);
+    if (it == tables.end())
+    {
+        return NULL;
+    }
+
+    Table *table = it->second.get();
+    std::call_once(table->opened, [table]()
+                   {
+        if (!table->file.open(table->path) || table->file.size() < sizeof(TablebaseHeader))
+        {
+            table->file.close();
+            return;
+        }
+        const TablebaseHeader *header = (const TablebaseHeader *)table->file.data();
+        if (header->magic != TB_MAGIC || header->version != TB_VERSION ||
+            header->material != table->layout.material() || header->entries != table->layout.size() ||
+            table->file.size() != sizeof(TablebaseHeader) + header->entries)
+        {
+            table->file.close();
+            return;
+        }
+        table->available = true; });
+    return table->available ? table : NULL;
+}
+
+bool Tablebases::probe_dtz(const Position &pos, int &wdl, int &dtz) const
+{
+    int pieces = popcount(pos.occupied);
+    if (!enabled || pieces > TB_MAX_PIECES || pos.castling != 0)
+    {
+        return false;
+    }
+    if (pieces == 2)
+    {
+        wdl = TB_DRAW;
+        dtz = 0;
+        return true;
+    }
+
+    bool flipped;
+    const Table *table = find(pos, flipped);
+    if (!table)
+    {
+        return false;
+    }
+
+    uint8_t value = table->file.data()[sizeof(TablebaseHeader) + table->layout.index(pos, flipped)];
+    wdl = tb_value_wdl(value);
+    dtz = tb_value_dtz(value);
+    return true;
+}
+
+bool Tablebases::probe_wdl(const Position &pos, int &wdl) const
+{
+    int dtz;
+    return probe_dtz(pos, wdl, dtz);
+}
+
+bool Tablebases::probe_root(Position &pos, Move &best, int &wdl, int &dtz) const
+{
+    if (!probe_dtz(pos, wdl, dtz))
+    {
+        return false;
+    }
+
+    side us = pos.to_move;
+    MoveList moves;
+    generate_moves(pos, us, moves);
+
+    // --- Every move gets a rank, higher is better: mates, then wins by lowest DTZ, then
+    // --- draws, then losses by highest DTZ. A capture or pawn move starts the count anew ---
+    best = NO_MOVE;
+    int best_rank = 0;
+    for (int k = 0; k < moves.count; k++)
+    {
+        Move m = moves.moves[k];
+        bool zeroing = is_capture(m) || type_of(pos.piece_on(move_from(m))) == PAWN;
+
+        Undo undo;
+        pos.make_move(m, undo);
+        int child_wdl = TB_DRAW, child_dtz = 0;
+        bool legal = !pos.in_check(us);
+        bool known = legal && probe_dtz(pos, child_wdl, child_dtz);
+        pos.unmake_move(m, undo);
+        if (!known)
+        {
+            continue;
+        }
+
+        int distance = zeroing ? 1 : child_dtz + 1;
+        int rank = 0;
+        if (child_wdl == TB_LOSS)
+            rank = child_dtz == 0 ? 1000 : 500 - distance;
+        else if (child_wdl == TB_WIN)
+            rank = -500 + distance;
+
+        if (best == NO_MOVE || rank > best_rank)
+        {
+            best = m;
+            best_rank = rank;
+        }
+    }
+    return best != NO_MOVE;
+}
@@ -0,0 +1,130 @@
+// --------------------------------------------------------------------------------------
+// tablebase.h
+// --- Declares the endgame tablebases: for every position of an endgame with at most
+// --- TB_MAX_PIECES pieces (kings included) and pawns on at most one side, the exact
+// --- result (WDL: win, draw or loss for the side to move) and the distance to zeroing
+// --- (DTZ: plies until the winner captures or moves a pawn on the way to mate, or until
+// --- the loser is forced to). DTZ is what lets the engine make progress in a won
+// --- endgame: a move that lowers it is always a winning move.
+// --- Each endgame ("KQvK", "KRvKP", ...) has its own file of one byte per position,
+// --- made by tools/tb_generate. Files are memory-mapped on first use, so only the
+// --- endgames actually reached are ever opened, and only their touched pages loaded.
+// --- The fifty-move rule is not taken into account.
+// --------------------------------------------------------------------------------------
+
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "position.h"
+#include "mappedfile.h"
+
+// --- Largest endgame the tables cover, kings included ---
+const int TB_MAX_PIECES = 4;
+
+const uint32_t TB_MAGIC = 0x42544543; // --- "CETB" ---
+const uint32_t TB_VERSION = 1;
+
+// --- Results, from the side to move's point of view ---
+const int TB_LOSS = -1;
+const int TB_DRAW = 0;
+const int TB_WIN = 1;
+
+// --- Longest DTZ a table can store ---
+const int TB_MAX_DTZ = 127;
+
+// --- File header; a byte per position follows, see encode_tb_value() ---
+struct TablebaseHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t material;  // --- material_code() of White << 16 | of Black ---
+    uint32_t reserved;
+    uint64_t entries;   // --- Number of positions, TablebaseLayout::size() ---
+};
+
+// --- Position byte: 0 draw, 1..127 win with that DTZ, 128 + d loss with DTZ d (0 when mated) ---
+inline uint8_t encode_tb_value(int wdl, int dtz) { return wdl == TB_WIN ? (uint8_t)dtz : wdl == TB_LOSS ? (uint8_t)(128 + dtz) : 0; }
+inline int tb_value_wdl(uint8_t value) { return value == 0 ? TB_DRAW : value < 128 ? TB_WIN : TB_LOSS; }
+inline int tb_value_dtz(uint8_t value) { return value < 128 ? value : value - 128; }
+
+// --- Material of one side without its king: 3 bits per piece type, the queen count highest,
+// --- so comparing codes puts the stronger side first ---
+uint32_t material_code(const Position &pos, side s);
+
+// --- Piece order and index of the positions of one endgame ---
+// --- Pieces are listed White first, each side king first and then from queen to pawn.
+// --- Positions are stored once per symmetry class: the board is mirrored (and without
+// --- pawns also flipped and turned) until the white king stands on a1-d1-d4 (a-d files
+// --- with pawns), and identical pieces are taken in square order ---
+struct TablebaseLayout
+{
+    char pieces[TB_MAX_PIECES]; // --- board.h piece codes in index order ---
+    int count;
+    bool pawns;
+
+    // --- Reads a name such as "KRvKP"; false if it is malformed, larger than TB_MAX_PIECES,
+    // --- has pawns on both sides or lists the weaker side first ---
+    bool parse(const std::string &name);
+    std::string name() const;
+    uint32_t material() const;
+
+    // --- Number of indices, including unused ones (overlapping pieces, other symmetries) ---
+    uint64_t size() const;
+
+    // --- Index of the position with squares[k] holding pieces[k] ---
+    uint64_t index(side to_move, const int squares[]) const;
+
+    // --- Index of a position of this endgame; flipped if Black holds the pieces listed for
+    // --- White, which then play on a board turned upside down ---
+    uint64_t index(const Position &pos, bool flipped = false) const;
+
+    // --- Inverse of index(), for the generator; the result may be an illegal position ---
+    void decode(uint64_t position_index, side &to_move, int squares[]) const;
+};
+
+// --- Every endgame of two to TB_MAX_PIECES pieces the tables can cover, except the bare kings ---
+std::vector<TablebaseLayout> list_tablebases();
+
+class Tablebases
+{
+private:
+    // --- One endgame; the file is mapped the first time it is probed ---
+    struct Table
+    {
+        TablebaseLayout layout;
+        std::string path;
+        MappedFile file;
+        std::once_flag opened;
+        bool available = false;
+    };
+
+    std::map<uint32_t, std::unique_ptr<Table> > tables; // --- By TablebaseLayout::material() ---
+    bool enabled = false;
+
+    // --- Table of the position's endgame, and whether White and Black trade places in it ---
+    Table *find(const Position &pos, bool &flipped) const;
+
+public:
+    // --- Directory holding the table files; an empty path switches probing off ---
+    // --- Must not be called while a search runs ---
+    void set_path(const std::string &directory);
+    bool is_enabled() const { return enabled; }
+
+    // --- Result and DTZ of a position for the side to move; false if no table covers it
+    // --- (too many pieces, castling rights left, or its file is missing) ---
+    bool probe_wdl(const Position &pos, int &wdl) const;
+    bool probe_dtz(const Position &pos, int &wdl, int &dtz) const;
+
+    // --- Best legal move of a covered position: the fastest mate or lowest DTZ when
+    // --- winning, the highest DTZ (stubbornest defence) when losing, and for a draw any
+    // --- move that keeps it. False if the position is not covered or has no legal move ---
+    bool probe_root(Position &pos, Move &best, int &wdl, int &dtz) const;
+};
+
+#endif
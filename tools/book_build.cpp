@@ -0,0 +1,143 @@
+// --------------------------------------------------------------------------------------
+// book_build.cpp
+// --- Builds an opening book (book.h) from a file of games, one game per line, each
+// --- written as UCI moves from the start position ("e2e4 e7e5 g1f3 ..."); PGN files
+// --- can be turned into this form with pgn-extract -Wuci. A line ends at its first
+// --- token that is not a legal move, so results and comments after the moves are fine.
+// --- Every position of the first plies of each game counts the move played from it;
+// --- the count becomes the entry's weight, so the engine plays popular moves more often.
+// --- Usage: book_build <games.txt> <book.bin> [-plies n] [-min n]
+// ---   -plies: moves per game that go into the book (default 16)
+// ---   -min:   times a move must have been played to be kept (default 1)
+// --------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "attacks.h"
+#include "zobrist.h"
+#include "board.h"
+#include "movegen.h"
+#include "book.h"
+
+using namespace std;
+
+const int DEFAULT_BOOK_PLIES = 16;
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <games.txt> <book.bin> [-plies n] [-min n]\n", argv[0]);
+        return 2;
+    }
+
+    int plies = DEFAULT_BOOK_PLIES, min_count = 1;
+    for (int a = 3; a < argc; a++)
+    {
+        string option = argv[a];
+        if (a + 1 < argc && option == "-plies")
+            plies = atoi(argv[++a]);
+        else if (a + 1 < argc && option == "-min")
+            min_count = max(1, atoi(argv[++a]));
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[a]);
+            return 2;
+        }
+    }
+
+    ifstream in(argv[1]);
+    if (!in.is_open())
+    {
+        fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    Attacks::initialize();
+    Zobrist::initialize();
+
+    // --- Start position, as the GUI sets it up ---
+    Board start;
+    Position initial = Position::from_board_state(start.get_position(), WHITE);
+    if (book_key(initial) != POLYGLOT_START_KEY)
+    {
+        fprintf(stderr, "Start position key %016llx is not the Polyglot one\n", (unsigned long long)book_key(initial));
+        return 1;
+    }
+
+    // --- (key, book move) -> times played ---
+    map<pair<uint64_t, uint16_t>, long> counts;
+    long games = 0;
+    string line;
+    while (getline(in, line))
+    {
+        Position pos = initial;
+        istringstream tokens(line);
+        string text;
+        int ply = 0;
+        while (ply < plies && tokens >> text)
+        {
+            Move m = parse_uci_move(pos, text);
+            if (m == NO_MOVE)
+            {
+                break;
+            }
+            counts[make_pair(book_key(pos), to_book_move(m))]++;
+
+            Undo undo;
+            pos.make_move(m, undo);
+            ply++;
+        }
+        if (ply > 0)
+        {
+            games++;
+        }
+    }
+
+    // --- Map order is key order; within a key the most played move goes first ---
+    vector<BookEntry> entries;
+    for (map<pair<uint64_t, uint16_t>, long>::iterator it = counts.begin(); it != counts.end(); ++it)
+    {
+        if (it->second < min_count)
+        {
+            continue;
+        }
+        BookEntry entry;
+        entry.key = it->first.first;
+        entry.move = it->first.second;
+        entry.weight = (uint16_t)min(it->second, 65535L);
+        entry.learn = 0;
+        entries.push_back(entry);
+    }
+    stable_sort(entries.begin(), entries.end(), [](const BookEntry &a, const BookEntry &b)
+                { return a.key < b.key || (a.key == b.key && a.weight > b.weight); });
+
+    FILE *out = fopen(argv[2], "wb");
+    if (!out)
+    {
+        fprintf(stderr, "Failed to write %s\n", argv[2]);
+        return 1;
+    }
+    bool ok = true;
+    for (size_t k = 0; k < entries.size() && ok; k++)
+    {
+        unsigned char bytes[BOOK_ENTRY_SIZE];
+        write_book_entry(entries[k], bytes);
+        ok = fwrite(bytes, BOOK_ENTRY_SIZE, 1, out) == 1;
+    }
+    ok = fclose(out) == 0 && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to write %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("%ld games, %zu book entries written to %s\n", games, entries.size(), argv[2]);
+    return 0;
+}
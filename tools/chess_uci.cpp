@@ -0,0 +1,515 @@
+// --------------------------------------------------------------------------------------
+// chess_uci.cpp
+// --- Headless UCI front end for the engine, for GUIs and match runners such as
+// --- cutechess-cli. Reads commands from stdin and answers on stdout.
+// --- Supported: uci, debug, isready, ucinewgame, setoption (Hash, Threads, BookFile, TablebasePath,
+// --- EvalFile), position
+// --- (startpos or fen, then moves), go (depth, nodes, movetime, wtime/btime/winc/binc,
+// --- movestogo, infinite), stop and quit. With debug on, the search statistics are
+// --- printed as info strings before every bestmove.
+// --- Two extra commands test the move generator on the current position: perft <depth>
+// --- prints the leaf count and speed, divide <depth> the count below every root move.
+// --- bench [depth] [hash MB] (also as "chess_uci bench ..." on the command line) searches
+// --- a fixed set of positions to a fixed depth on one thread with a fresh table each, and
+// --- prints total nodes, time and nodes per second. The node total depends only on the
+// --- search, so it serves as a signature: it must not change unless the search does.
+// --- The search runs in the background (Engine::search_async), so stop and isready are
+// --- answered while it thinks. A waiter thread prints bestmove once the search is done;
+// --- after "go infinite" it holds bestmove back until stop, as the protocol requires.
+// --------------------------------------------------------------------------------------
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <chrono>
+#include "engine.h"
+#include "perft.h"
+#include "puzzle.h"
+
+using namespace std;
+
+const char *const START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// --- Share of the remaining clock spent on one move when no movestogo is given ---
+const int DEFAULT_MOVES_TO_GO = 30;
+
+// --- Kept back from the clock for transfer and process overhead ---
+const int MOVE_OVERHEAD_MS = 50;
+
+// --- Defaults of the bench command ---
+const int BENCH_DEPTH = 6;
+const int BENCH_HASH_MB = 16;
+
+// --- Bench positions: openings, middlegames and endgames, two of them without legal moves ---
+static const char *const BENCH_FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+    "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+    "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+    "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+    "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+    "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+    "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/8 b - - 3 54",
+    "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+    "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+    "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+    "7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+    "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+    "8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+    "8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+    "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+    "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+    "6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1",
+    "1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1",
+    "6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+    "8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+    "5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+    "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+    "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+    "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+    "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+    "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+    "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+    "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+    "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+    "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+    "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+    "r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1",
+};
+
+const int BENCH_POSITIONS = sizeof(BENCH_FENS) / sizeof(BENCH_FENS[0]);
+
+static Engine engine;
+static Position current;         // --- Position set by the last "position" command ---
+static mutex output_mutex;       // --- Lines from the search thread and the loop must not interleave ---
+
+// --- Background search bookkeeping ---
+static thread waiter;
+static mutex wait_mutex;
+static condition_variable wait_done;
+static bool infinite = false;    // --- "go infinite": bestmove waits for stop ---
+static bool debug = false;       // --- "debug on": print search statistics ---
+
+// --- Writes one complete line to the GUI ---
+static void send(const string &line)
+{
+    lock_guard<mutex> lock(output_mutex);
+    cout << line << endl;
+}
+
+// --- "score cp" or "score mate" from the side to move's point of view ---
+static string format_score(float eval, side s)
+{
+    int score = (int)lround(eval * 100);
+    if (s == BLACK)
+    {
+        score = -score;
+    }
+
+    ostringstream out;
+    if (score > MATE_BOUND || score < -MATE_BOUND)
+    {
+        int plies = MATE_VALUE - abs(score);
+        int moves = (plies + 1) / 2;
+        out << "score mate " << (score > 0 ? moves : -moves);
+    }
+    else
+    {
+        out << "score cp " << score;
+    }
+    return out.str();
+}
+
+// --- Prints one "info" line per completed iteration ---
+static void report(const SearchInfo &info, side s)
+{
+    long nps = info.time_ms > 0 ? (long)(info.nodes * 1000.0 / info.time_ms) : info.nodes * 1000;
+
+    ostringstream out;
+    out << "info depth " << info.depth << " " << format_score(info.eval, s) << " nodes " << info.nodes
+        << " nps " << nps << " time " << info.time_ms << " pv";
+    for (size_t k = 0; k < info.pv.size(); k++)
+    {
+        out << " " << move_to_uci(info.pv[k]);
+    }
+    send(out.str());
+}
+
+// --- Prints the statistics of a finished search as info strings ---
+static void report_stats(const SearchStats &stats)
+{
+    char line[200];
+    snprintf(line, sizeof(line), "info string nodes %ld qnodes %ld ebf %.2f fail-high-first %.1f%% tt probes %ld hits %.1f%% cutoffs %ld tb hits %ld",
+             stats.nodes, stats.qnodes, stats.branching_factor, stats.fail_high_first_rate() * 100, stats.tt_probes,
+             stats.tt_hit_rate() * 100, stats.tt_cutoffs, stats.tb_hits);
+    send(line);
+
+    snprintf(line, sizeof(line), "info string time %d ms: movegen %.0f ms, eval %.0f ms, search %.0f ms (summed over %d threads)",
+             stats.time_ms, stats.movegen.estimated_ms(), stats.eval.estimated_ms(), stats.search_ms(engine.get_threads()),
+             engine.get_threads());
+    send(line);
+
+    // --- The root itself is not counted, so the list starts at ply 1 ---
+    int last = STATS_PLIES - 1;
+    while (last > 1 && stats.nodes_by_ply[last] == 0)
+    {
+        last--;
+    }
+    string plies = "info string nodes by ply";
+    for (int p = 1; p <= last; p++)
+    {
+        plies += " " + to_string(stats.nodes_by_ply[p]);
+    }
+    send(plies);
+}
+
+// --- Waits for the running search (if any) to print its bestmove ---
+static void wait_for_search()
+{
+    if (waiter.joinable())
+    {
+        waiter.join();
+    }
+}
+
+// --- Ends the running search; its best move so far is printed ---
+static void stop_search()
+{
+    {
+        lock_guard<mutex> lock(wait_mutex);
+        infinite = false;
+    }
+    wait_done.notify_all();
+    engine.force_move();
+    wait_for_search();
+}
+
+// --- position startpos|fen <fen> [moves <move> ...] ---
+static void set_position(istringstream &args)
+{
+    string token, fen;
+    args >> token;
+
+    if (token == "startpos")
+    {
+        fen = START_FEN;
+        args >> token;
+    }
+    else if (token == "fen")
+    {
+        while (args >> token && token != "moves")
+        {
+            fen += token + " ";
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    current = position_from_fen(fen);
+
+    if (token != "moves")
+    {
+        return;
+    }
+    while (args >> token)
+    {
+        Move m = parse_uci_move(current, token);
+        if (m == NO_MOVE)
+        {
+            send("info string illegal move " + token);
+            return;
+        }
+        Undo undo;
+        current.make_move(m, undo);
+    }
+}
+
+// --- Budget for one move from the clock: an even share of the remaining time plus most
+// --- of the increment, never more than the clock allows ---
+static int time_for_move(int remaining, int increment, int moves_to_go)
+{
+    int budget = remaining / max(1, moves_to_go) + increment * 3 / 4;
+    return max(1, min(budget, remaining - MOVE_OVERHEAD_MS));
+}
+
+// --- go [depth n] [nodes n] [movetime ms] [wtime ms] [btime ms] [winc ms] [binc ms] [movestogo n] [infinite] ---
+static void start_search(istringstream &args)
+{
+    SearchLimits limits;
+    int depth = 0, movetime = 0, moves_to_go = DEFAULT_MOVES_TO_GO;
+    int time_left[2] = {-1, -1}, increment[2] = {0, 0};
+    long nodes = 0;
+    bool go_infinite = false;
+    string token;
+
+    while (args >> token)
+    {
+        if (token == "depth")
+            args >> depth;
+        else if (token == "nodes")
+            args >> nodes;
+        else if (token == "movetime")
+            args >> movetime;
+        else if (token == "wtime")
+            args >> time_left[WHITE];
+        else if (token == "btime")
+            args >> time_left[BLACK];
+        else if (token == "winc")
+            args >> increment[WHITE];
+        else if (token == "binc")
+            args >> increment[BLACK];
+        else if (token == "movestogo")
+            args >> moves_to_go;
+        else if (token == "infinite")
+            go_infinite = true;
+    }
+
+    side s = current.to_move;
+    limits.depth = depth > 0 ? depth : MAX_SEARCH_DEPTH;
+    limits.nodes = nodes;
+    if (movetime > 0)
+        limits.time_ms = movetime;
+    else if (time_left[s] >= 0)
+        limits.time_ms = time_for_move(time_left[s], increment[s], moves_to_go);
+    else
+        limits.time_ms = 0; // --- Only depth, nodes, infinite or nothing: search until told to stop ---
+
+    stop_search();
+    engine.set_limits(limits);
+    engine.set_search_callback([s](const SearchInfo &info)
+                               { report(info, s); });
+    infinite = go_infinite;
+
+    board_state state = {};
+    current.to_board_state(state);
+    engine.search_async(state, s);
+
+    waiter = thread([]()
+                    {
+                        board_state after;
+                        EngineMove move = engine.finish_move(after);
+                        SearchInfo info = engine.get_search_info();
+
+                        unique_lock<mutex> lock(wait_mutex);
+                        wait_done.wait(lock, []() { return !infinite; });
+
+                        if (debug)
+                        {
+                            report_stats(move.stats);
+                        }
+                        if (move.move == NO_MOVE)
+                        {
+                            send("bestmove 0000");
+                        }
+                        else if (info.pv.size() > 1 && info.pv[0] == move.move)
+                        {
+                            send("bestmove " + move_to_uci(move.move) + " ponder " + move_to_uci(info.pv[1]));
+                        }
+                        else
+                        {
+                            send("bestmove " + move_to_uci(move.move));
+                        }
+                    });
+}
+
+// --- perft <depth> and divide <depth> on the current position ---
+static void run_perft(istringstream &args, bool split)
+{
+    int depth = 1;
+    args >> depth;
+
+    Position pos = current;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    uint64_t nodes = 0;
+    if (split)
+    {
+        vector<PerftEntry> entries = divide(pos, depth);
+        for (size_t k = 0; k < entries.size(); k++)
+        {
+            send(move_to_uci(entries[k].move) + ": " + to_string(entries[k].nodes));
+            nodes += entries[k].nodes;
+        }
+    }
+    else
+    {
+        nodes = perft(pos, depth);
+    }
+    int ms = (int)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+
+    send("nodes " + to_string(nodes) + " time " + to_string(ms) + " nps " + to_string(nodes * 1000 / max(1, ms)));
+}
+
+// --- bench [depth] [hash MB]: fixed-depth searches of the bench positions ---
+// --- The engine's own settings are restored afterwards ---
+static void run_bench(istringstream &args)
+{
+    int depth = BENCH_DEPTH, hash_mb = BENCH_HASH_MB;
+    args >> depth >> hash_mb;
+
+    SearchLimits saved_limits = engine.get_limits();
+    int saved_hash = engine.get_hash(), saved_threads = engine.get_threads();
+
+    SearchLimits limits;
+    limits.depth = depth;
+    limits.time_ms = 0;
+    engine.set_limits(limits);
+    engine.set_hash(hash_mb);
+    engine.set_threads(1);
+    engine.set_search_callback(SearchCallback());
+
+    long total_nodes = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int p = 0; p < BENCH_POSITIONS; p++)
+    {
+        Position pos = position_from_fen(BENCH_FENS[p]);
+        board_state state = {};
+        pos.to_board_state(state);
+
+        engine.clear_hash();
+        EngineMove move = pos.to_move == WHITE ? engine.make_white_move(state) : engine.make_black_move(state);
+        total_nodes += move.nodes;
+
+        send("Position " + to_string(p + 1) + "/" + to_string(BENCH_POSITIONS) + ": " + to_string(move.nodes) +
+             " nodes, bestmove " + (move.move != NO_MOVE ? move_to_uci(move.move) : string("(none)")));
+    }
+    long ms = (long)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+
+    send("===========================");
+    send("Total time (ms) : " + to_string(ms));
+    send("Nodes searched  : " + to_string(total_nodes));
+    send("Nodes/second    : " + to_string(total_nodes * 1000 / max(1L, ms)));
+
+    engine.set_limits(saved_limits);
+    engine.set_hash(saved_hash);
+    engine.set_threads(saved_threads);
+}
+
+// --- setoption name <Hash|Threads|BookFile|TablebasePath|EvalFile> value <n|path> ---
+static void set_option(istringstream &args)
+{
+    string token, name, value;
+    args >> token;
+    while (args >> token && token != "value")
+    {
+        name += (name.empty() ? "" : " ") + token;
+    }
+    getline(args >> ws, value); // --- The rest of the line, so book paths may hold spaces ---
+    if (!value.empty() && value[value.size() - 1] == '\r')
+        value.erase(value.size() - 1);
+
+    stop_search();
+    if (name == "Hash")
+        engine.set_hash(max(1, atoi(value.c_str())));
+    else if (name == "Threads")
+        engine.set_threads(atoi(value.c_str()));
+    else if (name == "BookFile")
+    {
+        // --- An empty value turns the book off ---
+        if (!engine.set_book(value == "<empty>" ? "" : value))
+            send("info string cannot open book " + value);
+    }
+    else if (name == "TablebasePath")
+        engine.set_tablebase_path(value == "<empty>" ? "" : value);
+    else if (name == "EvalFile")
+    {
+        // --- An empty value goes back to the classical evaluation ---
+        if (!engine.set_network(value == "<empty>" ? "" : value))
+            send("info string cannot load network " + value);
+    }
+    else
+        send("info string unknown option " + name);
+}
+
+int main(int argc, char **argv)
+{
+    string line;
+    current = position_from_fen(START_FEN);
+
+    // --- "chess_uci bench [depth] [hash MB]" runs the bench and exits ---
+    if (argc > 1 && string(argv[1]) == "bench")
+    {
+        string bench_args;
+        for (int a = 2; a < argc; a++)
+        {
+            bench_args += string(argv[a]) + " ";
+        }
+        istringstream args(bench_args);
+        run_bench(args);
+        return 0;
+    }
+
+    while (getline(cin, line))
+    {
+        istringstream args(line);
+        string command;
+        args >> command;
+
+        if (command == "uci")
+        {
+            send("id name Chess-Engine-in-C++");
+            send("option name Hash type spin default " + to_string(DEFAULT_HASH_MB) + " min 1 max 4096");
+            send("option name Threads type spin default 1 min 1 max " + to_string(MAX_THREADS));
+            send("option name BookFile type string default <empty>");
+            send("option name TablebasePath type string default <empty>");
+            send("option name EvalFile type string default <empty>");
+            send("uciok");
+        }
+        else if (command == "debug")
+        {
+            string mode;
+            args >> mode;
+            debug = mode == "on";
+        }
+        else if (command == "isready")
+            send("readyok");
+        else if (command == "ucinewgame")
+        {
+            stop_search();
+            engine.clear_hash();
+        }
+        else if (command == "setoption")
+            set_option(args);
+        else if (command == "position")
+        {
+            stop_search();
+            set_position(args);
+        }
+        else if (command == "go")
+            start_search(args);
+        else if (command == "stop")
+            stop_search();
+        else if (command == "perft" || command == "divide")
+        {
+            stop_search();
+            run_perft(args, command == "divide");
+        }
+        else if (command == "bench")
+        {
+            stop_search();
+            run_bench(args);
+        }
+        else if (command == "quit")
+            break;
+    }
+
+    stop_search();
+    return 0;
+}
@@ -0,0 +1,477 @@
+// --------------------------------------------------------------------------------------
+// eval_bench.cpp
+// --- Micro-benchmark for the leaf evaluation (Evaluation::evaluate on a Position).
+// --- Builds a fixed set of positions by seeded random play from the start position and
+// --- reports evaluations per second for the scalar kernels and, where the CPU has
+// --- it, the AVX2 kernels. Both kernels must return identical scores. A last run uses a
+// --- pawn hash table as the search does; it repeats positions, so it shows the cost of
+// --- a hit rather than a realistic hit rate.
+// --- The mobility and pawn structure terms are also timed alone, against the 8x8 board
+// --- pass that computed them before the popcount kernels (kept here as the reference),
+// --- and must match it except where an en passant capture is possible: the board pass
+// --- counted a pawn beside any enemy pawn on the flagged file.
+// --- Given a network file (nnue.h), the network is timed as well, once on accumulators
+// --- already built (as the search has them) and once rebuilding them for every position,
+// --- again with both kernels agreeing.
+// --- Usage: eval_bench [iterations] [network.nnue]
+// --------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include "attacks.h"
+#include "zobrist.h"
+#include "evaluation.h"
+#include "movegen.h"
+#include "nnue.h"
+
+using namespace std;
+
+// --- Number of positions evaluated per iteration ---
+const int BENCH_POSITIONS = 256;
+
+// --- Plays seeded random legal moves to collect varied positions from all game phases ---
+static vector<Position> collect_positions()
+{
+    vector<Position> positions;
+    unsigned seed = 12345;
+    Board board;
+
+    while ((int)positions.size() < BENCH_POSITIONS)
+    {
+        Position pos = Position::from_board_state(board.get_position(), WHITE);
+        for (int ply = 0; ply < 100 && (int)positions.size() < BENCH_POSITIONS; ply++)
+        {
+            MoveList moves, legal;
+            Undo undo;
+            generate_moves(pos, pos.to_move, moves);
+            for (int k = 0; k < moves.count; k++)
+            {
+                side us = pos.to_move;
+                pos.make_move(moves.moves[k], undo);
+                if (!pos.in_check(us))
+                {
+                    legal.add(moves.moves[k]);
+                }
+                pos.unmake_move(moves.moves[k], undo);
+            }
+            if (legal.count == 0)
+            {
+                break;
+            }
+
+            seed = seed * 1103515245 + 12345;
+            pos.make_move(legal.moves[(seed >> 8) % legal.count], undo);
+            if (ply % 4 == 3)
+            {
+                positions.push_back(pos);
+            }
+        }
+    }
+    return positions;
+}
+
+// --- Mobility and pawn structure as the evaluation computed them on the 8x8 board before
+// --- the popcount kernels; mobility counts pseudo-legal moves (queens excluded) ---
+static int board_pass_terms(const board_state &position)
+{
+    // --- Initialize evaluation parameters ---
+    int score = 0;
+    int legal_moves_white = 0;
+    int legal_moves_black = 0;
+
+    int white_pawns_in_file[8] = {0};
+    int black_pawns_in_file[8] = {0};
+
+    // --- Traverse the board and evaluate all pieces ---
+    for (int m = 0; m < 8; m++)
+    {
+        for (int n = 0; n < 8; n++)
+        {
+            // --- WHITE PAWN Evaluation ---
+            if (position.board[m][n] == WHITE_PAWN)
+            {
+                white_pawns_in_file[n]++;
+
+                // --- White Pawn mobility ---
+                if (position.board[m - 1][n] == 0)
+                    legal_moves_white++;
+                if (m == 6 && position.board[m - 1][n] == 0 && position.board[m - 2][n] == 0)
+                    legal_moves_white++;
+                if (n != 0 && position.board[m - 1][n - 1] < 0)
+                    legal_moves_white++;
+                if (n != 7 && position.board[m - 1][n + 1] < 0)
+                    legal_moves_white++;
+                if (n != 7 && position.board[m][n + 1] == -1 && position.pawn_two_squares_black[n + 1])
+                    legal_moves_white++;
+                if (n != 0 && position.board[m][n - 1] == -1 && position.pawn_two_squares_black[n - 1])
+                    legal_moves_white++;
+            }
+
+            // --- WHITE KNIGHT Evaluation ---
+            else if (position.board[m][n] == WHITE_KNIGHT)
+            {
+                for (int k = 0; k < 8; k++)
+                {
+                    int k_i = m + knight_move[k][0];
+                    int k_j = n + knight_move[k][1];
+                    if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8 && position.board[k_i][k_j] <= 0)
+                        legal_moves_white++;
+                }
+            }
+
+            // --- WHITE BISHOP Evaluation ---
+            else if (position.board[m][n] == WHITE_BISHOP)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    int path_i = m + bishop_direction[k][0];
+                    int path_j = n + bishop_direction[k][1];
+                    while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
+                    {
+                        if (position.board[path_i][path_j] <= 0)
+                            legal_moves_white++;
+                        if (position.board[path_i][path_j] != 0)
+                            break;
+                        path_i += bishop_direction[k][0];
+                        path_j += bishop_direction[k][1];
+                    }
+                }
+            }
+
+            // --- WHITE ROOK Evaluation ---
+            else if (position.board[m][n] == WHITE_ROOK)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    int path_i = m + rook_direction[k][0];
+                    int path_j = n + rook_direction[k][1];
+                    while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
+                    {
+                        if (position.board[path_i][path_j] <= 0)
+                            legal_moves_white++;
+                        if (position.board[path_i][path_j] != 0)
+                            break;
+                        path_i += rook_direction[k][0];
+                        path_j += rook_direction[k][1];
+                    }
+                }
+            }
+
+            // --- WHITE KING Evaluation ---
+            else if (position.board[m][n] == WHITE_KING)
+            {
+                for (int k = 0; k < 8; k++)
+                {
+                    int k_i = m + every_direction[k][0];
+                    int k_j = n + every_direction[k][1];
+                    if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8 &&
+                        position.board[k_i][k_j] <= 0 &&
+                        !Board::under_control(position.board, k_i, k_j, BLACK))
+                    {
+                        legal_moves_white++;
+                    }
+                }
+            }
+
+            // --- BLACK PIECES (same logic, mirrored signs) ---
+            // --- BLACK PAWN Evaluation ---
+            else if (position.board[m][n] == BLACK_PAWN)
+            {
+                black_pawns_in_file[n]++;
+
+                if (position.board[m + 1][n] == 0)
+                    legal_moves_black++;
+                if (m == 1 && position.board[m + 1][n] == 0 && position.board[m + 2][n] == 0)
+                    legal_moves_black++;
+                if (n != 0 && position.board[m + 1][n - 1] > 0)
+                    legal_moves_black++;
+                if (n != 7 && position.board[m + 1][n + 1] > 0)
+                    legal_moves_black++;
+                if (n != 7 && position.board[m][n + 1] == 1 && position.pawn_two_squares_white[n + 1])
+                    legal_moves_black++;
+                if (n != 0 && position.board[m][n - 1] == 1 && position.pawn_two_squares_white[n - 1])
+                    legal_moves_black++;
+            }
+
+            // --- BLACK KNIGHT ---
+            else if (position.board[m][n] == BLACK_KNIGHT)
+            {
+                for (int k = 0; k < 8; k++)
+                {
+                    int k_i = m + knight_move[k][0];
+                    int k_j = n + knight_move[k][1];
+                    if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8 && position.board[k_i][k_j] >= 0)
+                        legal_moves_black++;
+                }
+            }
+
+            // --- BLACK BISHOP ---
+            else if (position.board[m][n] == BLACK_BISHOP)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    int path_i = m + bishop_direction[k][0];
+                    int path_j = n + bishop_direction[k][1];
+                    while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
+                    {
+                        if (position.board[path_i][path_j] >= 0)
+                            legal_moves_black++;
+                        if (position.board[path_i][path_j] != 0)
+                            break;
+                        path_i += bishop_direction[k][0];
+                        path_j += bishop_direction[k][1];
+                    }
+                }
+            }
+
+            // --- BLACK ROOK ---
+            else if (position.board[m][n] == BLACK_ROOK)
+            {
+                for (int k = 0; k < 4; k++)
+                {
+                    int path_i = m + rook_direction[k][0];
+                    int path_j = n + rook_direction[k][1];
+                    while (path_i >= 0 && path_i < 8 && path_j >= 0 && path_j < 8)
+                    {
+                        if (position.board[path_i][path_j] >= 0)
+                            legal_moves_black++;
+                        if (position.board[path_i][path_j] != 0)
+                            break;
+                        path_i += rook_direction[k][0];
+                        path_j += rook_direction[k][1];
+                    }
+                }
+            }
+
+            // --- BLACK KING ---
+            else if (position.board[m][n] == BLACK_KING)
+            {
+                for (int k = 0; k < 8; k++)
+                {
+                    int k_i = m + every_direction[k][0];
+                    int k_j = n + every_direction[k][1];
+                    if (k_i >= 0 && k_i < 8 && k_j >= 0 && k_j < 8 &&
+                        position.board[k_i][k_j] >= 0 &&
+                        !Board::under_control(position.board, k_i, k_j, WHITE))
+                    {
+                        legal_moves_black++;
+                    }
+                }
+            }
+        }
+    }
+
+    // --- Add mobility bonus ---
+    score += 10 * (legal_moves_white - legal_moves_black);
+
+    // --- Evaluate pawn structure: doubled pawns, isolated pawns, and pawn islands ---
+    int white_pawn_islands = 0;
+    int black_pawn_islands = 0;
+    bool white_pawn_island_flag = false;
+    bool black_pawn_island_flag = false;
+
+    for (int i = 0; i < 8; i++)
+    {
+        if (white_pawns_in_file[i] > 1)
+            score -= white_pawns_in_file[i] * 15;
+        if (black_pawns_in_file[i] > 1)
+            score += black_pawns_in_file[i] * 15;
+
+        if (white_pawns_in_file[i] > 0 && !white_pawn_island_flag)
+        {
+            white_pawn_islands++;
+            white_pawn_island_flag = true;
+        }
+        if (white_pawns_in_file[i] == 0)
+            white_pawn_island_flag = false;
+
+        if (black_pawns_in_file[i] > 0 && !black_pawn_island_flag)
+        {
+            black_pawn_islands++;
+            black_pawn_island_flag = true;
+        }
+        if (black_pawns_in_file[i] == 0)
+            black_pawn_island_flag = false;
+
+        if (i != 0 && i != 7)
+        {
+            if (white_pawns_in_file[i] > 0 && white_pawns_in_file[i - 1] == 0 && white_pawns_in_file[i + 1] == 0)
+                score -= 30;
+            if (black_pawns_in_file[i] > 0 && black_pawns_in_file[i - 1] == 0 && black_pawns_in_file[i + 1] == 0)
+                score += 30;
+        }
+    }
+
+    // --- Apply pawn island penalties ---
+    score -= 10 * (white_pawn_islands - black_pawn_islands);
+
+    // --- Return final evaluation score ---
+    return score;
+}
+
+// --- Mobility and pawn structure terms per second, from the popcount kernels or from the
+// --- board pass (with the conversion to board_state it needed) ---
+static double run_terms(const vector<Position> &positions, int iterations, bool board_pass, long &checksum)
+{
+    checksum = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++)
+    {
+        for (size_t k = 0; k < positions.size(); k++)
+        {
+            if (board_pass)
+            {
+                board_state state = {};
+                positions[k].to_board_state(state);
+                checksum += board_pass_terms(state);
+            }
+            else
+            {
+                checksum += Evaluation::positional_terms(positions[k]);
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return (double)iterations * positions.size() / seconds;
+}
+
+// --- Evaluates every position the given number of times; returns evals per second ---
+static double run(const vector<Position> &positions, int iterations, long &checksum, PawnTable *pawn_table = NULL)
+{
+    checksum = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++)
+    {
+        for (size_t k = 0; k < positions.size(); k++)
+        {
+            checksum += Evaluation::evaluate(positions[k], pawn_table);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return (double)iterations * positions.size() / seconds;
+}
+
+// --- Network evaluations per second, from the given accumulators or rebuilding them ---
+static double run_network(const Network &network, const vector<Position> &positions, vector<Accumulator> &accumulators,
+                          int iterations, bool refresh, long &checksum)
+{
+    checksum = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++)
+    {
+        for (size_t k = 0; k < positions.size(); k++)
+        {
+            if (refresh)
+            {
+                network.refresh(positions[k], accumulators[k]);
+            }
+            checksum += network.evaluate(positions[k], accumulators[k]);
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return (double)iterations * positions.size() / seconds;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+
+    Attacks::initialize();
+    Zobrist::initialize();
+    Evaluation::initialize_piece_square_tables();
+    bool has_avx2 = Evaluation::use_avx2;
+
+    vector<Position> positions = collect_positions();
+    printf("%d positions x %d iterations\n", (int)positions.size(), iterations);
+
+    long scalar_sum, avx2_sum;
+    Evaluation::use_avx2 = false;
+    printf("scalar: %12.0f evals/s\n", run(positions, iterations, scalar_sum));
+
+    if (has_avx2)
+    {
+        Evaluation::use_avx2 = true;
+        printf("avx2:   %12.0f evals/s\n", run(positions, iterations, avx2_sum));
+        if (avx2_sum != scalar_sum)
+        {
+            printf("error: kernels disagree (%ld vs %ld)\n", scalar_sum, avx2_sum);
+            return 1;
+        }
+    }
+    else
+    {
+        printf("avx2:   not supported by this CPU\n");
+    }
+
+    // --- The terms the kernels replaced, against the board pass ---
+    int en_passant_differences = 0;
+    for (size_t k = 0; k < positions.size(); k++)
+    {
+        board_state state = {};
+        positions[k].to_board_state(state);
+        if (board_pass_terms(state) != Evaluation::positional_terms(positions[k]))
+        {
+            if (positions[k].en_passant == NO_SQUARE)
+            {
+                printf("error: terms differ from the board pass in position %d (%d vs %d)\n", (int)k,
+                       Evaluation::positional_terms(positions[k]), board_pass_terms(state));
+                return 1;
+            }
+            en_passant_differences++;
+        }
+    }
+
+    long terms_sum;
+    printf("terms, board pass: %12.0f evals/s\n", run_terms(positions, iterations, true, terms_sum));
+    Evaluation::use_avx2 = false;
+    printf("terms, scalar:     %12.0f evals/s\n", run_terms(positions, iterations, false, terms_sum));
+    if (has_avx2)
+    {
+        Evaluation::use_avx2 = true;
+        printf("terms, avx2:       %12.0f evals/s\n", run_terms(positions, iterations, false, terms_sum));
+    }
+    printf("terms match the board pass (%d positions differ by en passant)\n", en_passant_differences);
+
+    long cached_sum;
+    PawnTable pawn_table;
+    printf("cached: %12.0f evals/s (pawn table)\n", run(positions, iterations, cached_sum, &pawn_table));
+    if (cached_sum != scalar_sum)
+    {
+        printf("error: pawn table changes scores (%ld vs %ld)\n", scalar_sum, cached_sum);
+        return 1;
+    }
+
+    if (argc > 2)
+    {
+        Network network;
+        if (!network.open(argv[2]))
+        {
+            printf("error: cannot load network %s\n", argv[2]);
+            return 1;
+        }
+        bool network_avx2 = Network::use_avx2;
+        vector<Accumulator> accumulators(positions.size());
+
+        long network_sum, refresh_sum;
+        Network::use_avx2 = false;
+        run_network(network, positions, accumulators, 1, true, network_sum);
+        printf("network scalar: %12.0f evals/s\n", run_network(network, positions, accumulators, iterations, false, network_sum));
+        printf("  with refresh: %12.0f evals/s\n", run_network(network, positions, accumulators, iterations, true, refresh_sum));
+        if (network_avx2)
+        {
+            long avx2_network_sum;
+            Network::use_avx2 = true;
+            printf("network avx2:   %12.0f evals/s\n", run_network(network, positions, accumulators, iterations, false, avx2_network_sum));
+            printf("  with refresh: %12.0f evals/s\n", run_network(network, positions, accumulators, iterations, true, refresh_sum));
+            if (avx2_network_sum != network_sum || refresh_sum != network_sum)
+            {
+                printf("error: network kernels disagree (%ld vs %ld)\n", network_sum, avx2_network_sum);
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+// --------------------------------------------------------------------------------------
+// nnue_build.cpp
+// --- Writes a starting network file in the layout of nnue.h, for the engine to load and
+// --- for a trainer to start from. Its piece-square term holds the classical material and
+// --- piece-square values (psqt.h), blended for each bucket at the game phase typical of
+// --- that many pieces; the first layer and the layers after it are zero, so they add
+// --- nothing until trained. Loaded as it is, the network scores like the classical
+// --- evaluation without its mobility, pawn structure and king placement terms.
+// --- Usage: nnue_build <network.nnue>
+// --------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "evaluation.h"
+#include "nnue.h"
+
+using namespace std;
+
+// --- Phase assumed for a bucket: the middle of its piece counts, from 32 pieces (full
+// --- phase) down to the two kings ---
+static int bucket_phase(int bucket)
+{
+    double pieces = 4 * bucket + 2.5;
+    int phase = (int)((pieces - 2) * MAX_PHASE / 30 + 0.5);
+    return phase < 0 ? 0 : phase > MAX_PHASE ? MAX_PHASE : phase;
+}
+
+static bool write_zeros(FILE *out, size_t bytes)
+{
+    vector<char> zeros(1 << 16, 0);
+    while (bytes > 0)
+    {
+        size_t n = bytes < zeros.size() ? bytes : zeros.size();
+        if (fwrite(&zeros[0], 1, n, out) != n)
+        {
+            return false;
+        }
+        bytes -= n;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <network.nnue>\n", argv[0]);
+        return 2;
+    }
+
+    Evaluation::initialize_piece_square_tables();
+
+    // --- Feature (king, kind, square) of either point of view: its own pieces are White's
+    // --- (kinds 0-4) and the other side's Black's (kinds 5-9), as nnue_feature() orients them ---
+    vector<int32_t> psqt((size_t)NNUE_FEATURES * NNUE_BUCKETS);
+    for (int king_sq = 0; king_sq < 64; king_sq++)
+    {
+        for (int kind = 0; kind < 10; kind++)
+        {
+            side owner = kind < 5 ? WHITE : BLACK;
+            piece_type pt = (piece_type)(kind % 5);
+            for (int sq = 0; sq < 64; sq++)
+            {
+                Score value = PSQT::TABLE[owner][pt][sq];
+                int feature = ((king_sq * 10 + kind) << 6) + sq;
+                for (int b = 0; b < NNUE_BUCKETS; b++)
+                {
+                    int phase = bucket_phase(b);
+                    psqt[(size_t)feature * NNUE_BUCKETS + b] = (mg_value(value) * phase + eg_value(value) * (MAX_PHASE - phase)) / MAX_PHASE;
+                }
+            }
+        }
+    }
+
+    NetworkHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = NNUE_MAGIC;
+    header.version = NNUE_VERSION;
+    header.features = NNUE_FEATURES;
+    header.hidden = NNUE_HIDDEN;
+    header.layer1 = NNUE_LAYER1;
+    header.layer2 = NNUE_LAYER2;
+    header.buckets = NNUE_BUCKETS;
+
+    FILE *out = fopen(argv[1], "wb");
+    if (!out)
+    {
+        fprintf(stderr, "Failed to write %s\n", argv[1]);
+        return 1;
+    }
+
+    // --- Header, zero first layer, piece-square term, then the zero layers after it ---
+    size_t first_layer = sizeof(int16_t) * NNUE_HIDDEN + sizeof(int16_t) * NNUE_FEATURES * NNUE_HIDDEN;
+    size_t after = network_file_size() - sizeof(header) - first_layer - sizeof(int32_t) * psqt.size();
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 && write_zeros(out, first_layer) &&
+              fwrite(&psqt[0], sizeof(int32_t), psqt.size(), out) == psqt.size() && write_zeros(out, after);
+    ok = fclose(out) == 0 && ok;
+    if (!ok)
+    {
+        fprintf(stderr, "Failed to write %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("network written to %s (%zu bytes)\n", argv[1], network_file_size());
+    return 0;
+}
@@ -0,0 +1,100 @@
+// --------------------------------------------------------------------------------------
+// perft_bench.cpp
+// --- Move generator benchmark and correctness check.
+// --- Runs perft on the standard test positions (start position, Kiwipete and the other
+// --- positions from the Chess Programming Wiki), parsed with position_from_fen, checks
+// --- every count against the published value and prints nodes per second.
+// --- Exits with status 1 if any count is wrong, so it can gate changes to the board,
+// --- move generator or make/unmake code.
+// --- Usage: perft_bench [-nobulk] [extra depth]   (extra depth may be negative)
+// --------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include "attacks.h"
+#include "zobrist.h"
+#include "perft.h"
+#include "puzzle.h"
+
+using namespace std;
+
+// --- A test position with its published leaf counts for depths 1 to 6 (0 = unknown) ---
+struct PerftPosition
+{
+    const char *name;
+    const char *fen;
+    int depth;             // --- Depth run by default ---
+    uint64_t counts[6];
+};
+
+static const PerftPosition POSITIONS[] = {
+    {"startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5,
+     {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+     {48, 2039, 97862, 4085603, 193690690, 0}},
+    {"position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5,
+     {14, 191, 2812, 43238, 674624, 11030083}},
+    {"position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4,
+     {6, 264, 9467, 422333, 15833292, 706045033}},
+    {"position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+     {44, 1486, 62379, 2103487, 89941194, 0}},
+    {"position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4,
+     {46, 2079, 89890, 3894594, 164075551, 0}},
+};
+
+const int POSITION_COUNT = sizeof(POSITIONS) / sizeof(POSITIONS[0]);
+
+int main(int argc, char **argv)
+{
+    bool bulk = true;
+    int extra_depth = 0;
+    for (int a = 1; a < argc; a++)
+    {
+        if (strcmp(argv[a], "-nobulk") == 0)
+            bulk = false;
+        else
+            extra_depth = atoi(argv[a]);
+    }
+
+    Attacks::initialize();
+    Zobrist::initialize();
+
+    uint64_t total_nodes = 0;
+    double total_seconds = 0;
+    bool all_correct = true;
+
+    printf("%-10s %5s %12s %8s %12s\n", "position", "depth", "nodes", "seconds", "nps");
+    for (int p = 0; p < POSITION_COUNT; p++)
+    {
+        const PerftPosition &test = POSITIONS[p];
+        int depth = test.depth + extra_depth;
+        if (depth < 1 || depth > 6)
+        {
+            continue;
+        }
+
+        Position pos = position_from_fen(test.fen);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        uint64_t nodes = perft(pos, depth, bulk);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        uint64_t expected = test.counts[depth - 1];
+        bool correct = expected == 0 || nodes == expected;
+        all_correct = all_correct && correct;
+        total_nodes += nodes;
+        total_seconds += seconds;
+
+        printf("%-10s %5d %12llu %8.3f %12.0f", test.name, depth, (unsigned long long)nodes, seconds, nodes / seconds);
+        if (!correct)
+        {
+            printf("  WRONG, expected %llu", (unsigned long long)expected);
+        }
+        printf("\n");
+    }
+
+    printf("%-10s %5s %12llu %8.3f %12.0f (%s)\n", "total", "", (unsigned long long)total_nodes, total_seconds,
+           total_nodes / total_seconds, bulk ? "bulk counting" : "no bulk counting");
+    return all_correct ? 0 : 1;
+}
@@ -0,0 +1,738 @@
+// --------------------------------------------------------------------------------------
+// pgn_analyze.cpp
+// --- Game analysis: replays every game of a PGN file and searches each position of it
+// --- to a fixed budget, then writes the game back annotated - as PGN with an
+// --- [%eval] comment after every move, or as one JSON line per game.
+// --- A move the engine scores well below its own choice gets a ?!, ? or ?? mark and a
+// --- comment naming the better move. Games starting from a FEN tag are replayed from it;
+// --- a game with an illegal or unreadable move is analysed up to that move.
+// --- The main thread streams the file game by game into a bounded queue and worker
+// --- threads, each with its own single-threaded Engine, take games from it. A worker's
+// --- transposition table is kept over the positions of one game, which share most of
+// --- their trees, and cleared before the next. Each game is written out as soon as it is
+// --- done (so with several threads the order can differ from the input), and nothing is
+// --- kept once it is written, so memory use does not grow with the file.
+// --- Usage: pgn_analyze <games.pgn> [-threads n] [-nodes n] [-depth n] [-time ms]
+// ---                    [-hash mb] [-network file] [-tablebases dir] [-json] [-o file]
+// ---   -json writes JSON lines instead of PGN
+// ---   -o writes the games to a file instead of standard output
+// --------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "engine.h"
+#include "puzzle.h"
+
+using namespace std;
+
+const long DEFAULT_NODES = 100000; // --- Per-position budget when no limit is given ---
+const int ANALYZE_HASH_MB = 16;    // --- Table size of each worker's engine ---
+const size_t QUEUE_GAMES = 64;     // --- Games read ahead of the workers ---
+const long PROGRESS_INTERVAL = 100;
+const size_t PGN_LINE_WIDTH = 80;  // --- Movetext lines are wrapped before this column ---
+const char *const START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// --- Centipawn losses (for the side that moved, scores clipped to EVAL_CLIP) from which a
+// --- move other than the engine's own is marked ?!, ? and ?? ---
+const int INACCURACY_LOSS = 100;
+const int MISTAKE_LOSS = 200;
+const int BLUNDER_LOSS = 400;
+const int EVAL_CLIP = 1000;
+
+// --- One game of the file: its number (from 1) and its text, tags and movetext ---
+struct PgnGame
+{
+    long number = 0;
+    string text;
+};
+
+// --- Search result of one position of a game ---
+struct PositionAnalysis
+{
+    int score = 0;        // --- Centipawns from White's point of view (mate scores as in engine.h) ---
+    Move best = NO_MOVE;  // --- NO_MOVE if the side to move has no legal move ---
+    string best_san;
+    int depth = 0;
+    long nodes = 0;
+};
+
+// --- Totals of one worker; merged once all workers are done ---
+struct AnalysisTotals
+{
+    long games = 0;
+    long errors = 0; // --- Games cut short by an illegal or unreadable move ---
+    long plies = 0;
+    long nodes = 0;
+
+    void add(const AnalysisTotals &other)
+    {
+        games += other.games;
+        errors += other.errors;
+        plies += other.plies;
+        nodes += other.nodes;
+    }
+};
+
+// --- Games handed from the reader to the workers ---
+class GameQueue
+{
+private:
+    deque<PgnGame> games;
+    bool closed = false;
+    mutex lock;
+    condition_variable changed;
+
+public:
+    // --- Waits while the queue is full ---
+    void push(PgnGame &game)
+    {
+        unique_lock<mutex> guard(lock);
+        changed.wait(guard, [this]
+                     { return games.size() < QUEUE_GAMES; });
+        games.push_back(PgnGame());
+        games.back().number = game.number;
+        games.back().text.swap(game.text);
+        changed.notify_all();
+    }
+
+    // --- No more games will be pushed ---
+    void close()
+    {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+        changed.notify_all();
+    }
+
+    // --- Waits for a game; false once the queue is closed and empty ---
+    bool pop(PgnGame &game)
+    {
+        unique_lock<mutex> guard(lock);
+        changed.wait(guard, [this]
+                     { return !games.empty() || closed; });
+        if (games.empty())
+        {
+            return false;
+        }
+        game.number = games.front().number;
+        game.text.swap(games.front().text);
+        games.pop_front();
+        changed.notify_all();
+        return true;
+    }
+};
+
+// --- Tags of a game, in file order ---
+typedef vector<pair<string, string> > PgnTags;
+
+// --- Reads a tag line ([Name "Value"]); false if the line is not one ---
+static bool parse_tag(const string &line, PgnTags &tags)
+{
+    size_t name_end = line.find_first_of(" \t", 1);
+    size_t open = line.find('"');
+    if (line.empty() || line[0] != '[' || name_end == string::npos || open == string::npos)
+    {
+        return false;
+    }
+
+    string value;
+    size_t k = open + 1;
+    for (; k < line.size() && line[k] != '"'; k++)
+    {
+        if (line[k] == '\\' && k + 1 < line.size())
+        {
+            k++;
+        }
+        value += line[k];
+    }
+    tags.push_back(make_pair(line.substr(1, name_end - 1), value));
+    return true;
+}
+
+static bool is_result(const string &token)
+{
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+// --- Splits a game into its tags and the moves of its main line; comments, variations,
+// --- move numbers and numeric annotations are skipped ---
+static void parse_game(const string &text, PgnTags &tags, vector<string> &moves, string &result)
+{
+    istringstream lines(text);
+    string line;
+    string movetext;
+    while (getline(lines, line))
+    {
+        if (movetext.empty() && parse_tag(line, tags))
+        {
+            continue;
+        }
+        // --- Lines starting with % are escaped out of the movetext ---
+        if (line.empty() || line[0] != '%')
+        {
+            movetext += line;
+            movetext += '\n';
+        }
+    }
+
+    int variation_depth = 0;
+    string token;
+    for (size_t k = 0; k <= movetext.size(); k++)
+    {
+        char c = k < movetext.size() ? movetext[k] : ' ';
+        bool separator = isspace((unsigned char)c) || c == '{' || c == ';' || c == '(' || c == ')' || c == '$';
+        if (separator && !token.empty())
+        {
+            // --- Drop a leading move number ("12." or "12...") ---
+            size_t digits = 0;
+            while (digits < token.size() && isdigit((unsigned char)token[digits]))
+            {
+                digits++;
+            }
+            size_t dots = digits;
+            while (dots < token.size() && token[dots] == '.')
+            {
+                dots++;
+            }
+            if (dots > digits)
+            {
+                token.erase(0, dots);
+            }
+
+            if (is_result(token))
+            {
+                result = token;
+            }
+            else if (!token.empty() && variation_depth == 0)
+            {
+                moves.push_back(token);
+            }
+            token.clear();
+        }
+
+        if (c == '{')
+        {
+            size_t end = movetext.find('}', k);
+            k = end == string::npos ? movetext.size() : end;
+        }
+        else if (c == ';')
+        {
+            size_t end = movetext.find('\n', k);
+            k = end == string::npos ? movetext.size() : end;
+        }
+        else if (c == '$')
+        {
+            while (k + 1 < movetext.size() && isdigit((unsigned char)movetext[k + 1]))
+            {
+                k++;
+            }
+        }
+        else if (c == '(')
+        {
+            variation_depth++;
+        }
+        else if (c == ')')
+        {
+            variation_depth = max(0, variation_depth - 1);
+        }
+        else if (!separator)
+        {
+            token += c;
+        }
+    }
+}
+
+// --- Searches one position; score and best move are those of the engine's choice ---
+static PositionAnalysis analyze_position(Engine &engine, Position &pos)
+{
+    board_state state = {};
+    pos.to_board_state(state);
+    EngineMove chosen = pos.to_move == WHITE ? engine.make_white_move(state) : engine.make_black_move(state);
+
+    PositionAnalysis analysis;
+    analysis.score = (int)lround(chosen.eval * 100);
+    analysis.best = chosen.move;
+    analysis.best_san = chosen.move == NO_MOVE ? string() : move_to_san(pos, chosen.move);
+    analysis.depth = chosen.stats.depth;
+    analysis.nodes = chosen.nodes;
+    return analysis;
+}
+
+static bool is_mate_score(int score)
+{
+    return score > MATE_BOUND || score < -MATE_BOUND;
+}
+
+// --- Moves to mate, negative if Black mates ---
+static int mate_in(int score)
+{
+    int moves = (MATE_VALUE - abs(score) + 1) / 2;
+    return score > 0 ? moves : -moves;
+}
+
+// --- Score for comparing moves: centipawns of the given side, mates at the clip ---
+static int clipped_score(int score, side s)
+{
+    int clipped = is_mate_score(score) ? (score > 0 ? EVAL_CLIP : -EVAL_CLIP) : max(-EVAL_CLIP, min(EVAL_CLIP, score));
+    return s == WHITE ? clipped : -clipped;
+}
+
+// --- Mark of a move that lost this many centipawns against the engine's choice ---
+static const char *loss_mark(int loss)
+{
+    return loss >= BLUNDER_LOSS ? "??" : loss >= MISTAKE_LOSS ? "?" : loss >= INACCURACY_LOSS ? "?!" : "";
+}
+
+// --- Score as [%eval] writes it: pawns, or #moves for a mate ---
+static string pgn_eval(int score)
+{
+    char text[32];
+    if (is_mate_score(score))
+    {
+        snprintf(text, sizeof(text), "#%d", mate_in(score));
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "%.2f", score / 100.0);
+    }
+    return text;
+}
+
+static string json_string(const string &text)
+{
+    string out = "\"";
+    for (size_t k = 0; k < text.size(); k++)
+    {
+        unsigned char c = (unsigned char)text[k];
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += (char)c;
+        }
+        else if (c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        }
+        else
+        {
+            out += (char)c;
+        }
+    }
+    return out + "\"";
+}
+
+static string pgn_string(const string &text)
+{
+    string out = "\"";
+    for (size_t k = 0; k < text.size(); k++)
+    {
+        if (text[k] == '"' || text[k] == '\\')
+        {
+            out += '\\';
+        }
+        out += text[k];
+    }
+    return out + "\"";
+}
+
+// --- Writes movetext tokens to a PGN, wrapping the lines ---
+class MovetextWriter
+{
+private:
+    string &out;
+    size_t line_length = 0;
+
+public:
+    explicit MovetextWriter(string &text) : out(text) {}
+
+    void add(const string &token)
+    {
+        if (line_length > 0 && line_length + 1 + token.size() >= PGN_LINE_WIDTH)
+        {
+            out += '\n';
+            line_length = 0;
+        }
+        else if (line_length > 0)
+        {
+            out += ' ';
+            line_length++;
+        }
+        out += token;
+        line_length += token.size();
+    }
+
+    void finish()
+    {
+        out += "\n\n";
+    }
+};
+
+// --- Replays and analyses one game and formats it; totals gets its plies and nodes ---
+static string analyze_game(Engine &engine, const PgnGame &game, bool json, AnalysisTotals &totals)
+{
+    PgnTags tags;
+    vector<string> moves;
+    string result;
+    parse_game(game.text, tags, moves, result);
+
+    string fen = START_FEN;
+    for (size_t k = 0; k < tags.size(); k++)
+    {
+        if (tags[k].first == "FEN")
+        {
+            fen = tags[k].second;
+        }
+        else if (tags[k].first == "Result" && result.empty())
+        {
+            result = tags[k].second;
+        }
+    }
+    if (result.empty())
+    {
+        result = "*";
+    }
+
+    Position pos = position_from_fen(fen);
+    string placement, turn, castling, en_passant;
+    int halfmove = 0, move_number = 1;
+    istringstream(fen) >> placement >> turn >> castling >> en_passant >> halfmove >> move_number;
+    move_number = max(1, move_number);
+
+    // --- Each game is searched by a fresh engine, whichever worker and games came before ---
+    engine.new_game();
+    totals.games++;
+
+    string out;
+    if (json)
+    {
+        out = "{\"game\":" + to_string(game.number) + ",\"tags\":{";
+        for (size_t k = 0; k < tags.size(); k++)
+        {
+            out += (k > 0 ? "," : "") + json_string(tags[k].first) + ":" + json_string(tags[k].second);
+        }
+        out += "},\"result\":" + json_string(result) + ",\"plies\":[";
+    }
+    else
+    {
+        for (size_t k = 0; k < tags.size(); k++)
+        {
+            out += "[" + tags[k].first + " " + pgn_string(tags[k].second) + "]\n";
+        }
+        out += "\n";
+    }
+    MovetextWriter movetext(out);
+
+    // --- The analysis of the position before a move gives the engine's choice, and the
+    // --- one after it the score of the move played ---
+    PositionAnalysis before = analyze_position(engine, pos);
+    totals.nodes += before.nodes;
+    string error;
+    bool need_number = true;
+    for (size_t k = 0; k < moves.size(); k++)
+    {
+        Move move = parse_san_move(pos, moves[k]);
+        if (move == NO_MOVE)
+        {
+            error = "illegal move " + moves[k];
+            break;
+        }
+
+        side mover = pos.to_move;
+        string san = move_to_san(pos, move);
+        Undo undo;
+        pos.make_move(move, undo);
+        PositionAnalysis after = analyze_position(engine, pos);
+        totals.nodes += after.nodes;
+        totals.plies++;
+
+        bool game_over = after.best == NO_MOVE;
+        int loss = clipped_score(before.score, mover) - clipped_score(after.score, mover);
+        const char *mark = move == before.best || before.best == NO_MOVE ? "" : loss_mark(loss);
+
+        if (json)
+        {
+            out += (k > 0 ? ",{" : "{") + string("\"move\":") + json_string(san) + ",\"uci\":" + json_string(move_to_uci(move)) +
+                   ",\"best\":" + json_string(before.best_san);
+            if (game_over && pos.in_check(pos.to_move))
+            {
+                out += ",\"mate\":0";
+            }
+            else if (is_mate_score(after.score))
+            {
+                out += ",\"mate\":" + to_string(mate_in(after.score));
+            }
+            else
+            {
+                out += ",\"cp\":" + to_string(after.score);
+            }
+            out += ",\"depth\":" + to_string(after.depth) + ",\"nodes\":" + to_string(after.nodes);
+            if (*mark != '\0')
+            {
+                out += ",\"mark\":" + json_string(mark);
+            }
+            out += "}";
+        }
+        else
+        {
+            if (mover == WHITE || need_number)
+            {
+                movetext.add(to_string(move_number) + (mover == WHITE ? "." : "..."));
+            }
+            movetext.add(san + mark);
+
+            // --- A mated side has no score left to show ---
+            string comment = game_over && pos.in_check(pos.to_move) ? "" : "[%eval " + pgn_eval(after.score) + "]";
+            if (*mark != '\0')
+            {
+                comment += (comment.empty() ? "" : " ") + before.best_san + " was best";
+            }
+            need_number = !comment.empty();
+            if (!comment.empty())
+            {
+                istringstream words("{" + comment + "}");
+                string word;
+                while (words >> word)
+                {
+                    movetext.add(word);
+                }
+            }
+        }
+
+        if (mover == BLACK)
+        {
+            move_number++;
+        }
+        before = after;
+    }
+
+    if (!error.empty())
+    {
+        totals.errors++;
+    }
+    if (json)
+    {
+        out += "]";
+        if (!error.empty())
+        {
+            out += ",\"error\":" + json_string(error);
+        }
+        out += "}\n";
+    }
+    else
+    {
+        if (!error.empty())
+        {
+            istringstream words("{" + error + "}");
+            string word;
+            while (words >> word)
+            {
+                movetext.add(word);
+            }
+        }
+        movetext.add(result);
+        movetext.finish();
+    }
+    return out;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <games.pgn> [-threads n] [-nodes n] [-depth n] [-time ms] [-hash mb] [-network file] "
+                        "[-tablebases dir] [-json] [-o file]\n",
+                argv[0]);
+        return 2;
+    }
+
+    int threads = max(1, (int)thread::hardware_concurrency());
+    int hash_mb = ANALYZE_HASH_MB;
+    string network_path, tablebase_path, output_path;
+    bool json = false;
+    SearchLimits limits;
+    limits.time_ms = 0;
+    for (int a = 2; a < argc; a++)
+    {
+        string option = argv[a];
+        if (option == "-json")
+            json = true;
+        else if (a + 1 < argc && option == "-threads")
+            threads = max(1, atoi(argv[++a]));
+        else if (a + 1 < argc && option == "-nodes")
+            limits.nodes = atol(argv[++a]);
+        else if (a + 1 < argc && option == "-depth")
+            limits.depth = atoi(argv[++a]);
+        else if (a + 1 < argc && option == "-time")
+            limits.time_ms = atoi(argv[++a]);
+        else if (a + 1 < argc && option == "-hash")
+            hash_mb = max(1, atoi(argv[++a]));
+        else if (a + 1 < argc && option == "-network")
+            network_path = argv[++a];
+        else if (a + 1 < argc && option == "-tablebases")
+            tablebase_path = argv[++a];
+        else if (a + 1 < argc && option == "-o")
+            output_path = argv[++a];
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[a]);
+            return 2;
+        }
+    }
+    bool depth_limited = limits.depth > 0 && limits.depth < MAX_SEARCH_DEPTH;
+    if (limits.nodes <= 0 && limits.time_ms <= 0 && !depth_limited)
+    {
+        limits.nodes = DEFAULT_NODES;
+    }
+
+    ifstream in(argv[1]);
+    if (!in.is_open())
+    {
+        fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return 1;
+    }
+    FILE *output = stdout;
+    if (!output_path.empty())
+    {
+        output = fopen(output_path.c_str(), "w");
+        if (!output)
+        {
+            fprintf(stderr, "Failed to write %s\n", output_path.c_str());
+            return 1;
+        }
+    }
+
+    // --- Engines are built here, one at a time: their constructors fill shared tables ---
+    vector<unique_ptr<Engine> > engines;
+    for (int t = 0; t < threads; t++)
+    {
+        engines.push_back(unique_ptr<Engine>(new Engine(hash_mb, 1, network_path)));
+        if (!network_path.empty() && !engines.back()->has_network())
+        {
+            fprintf(stderr, "Failed to load network %s\n", network_path.c_str());
+            return 1;
+        }
+        engines.back()->set_tablebase_path(tablebase_path);
+        engines.back()->set_limits(limits);
+    }
+
+    GameQueue queue;
+    vector<AnalysisTotals> totals(threads);
+    atomic<long> done(0);
+    atomic<long> plies(0);
+    mutex output_lock;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.push_back(thread([&, t]()
+                                 {
+            Engine &engine = *engines[t];
+            AnalysisTotals &mine = totals[t];
+            PgnGame game;
+            while (queue.pop(game))
+            {
+                long plies_before = mine.plies;
+                string text = analyze_game(engine, game, json, mine);
+                long all_plies = plies += mine.plies - plies_before;
+                long count = ++done;
+
+                lock_guard<mutex> guard(output_lock);
+                fwrite(text.data(), 1, text.size(), output);
+                fflush(output);
+                if (count % PROGRESS_INTERVAL == 0)
+                {
+                    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                    fprintf(stderr, "%ld games, %ld plies, %.1f plies/s\n", count, all_plies, all_plies / seconds);
+                }
+            } }));
+    }
+
+    // --- Stream the file: a game ends where the tags of the next one start; a '[' inside a
+    // --- comment of the movetext does not count ---
+    PgnGame game;
+    bool in_movetext = false, in_comment = false;
+    string line;
+    while (getline(in, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+        {
+            line.erase(line.size() - 1);
+        }
+        if (!in_comment && !line.empty() && line[0] == '[')
+        {
+            if (in_movetext)
+            {
+                game.number++;
+                queue.push(game);
+                game.text.clear();
+                in_movetext = false;
+            }
+        }
+        else if (line.find_first_not_of(" \t") != string::npos && (in_comment || line[0] != '%'))
+        {
+            in_movetext = true;
+            for (size_t k = 0; k < line.size(); k++)
+            {
+                if (in_comment)
+                {
+                    in_comment = line[k] != '}';
+                }
+                else if (line[k] == '{')
+                {
+                    in_comment = true;
+                }
+                else if (line[k] == ';')
+                {
+                    break;
+                }
+            }
+        }
+        game.text += line;
+        game.text += '\n';
+    }
+    if (game.text.find_first_not_of(" \t\n") != string::npos)
+    {
+        game.number++;
+        queue.push(game);
+    }
+    queue.close();
+
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+
+    AnalysisTotals all;
+    for (int t = 0; t < threads; t++)
+    {
+        all.add(totals[t]);
+    }
+
+    // --- The games go to standard output by default, so the summary goes to the error stream ---
+    fprintf(stderr, "games            %ld (%ld cut short by an illegal move)\n", all.games, all.errors);
+    fprintf(stderr, "plies            %ld\n", all.plies);
+    fprintf(stderr, "throughput       %.1f plies/s, %.0f nodes/s, %.2f s on %d threads\n", all.plies / seconds,
+            all.nodes / seconds, seconds, threads);
+    fprintf(stderr, "limits           %ld nodes, depth %d, %d ms per position\n", limits.nodes, limits.depth, limits.time_ms);
+    return 0;
+}
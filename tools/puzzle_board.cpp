@@ -0,0 +1,9 @@
+// --------------------------------------------------------------------------------------
+// puzzle_board.cpp
+// --- The board object puzzle.cpp refers to, for the tools that link puzzle.cpp for its
+// --- CSV and FEN parsers without the GUI (which defines it in main.cpp).
+// --------------------------------------------------------------------------------------
+
+#include "board.h"
+
+Board board;
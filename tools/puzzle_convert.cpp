@@ -0,0 +1,113 @@
+// --------------------------------------------------------------------------------------
+// puzzle_convert.cpp
+// --- Converts a puzzle CSV into the indexed binary database of puzzledb.h.
+// --- Accepts the game's own CSV layout (id, FEN, moves, rating, popularity, themes,
+// --- difficulty) and the Lichess puzzle dump, recognised by the NbPlays column in its header.
+// --- Lichess rows have no difficulty column; their label is derived from the rating.
+// --- The CSV is read one row at a time, only the packed records are kept in memory.
+// --- Usage: puzzle_convert <input.csv> <output.bin>
+// --------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "puzzle.h"
+#include "puzzledb.h"
+
+using namespace std;
+
+// --- Rating limits for the labels given to Lichess puzzles ---
+const int EASY_RATING_LIMIT = 1400;
+const int MEDIUM_RATING_LIMIT = 2000;
+
+// --- Splits one CSV row at commas (puzzle fields never contain quoted commas) ---
+static vector<string> split_row(const string &line)
+{
+    vector<string> fields;
+    stringstream ss(line);
+    string field;
+    while (getline(ss, field, ','))
+    {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+// --- Reads a Lichess row: PuzzleId, FEN, Moves, Rating, RatingDeviation, Popularity, NbPlays, Themes, ... ---
+static bool parse_lichess_row(const string &line, Puzzle &puzzle, string &themes)
+{
+    vector<string> fields = split_row(line);
+    if (fields.size() < 8 || fields[1].empty() || fields[2].empty())
+    {
+        return false;
+    }
+
+    int rating = atoi(fields[3].c_str());
+    string label = rating < EASY_RATING_LIMIT ? "Easy" : rating < MEDIUM_RATING_LIMIT ? "Medium" : "Hard";
+
+    // --- Same fields as the game's layout, so parse_puzzle_csv_line does the rest ---
+    string row = fields[0] + "," + fields[1] + "," + fields[2] + "," + fields[3] + "," + fields[5] + "," + fields[7] + "," + label;
+    return parse_puzzle_csv_line(row, puzzle, &themes);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <input.csv> <output.bin>\n", argv[0]);
+        return 2;
+    }
+
+    ifstream in(argv[1]);
+    if (!in.is_open())
+    {
+        fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    string line;
+    getline(in, line);
+    bool lichess = line.find("NbPlays") != string::npos;
+
+    PuzzleDatabaseWriter writer;
+    long skipped = 0;
+    while (getline(in, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+        {
+            line.erase(line.size() - 1);
+        }
+        if (line.empty())
+        {
+            continue;
+        }
+
+        Puzzle puzzle;
+        string themes;
+        bool parsed = lichess ? parse_lichess_row(line, puzzle, themes) : parse_puzzle_csv_line(line, puzzle, &themes);
+        if (!parsed)
+        {
+            skipped++;
+            continue;
+        }
+
+        string placement, turn;
+        istringstream(puzzle.fen) >> placement >> turn;
+        writer.add(puzzle, turn == "b" ? BLACK : WHITE, themes);
+    }
+
+    if (!writer.write(argv[2]))
+    {
+        fprintf(stderr, "Failed to write %s\n", argv[2]);
+        return 1;
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    printf("%s: %zu puzzles written to %s, %ld rows skipped, %.2f s\n", argv[1], writer.size(), argv[2], skipped, seconds);
+    return 0;
+}
@@ -0,0 +1,377 @@
+// --------------------------------------------------------------------------------------
+// puzzle_validate.cpp
+// --- Batch puzzle check: runs the engine on every puzzle of a CSV in the game's layout
+// --- (id, FEN, moves, rating, popularity, themes, difficulty) and measures how many it
+// --- solves. As in the game, the first move of a puzzle is the opponent's; the engine
+// --- has to find every move of the solving side, within the per-move node or time limit.
+// --- A different last move that also mates counts as correct.
+// --- Rows whose moves are illegal in their position are reported as invalid.
+// --- The main thread streams the CSV into a bounded queue and worker threads, each with
+// --- its own single-threaded Engine, take rows from it, so memory use does not grow with
+// --- the file. Reports solve rate, time-to-solution percentiles and puzzles per second.
+// --- Usage: puzzle_validate <puzzles.csv> [-threads n] [-nodes n] [-time ms] [-hash mb]
+// ---                        [-network file] [-v]
+// ---   -network evaluates with a network file (nnue.h) instead of the classical eval
+// ---   -v prints every failed and invalid puzzle
+// --------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "engine.h"
+#include "puzzle.h"
+
+using namespace std;
+
+const long DEFAULT_NODES = 200000; // --- Per-move budget when neither -nodes nor -time is given ---
+const int VALIDATE_HASH_MB = 16;   // --- Table size of each worker's engine ---
+const size_t QUEUE_ROWS = 256;     // --- CSV rows read ahead of the workers ---
+const long PROGRESS_INTERVAL = 1000;
+const int SOLVE_HISTOGRAM_MS = 10000; // --- Solve times are counted in 1 ms buckets up to this, the rest together ---
+
+enum PuzzleOutcome
+{
+    PUZZLE_SOLVED,
+    PUZZLE_FAILED,
+    PUZZLE_INVALID
+};
+
+// --- Totals of one worker; merged once all workers are done ---
+struct ValidationTotals
+{
+    long puzzles = 0;
+    long solved = 0;
+    long invalid = 0;
+    long nodes = 0;
+    vector<long> solve_ms = vector<long>(SOLVE_HISTOGRAM_MS + 1); // --- Solved puzzles by time-to-solution ---
+    int max_solve_ms = 0;
+
+    void add_solve(int ms)
+    {
+        solve_ms[min(ms, SOLVE_HISTOGRAM_MS)]++;
+        max_solve_ms = max(max_solve_ms, ms);
+    }
+
+    void add(const ValidationTotals &other)
+    {
+        puzzles += other.puzzles;
+        solved += other.solved;
+        invalid += other.invalid;
+        nodes += other.nodes;
+        for (int ms = 0; ms <= SOLVE_HISTOGRAM_MS; ms++)
+        {
+            solve_ms[ms] += other.solve_ms[ms];
+        }
+        max_solve_ms = max(max_solve_ms, other.max_solve_ms);
+    }
+};
+
+// --- Rows handed from the reader to the workers ---
+class RowQueue
+{
+private:
+    deque<string> rows;
+    bool closed = false;
+    mutex lock;
+    condition_variable changed;
+
+public:
+    // --- Waits while the queue is full ---
+    void push(const string &row)
+    {
+        unique_lock<mutex> guard(lock);
+        changed.wait(guard, [this]
+                     { return rows.size() < QUEUE_ROWS; });
+        rows.push_back(row);
+        changed.notify_all();
+    }
+
+    // --- No more rows will be pushed ---
+    void close()
+    {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+        changed.notify_all();
+    }
+
+    // --- Waits for a row; false once the queue is closed and empty ---
+    bool pop(string &row)
+    {
+        unique_lock<mutex> guard(lock);
+        changed.wait(guard, [this]
+                     { return !rows.empty() || closed; });
+        if (rows.empty())
+        {
+            return false;
+        }
+        row = rows.front();
+        rows.pop_front();
+        changed.notify_all();
+        return true;
+    }
+};
+
+// --- True if the side to move is checkmated ---
+static bool is_checkmate(Position &pos)
+{
+    side us = pos.to_move;
+    if (!pos.in_check(us))
+    {
+        return false;
+    }
+
+    MoveList moves;
+    generate_moves(pos, us, moves);
+    for (int k = 0; k < moves.count; k++)
+    {
+        Undo undo;
+        pos.make_move(moves.moves[k], undo);
+        bool legal = !pos.in_check(us);
+        pos.unmake_move(moves.moves[k], undo);
+        if (legal)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// --- Plays through one puzzle, searching every move of the solving side ---
+// --- On success solve_ms is the summed time at which each correct move became the
+// --- engine's final choice; otherwise found describes what went wrong ---
+static PuzzleOutcome solve_puzzle(Engine &engine, const Puzzle &puzzle, int &solve_ms, long &nodes, string &found)
+{
+    Position pos = position_from_fen(puzzle.fen);
+
+    // --- Time of every iteration and its best move, for the time-to-solution ---
+    vector<pair<int, Move> > iterations;
+    engine.set_search_callback([&iterations](const SearchInfo &info)
+                               { iterations.push_back(make_pair(info.time_ms, info.pv.empty() ? NO_MOVE : info.pv[0])); });
+
+    solve_ms = 0;
+    for (size_t k = 0; k < puzzle.bestMoves.size(); k++)
+    {
+        Move expected = parse_uci_move(pos, puzzle.bestMoves[k]);
+        if (expected == NO_MOVE)
+        {
+            found = "illegal move " + puzzle.bestMoves[k];
+            return PUZZLE_INVALID;
+        }
+
+        // --- Odd moves belong to the solver ---
+        if (k % 2 == 1)
+        {
+            board_state state = {};
+            pos.to_board_state(state);
+            iterations.clear();
+            EngineMove best = pos.to_move == WHITE ? engine.make_white_move(state) : engine.make_black_move(state);
+            nodes += best.nodes;
+
+            bool correct = best.move == expected;
+            if (!correct && k == puzzle.bestMoves.size() - 1 && best.move != NO_MOVE)
+            {
+                Position after = pos;
+                Undo undo;
+                after.make_move(best.move, undo);
+                correct = is_checkmate(after);
+            }
+            if (!correct)
+            {
+                found = "move " + to_string(k + 1) + ": expected " + puzzle.bestMoves[k] + ", engine played " +
+                        (best.move == NO_MOVE ? string("(none)") : move_to_uci(best.move));
+                return PUZZLE_FAILED;
+            }
+
+            // --- The move was found at the start of the last run of iterations choosing it ---
+            int found_ms = iterations.empty() ? 0 : iterations.back().first;
+            for (size_t n = iterations.size(); n > 0 && iterations[n - 1].second == best.move; n--)
+            {
+                found_ms = iterations[n - 1].first;
+            }
+            solve_ms += found_ms;
+        }
+
+        Undo undo;
+        pos.make_move(expected, undo);
+    }
+    return PUZZLE_SOLVED;
+}
+
+// --- Percentile (p from 0 to 100) of the times counted in a histogram; times in the last
+// --- bucket show as SOLVE_HISTOGRAM_MS ---
+static int percentile(const vector<long> &histogram, long count, int p)
+{
+    long rank = min(count - 1, count * p / 100);
+    for (int ms = 0; ms < (int)histogram.size(); ms++)
+    {
+        rank -= histogram[ms];
+        if (rank < 0)
+        {
+            return ms;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <puzzles.csv> [-threads n] [-nodes n] [-time ms] [-hash mb] [-network file] [-v]\n", argv[0]);
+        return 2;
+    }
+
+    int threads = max(1, (int)thread::hardware_concurrency());
+    int hash_mb = VALIDATE_HASH_MB;
+    string network_path;
+    bool verbose = false;
+    SearchLimits limits;
+    limits.time_ms = 0;
+    for (int a = 2; a < argc; a++)
+    {
+        string option = argv[a];
+        if (option == "-v")
+            verbose = true;
+        else if (a + 1 < argc && option == "-threads")
+            threads = max(1, atoi(argv[++a]));
+        else if (a + 1 < argc && option == "-nodes")
+            limits.nodes = atol(argv[++a]);
+        else if (a + 1 < argc && option == "-time")
+            limits.time_ms = atoi(argv[++a]);
+        else if (a + 1 < argc && option == "-hash")
+            hash_mb = max(1, atoi(argv[++a]));
+        else if (a + 1 < argc && option == "-network")
+            network_path = argv[++a];
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", argv[a]);
+            return 2;
+        }
+    }
+    if (limits.nodes <= 0 && limits.time_ms <= 0)
+    {
+        limits.nodes = DEFAULT_NODES;
+    }
+
+    ifstream in(argv[1]);
+    if (!in.is_open())
+    {
+        fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    // --- Engines are built here, one at a time: their constructors fill shared tables ---
+    vector<unique_ptr<Engine> > engines;
+    for (int t = 0; t < threads; t++)
+    {
+        engines.push_back(unique_ptr<Engine>(new Engine(hash_mb, 1, network_path)));
+        if (!network_path.empty() && !engines.back()->has_network())
+        {
+            fprintf(stderr, "Failed to load network %s\n", network_path.c_str());
+            return 1;
+        }
+        engines.back()->set_limits(limits);
+    }
+
+    RowQueue queue;
+    vector<ValidationTotals> totals(threads);
+    atomic<long> done(0);
+    mutex output;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.push_back(thread([&, t]()
+                                 {
+            Engine &engine = *engines[t];
+            ValidationTotals &mine = totals[t];
+            string row;
+            while (queue.pop(row))
+            {
+                Puzzle puzzle;
+                PuzzleOutcome outcome = PUZZLE_INVALID;
+                int solve_ms = 0;
+                string found = "unreadable row";
+                if (parse_puzzle_csv_line(row, puzzle))
+                {
+                    // --- Each puzzle is searched from an empty table, as a fresh game would be ---
+                    engine.clear_hash();
+                    outcome = solve_puzzle(engine, puzzle, solve_ms, mine.nodes, found);
+                }
+
+                mine.puzzles++;
+                if (outcome == PUZZLE_SOLVED)
+                {
+                    mine.solved++;
+                    mine.add_solve(solve_ms);
+                }
+                else if (outcome == PUZZLE_INVALID)
+                {
+                    mine.invalid++;
+                }
+
+                if (verbose && outcome != PUZZLE_SOLVED)
+                {
+                    lock_guard<mutex> guard(output);
+                    printf("%s %s: %s\n", outcome == PUZZLE_FAILED ? "failed " : "invalid", puzzle.id.c_str(), found.c_str());
+                }
+
+                long count = ++done;
+                if (count % PROGRESS_INTERVAL == 0)
+                {
+                    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                    lock_guard<mutex> guard(output);
+                    fprintf(stderr, "%ld puzzles, %.1f puzzles/s\n", count, count / seconds);
+                }
+            } }));
+    }
+
+    // --- Stream the file: skip the header, hand out non-empty rows ---
+    string line;
+    getline(in, line);
+    while (getline(in, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+        {
+            line.erase(line.size() - 1);
+        }
+        if (!line.empty())
+        {
+            queue.push(line);
+        }
+    }
+    queue.close();
+
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    ValidationTotals all;
+    for (int t = 0; t < threads; t++)
+    {
+        all.add(totals[t]);
+    }
+
+    long valid = all.puzzles - all.invalid;
+    printf("puzzles          %ld (%ld invalid)\n", all.puzzles, all.invalid);
+    printf("solved           %ld (%.1f%% of valid puzzles)\n", all.solved, valid > 0 ? 100.0 * all.solved / valid : 0.0);
+    printf("time to solve ms p50 %d  p90 %d  p99 %d  max %d\n", percentile(all.solve_ms, all.solved, 50),
+           percentile(all.solve_ms, all.solved, 90), percentile(all.solve_ms, all.solved, 99), all.max_solve_ms);
+    printf("throughput       %.1f puzzles/s, %.0f nodes/s, %.2f s on %d threads\n", all.puzzles / seconds, all.nodes / seconds,
+           seconds, threads);
+    printf("limits           %ld nodes, %d ms per move\n", limits.nodes, limits.time_ms);
+    return 0;
+}
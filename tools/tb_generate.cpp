@@ -0,0 +1,436 @@
+// --------------------------------------------------------------------------------------
+// tb_generate.cpp
+// --- Builds the endgame table files read by Tablebases (tablebase.h) by retrograde
+// --- analysis. Each endgame is solved in up to two passes over all of its positions:
+// ---   1. Win, draw or loss. Checkmates are losses at distance 0, and a capture or a
+// ---      promotion leads into a smaller endgame whose table is read from disk. From
+// ---      there, results spread backwards one ply at a time through the moves that
+// ---      stay in the endgame, generated in reverse from each newly solved position:
+// ---      a position is won if one move reaches a loss, lost if every move reaches a win.
+// ---   2. With pawns, the same again with pawn moves also ending the count, which
+// ---      turns the distances into DTZ; pawn moves take their result from pass 1.
+// --- Positions never reached by either rule are draws. Endgames are solved smallest
+// --- first, and those with pawns after those without, so every table an endgame leads
+// --- into already exists.
+// --- Usage: tb_generate <directory> [-pieces n] [endgame ...]
+// ---   with no endgames listed, every endgame of up to n pieces (default TB_MAX_PIECES)
+// --------------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "attacks.h"
+#include "zobrist.h"
+#include "movegen.h"
+#include "tablebase.h"
+
+using namespace std;
+
+// --- Solved values of one endgame, indexed as in TablebaseLayout ---
+struct Solution
+{
+    vector<uint8_t> legal;  // --- 1 for the index of a legal position in its stored symmetry ---
+    vector<int8_t> wdl;     // --- TB_WIN or TB_LOSS once solved, TB_DRAW otherwise ---
+    vector<uint8_t> dtz;    // --- Distance of a solved position ---
+};
+
+class Generator
+{
+private:
+    const TablebaseLayout &layout;
+    const Tablebases &smaller; // --- Tables of the endgames this one leads into ---
+    Solution solution;
+    vector<int8_t> first_pass; // --- Results of pass 1, used by pawn moves in pass 2 ---
+    bool zeroing_pass;         // --- Pass 2: pawn moves end the count as well ---
+    vector<vector<uint32_t> > levels; // --- Positions solved at each distance ---
+
+    // --- Builds the position of an index; false unless it is legal and stored under that index ---
+    bool setup(uint64_t index, Position &pos) const
+    {
+        side to_move;
+        int squares[TB_MAX_PIECES];
+        layout.decode(index, to_move, squares);
+        if (layout.index(to_move, squares) != index)
+        {
+            return false;
+        }
+
+        pos.clear();
+        for (int k = 0; k < layout.count; k++)
+        {
+            bool back_rank = rank_of(squares[k]) == 0 || rank_of(squares[k]) == 7;
+            if (pos.piece_on(squares[k]) != EMPTY || (type_of(layout.pieces[k]) == PAWN && back_rank))
+            {
+                return false;
+            }
+            pos.put_piece(layout.pieces[k], squares[k]);
+        }
+        pos.to_move = to_move;
+        return !pos.in_check(opposite(to_move));
+    }
+
+    // --- Moves that end the count: they leave the endgame, or in pass 2 move a pawn ---
+    bool ends_count(const Position &pos, Move m) const
+    {
+        return is_capture(m) || is_promotion(m) || (zeroing_pass && type_of(pos.piece_on(move_from(m))) == PAWN);
+    }
+
+    // --- Result for the side to move after a move m that ended the count ---
+    int ended_result(const Position &child, Move m) const
+    {
+        if (!is_capture(m) && !is_promotion(m))
+        {
+            return first_pass[layout.index(child)];
+        }
+
+        int wdl;
+        if (!smaller.probe_wdl(child, wdl))
+        {
+            fprintf(stderr, "%s needs the tables of the endgames it leads into; generate them first\n", layout.name().c_str());
+            exit(1);
+        }
+        return wdl;
+    }
+
+    void solve(uint64_t index, int wdl, int distance)
+    {
+        if (distance > TB_MAX_DTZ)
+        {
+            fprintf(stderr, "%s: distance over %d plies, cannot be stored\n", layout.name().c_str(), TB_MAX_DTZ);
+            exit(1);
+        }
+        solution.wdl[index] = (int8_t)wdl;
+        solution.dtz[index] = (uint8_t)distance;
+        if ((int)levels.size() <= distance)
+        {
+            levels.resize(distance + 1);
+        }
+        levels[distance].push_back((uint32_t)index);
+    }
+
+    // --- Start of a pass: mates, and positions settled by their count-ending moves alone ---
+    void solve_terminal(uint64_t index, Position &pos)
+    {
+        side us = pos.to_move;
+        MoveList moves;
+        generate_moves(pos, us, moves);
+
+        int legal_moves = 0;
+        bool wins = false, all_lose = true;
+        for (int k = 0; k < moves.count; k++)
+        {
+            Move m = moves.moves[k];
+            bool ends = ends_count(pos, m);
+            Undo undo;
+            pos.make_move(m, undo);
+            if (!pos.in_check(us))
+            {
+                legal_moves++;
+                int child = ends ? ended_result(pos, m) : TB_DRAW;
+                wins = wins || child == TB_LOSS;
+                all_lose = all_lose && ends && child == TB_WIN;
+            }
+            pos.unmake_move(m, undo);
+        }
+
+        if (legal_moves == 0)
+        {
+            if (pos.in_check(us))
+                solve(index, TB_LOSS, 0);
+        }
+        else if (wins)
+            solve(index, TB_WIN, 1);
+        else if (all_lose)
+            solve(index, TB_LOSS, 1);
+    }
+
+    // --- True if every move of the position reaches a win for the opponent, solved at
+    // --- distance at most `distance` when it stays in the endgame ---
+    bool all_moves_lose(Position &pos, int distance) const
+    {
+        side us = pos.to_move;
+        MoveList moves;
+        generate_moves(pos, us, moves);
+
+        bool lost = true;
+        for (int k = 0; k < moves.count && lost; k++)
+        {
+            Move m = moves.moves[k];
+            bool ends = ends_count(pos, m);
+            Undo undo;
+            pos.make_move(m, undo);
+            if (!pos.in_check(us))
+            {
+                if (ends)
+                {
+                    lost = ended_result(pos, m) == TB_WIN;
+                }
+                else
+                {
+                    uint64_t child = layout.index(pos);
+                    lost = solution.wdl[child] == TB_WIN && solution.dtz[child] <= distance;
+                }
+            }
+            pos.unmake_move(m, undo);
+        }
+        return lost;
+    }
+
+    // --- Positions one move before pos, through moves that do not end the count ---
+    void predecessors(const Position &pos, vector<uint64_t> &found) const
+    {
+        found.clear();
+        side mover = opposite(pos.to_move);
+        Bitboard empty = ~pos.occupied;
+        for (int pt = zeroing_pass ? KNIGHT : PAWN; pt <= KING; pt++)
+        {
+            Bitboard pieces = pos.pieces[mover][pt];
+            while (pieces)
+            {
+                int to = pop_lsb(pieces);
+                Bitboard from;
+                if (pt == PAWN)
+                {
+                    // --- Pushed back one square, or two from the fourth (fifth) rank ---
+                    int back = mover == WHITE ? -8 : 8;
+                    int start = mover == WHITE ? 3 : 4;
+                    int first = to + back;
+                    from = 0;
+                    if ((empty & square_bb(first)) && rank_of(first) != 0 && rank_of(first) != 7)
+                    {
+                        from |= square_bb(first);
+                        if (rank_of(to) == start && (empty & square_bb(first + back)))
+                        {
+                            from |= square_bb(first + back);
+                        }
+                    }
+                }
+                else if (pt == KNIGHT)
+                    from = Attacks::knight(to) & empty;
+                else if (pt == BISHOP)
+                    from = Attacks::bishop(to, pos.occupied) & empty;
+                else if (pt == ROOK)
+                    from = Attacks::rook(to, pos.occupied) & empty;
+                else if (pt == QUEEN)
+                    from = Attacks::queen(to, pos.occupied) & empty;
+                else
+                    from = Attacks::king(to) & empty;
+
+                while (from)
+                {
+                    Position before = pos;
+                    before.remove_piece(to);
+                    before.put_piece(make_piece(mover, (piece_type)pt), pop_lsb(from));
+                    before.to_move = mover;
+                    if (!before.in_check(pos.to_move))
+                    {
+                        found.push_back(layout.index(before));
+                    }
+                }
+            }
+        }
+    }
+
+    // --- One pass over the whole endgame ---
+    void run_pass()
+    {
+        uint64_t size = layout.size();
+        solution.wdl.assign(size, TB_DRAW);
+        solution.dtz.assign(size, 0);
+        levels.clear();
+
+        Position pos;
+        for (uint64_t index = 0; index < size; index++)
+        {
+            if (solution.legal[index])
+            {
+                setup(index, pos);
+                solve_terminal(index, pos);
+            }
+        }
+
+        // --- A loss makes every position before it a win one ply further; a win makes a
+        // --- position before it a loss once all of that position's moves reach wins ---
+        vector<uint64_t> before;
+        for (int distance = 0; distance < (int)levels.size(); distance++)
+        {
+            for (size_t k = 0; k < levels[distance].size(); k++)
+            {
+                uint64_t index = levels[distance][k];
+                setup(index, pos);
+                predecessors(pos, before);
+                for (size_t b = 0; b < before.size(); b++)
+                {
+                    uint64_t p = before[b];
+                    if (!solution.legal[p] || solution.wdl[p] != TB_DRAW)
+                    {
+                        continue;
+                    }
+                    if (solution.wdl[index] == TB_LOSS)
+                    {
+                        solve(p, TB_WIN, distance + 1);
+                    }
+                    else
+                    {
+                        Position previous;
+                        setup(p, previous);
+                        if (all_moves_lose(previous, distance))
+                        {
+                            solve(p, TB_LOSS, distance + 1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+public:
+    Generator(const TablebaseLayout &endgame, const Tablebases &tables)
+        : layout(endgame), smaller(tables), zeroing_pass(false)
+    {
+    }
+
+    const Solution &generate()
+    {
+        uint64_t size = layout.size();
+        solution.legal.assign(size, 0);
+        Position pos;
+        for (uint64_t index = 0; index < size; index++)
+        {
+            solution.legal[index] = setup(index, pos);
+        }
+
+        zeroing_pass = false;
+        run_pass();
+        if (!layout.pawns)
+        {
+            // --- Without pawns only captures end the count, so pass 1 already gave DTZ ---
+            return solution;
+        }
+
+        first_pass = solution.wdl;
+        zeroing_pass = true;
+        run_pass();
+        for (uint64_t index = 0; index < size; index++)
+        {
+            if (solution.wdl[index] != first_pass[index])
+            {
+                fprintf(stderr, "%s: passes disagree on position %llu\n", layout.name().c_str(), (unsigned long long)index);
+                exit(1);
+            }
+        }
+        return solution;
+    }
+};
+
+static bool write_table(const string &path, const TablebaseLayout &layout, const Solution &solution)
+{
+    FILE *out = fopen(path.c_str(), "wb");
+    if (!out)
+    {
+        return false;
+    }
+
+    TablebaseHeader header = {};
+    header.magic = TB_MAGIC;
+    header.version = TB_VERSION;
+    header.material = layout.material();
+    header.entries = layout.size();
+
+    vector<uint8_t> values(layout.size());
+    for (size_t k = 0; k < values.size(); k++)
+    {
+        values[k] = encode_tb_value(solution.wdl[k], solution.dtz[k]);
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, out) == 1 && fwrite(values.data(), 1, values.size(), out) == values.size();
+    return fclose(out) == 0 && ok;
+}
+
+// --- Fewer pieces first, then fewer pawns: captures and promotions only lead that way ---
+static bool solved_before(const TablebaseLayout &a, const TablebaseLayout &b)
+{
+    int pawns_a = 0, pawns_b = 0;
+    for (int k = 0; k < a.count; k++)
+        pawns_a += type_of(a.pieces[k]) == PAWN;
+    for (int k = 0; k < b.count; k++)
+        pawns_b += type_of(b.pieces[k]) == PAWN;
+    return a.count != b.count ? a.count < b.count : pawns_a < pawns_b;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <directory> [-pieces n] [endgame ...]\n", argv[0]);
+        return 2;
+    }
+
+    string directory = argv[1];
+    int max_pieces = TB_MAX_PIECES;
+    vector<TablebaseLayout> endgames;
+    for (int a = 2; a < argc; a++)
+    {
+        string option = argv[a];
+        TablebaseLayout layout;
+        if (a + 1 < argc && option == "-pieces")
+            max_pieces = atoi(argv[++a]);
+        else if (layout.parse(option))
+            endgames.push_back(layout);
+        else
+        {
+            fprintf(stderr, "unknown endgame %s\n", argv[a]);
+            return 2;
+        }
+    }
+    if (endgames.empty())
+    {
+        vector<TablebaseLayout> all = list_tablebases();
+        for (size_t k = 0; k < all.size(); k++)
+        {
+            if (all[k].count <= max_pieces)
+                endgames.push_back(all[k]);
+        }
+    }
+    stable_sort(endgames.begin(), endgames.end(), solved_before);
+
+    Attacks::initialize();
+    Zobrist::initialize();
+
+    for (size_t e = 0; e < endgames.size(); e++)
+    {
+        const TablebaseLayout &layout = endgames[e];
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        // --- Tables opened so far stay mapped, so each endgame gets a fresh set ---
+        Tablebases tables;
+        tables.set_path(directory);
+        Generator generator(layout, tables);
+        const Solution &solution = generator.generate();
+
+        string path = directory + "/" + layout.name() + ".tb";
+        if (!write_table(path, layout, solution))
+        {
+            fprintf(stderr, "Failed to write %s\n", path.c_str());
+            return 1;
+        }
+
+        long counts[3] = {0, 0, 0};
+        int longest = 0;
+        for (size_t k = 0; k < solution.legal.size(); k++)
+        {
+            if (solution.legal[k])
+            {
+                counts[solution.wdl[k] + 1]++;
+                longest = max(longest, (int)solution.dtz[k]);
+            }
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("%-8s %10ld won %10ld drawn %10ld lost  longest DTZ %3d  %.1f s\n", layout.name().c_str(), counts[2], counts[1],
+               counts[0], longest, seconds);
+        fflush(stdout);
+    }
+    return 0;
+}
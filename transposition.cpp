@@ -0,0 +1,170 @@
+// --------------------------------------------------------------------------------------
+// transposition.cpp
+// --- Implements the bucketed, lock-free transposition table declared in transposition.h.
+// --- An entry is packed into 64 bits: score (32), move (16), depth (8), bound and age (8).
+// --------------------------------------------------------------------------------------
+
+#include "transposition.h"
+
+// --- A same-key entry searched this much deeper than a new result survives it ---
+const int TT_REPLACE_MARGIN = 3;
+
+// --- Packing of TTEntry fields into a slot's data word ---
+static uint64_t pack(const TTEntry &e)
+{
+    return (uint64_t)(uint32_t)e.score |
+           ((uint64_t)e.move << 32) |
+           ((uint64_t)(uint8_t)e.depth << 48) |
+           ((uint64_t)e.bound_age << 56);
+}
+
+static TTEntry unpack(uint64_t key, uint64_t data)
+{
+    TTEntry e;
+    e.key = key;
+    e.score = (int32_t)(uint32_t)data;
+    e.move = (Move)(data >> 32);
+    e.depth = (int8_t)(uint8_t)(data >> 48);
+    e.bound_age = (uint8_t)(data >> 56);
+    return e;
+}
+
+// --- Allocates a table of (at most) size_mb megabytes ---
+TranspositionTable::TranspositionTable(int size_mb) : bucket_count(0), index_mask(0), generation(0)
+{
+    resize(size_mb);
+}
+
+// --- Reallocates the table to the largest power-of-two bucket count that fits ---
+void TranspositionTable::resize(int size_mb)
+{
+    if (size_mb < 1)
+    {
+        size_mb = 1;
+    }
+
+    size_t bytes = (size_t)size_mb * 1024 * 1024;
+    size_t count = 1;
+    while (count * 2 * sizeof(TTBucket) <= bytes)
+    {
+        count *= 2;
+    }
+
+    buckets.reset(new TTBucket[count]);
+    bucket_count = count;
+    index_mask = count - 1;
+    clear();
+}
+
+// --- Empties every entry (a zero data word decodes to BOUND_NONE) ---
+void TranspositionTable::clear()
+{
+    for (size_t b = 0; b < bucket_count; b++)
+    {
+        for (int i = 0; i < TT_BUCKET_SIZE; i++)
+        {
+            buckets[b].slots[i].key_xor_data.store(0, std::memory_order_relaxed);
+            buckets[b].slots[i].data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+// --- Marks the start of a new search so older entries age out ---
+void TranspositionTable::new_search()
+{
+    generation = (generation + 1) & 63;
+}
+
+// --- Looks a key up; returns true and fills entry on a hit ---
+bool TranspositionTable::probe(uint64_t key, TTEntry &entry) const
+{
+    const TTBucket &bucket = buckets[key & index_mask];
+    for (int i = 0; i < TT_BUCKET_SIZE; i++)
+    {
+        uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+        uint64_t check = bucket.slots[i].key_xor_data.load(std::memory_order_relaxed);
+
+        if ((check ^ data) == key && data != 0)
+        {
+            entry = unpack(key, data);
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- Stores a search result ---
+// --- A slot holding the same key is overwritten by an exact score, by a result at least
+// --- about as deep (see TT_REPLACE_MARGIN), or when the entry is from an older search;
+// --- otherwise the deeper entry is kept and only its move is refreshed. For a new key
+// --- the victim is an empty slot if there is one, else the entry with the lowest depth
+// --- after a penalty of two plies per search generation it has not been touched ---
+void TranspositionTable::store(uint64_t key, int depth, bound_type bound, int score, Move move)
+{
+    TTBucket &bucket = buckets[key & index_mask];
+    TTSlot *victim = &bucket.slots[0];
+    TTEntry old = unpack(0, 0);
+    int victim_worth = 1 << 30;
+
+    for (int i = 0; i < TT_BUCKET_SIZE; i++)
+    {
+        TTSlot &slot = bucket.slots[i];
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        uint64_t slot_key = slot.key_xor_data.load(std::memory_order_relaxed) ^ data;
+        TTEntry e = unpack(slot_key, data);
+
+        if (slot_key == key || e.bound() == BOUND_NONE)
+        {
+            victim = &slot;
+            old = e;
+            break;
+        }
+
+        int relative_age = (generation - e.age()) & 63;
+        int worth = e.depth - 2 * relative_age;
+        if (worth < victim_worth)
+        {
+            victim = &slot;
+            old = e;
+            victim_worth = worth;
+        }
+    }
+
+    bool same_key = old.key == key && old.bound() != BOUND_NONE;
+    if (same_key && bound != BOUND_EXACT && depth + TT_REPLACE_MARGIN < old.depth && old.age() == generation)
+    {
+        // --- Shallow results (e.g. depth 0 after quiescence) must not wipe out a deep one ---
+        if (move != NO_MOVE && move != old.move)
+        {
+            old.move = move;
+            uint64_t data = pack(old);
+            victim->key_xor_data.store(key ^ data, std::memory_order_relaxed);
+            victim->data.store(data, std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    // --- Keep the old best move if this search did not find one ---
+    if (move == NO_MOVE && same_key)
+    {
+        move = old.move;
+    }
+
+    TTEntry e;
+    e.key = key;
+    e.score = score;
+    e.move = move;
+    e.depth = (int8_t)depth;
+    e.bound_age = (uint8_t)(bound | (generation << 2));
+
+    uint64_t data = pack(e);
+    victim->key_xor_data.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+}
+
+// --- Size of the table in megabytes ---
+int TranspositionTable::size_mb() const
+{
+    return (int)((bucket_count * sizeof(TTBucket)) / (1024 * 1024));
+}
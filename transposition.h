@@ -0,0 +1,94 @@
+// --------------------------------------------------------------------------------------
+// transposition.h
+// --- Declares the transposition table used by the search.
+// --- Positions reached through different move orders share a Zobrist key, so the
+// --- result of searching one of them (depth, score, bound type and best move) is
+// --- stored here and reused instead of searching the same subtree again.
+// --- Entries live in buckets of four. When a bucket is full the shallowest entry left
+// --- over from an older search is replaced first.
+// --- A position already in the table keeps a deeper entry from the current search
+// --- unless the new result is exact.
+// --- The table is shared by all search threads without locking (see TTSlot).
+// --------------------------------------------------------------------------------------
+
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include "move.h"
+
+// --- How a stored score relates to the true value of the position ---
+enum bound_type
+{
+    BOUND_NONE,  // --- Empty entry ---
+    BOUND_UPPER, // --- Search failed low: true score <= stored score ---
+    BOUND_LOWER, // --- Search failed high: true score >= stored score ---
+    BOUND_EXACT  // --- Score is exact ---
+};
+
+// --- One stored search result, as returned by probe() ---
+struct TTEntry
+{
+    uint64_t key;      // --- Full Zobrist key of the position ---
+    int32_t score;     // --- Score from White's point of view ---
+    Move move;         // --- Best move found, or NO_MOVE ---
+    int8_t depth;      // --- Remaining depth the score was searched to ---
+    uint8_t bound_age; // --- Bits 0-1: bound_type, bits 2-7: search generation ---
+
+    bound_type bound() const { return (bound_type)(bound_age & 3); }
+    int age() const { return bound_age >> 2; }
+};
+
+// --- Slot as stored in the table: the entry packed into one 64-bit word, plus the key
+// --- XORed with that word. Threads read and write slots without locks; a slot torn by
+// --- two simultaneous writers no longer satisfies key ^ data == stored key and is
+// --- simply treated as a miss ---
+struct TTSlot
+{
+    std::atomic<uint64_t> key_xor_data;
+    std::atomic<uint64_t> data;
+};
+
+const int TT_BUCKET_SIZE = 4;
+
+// --- Four slots, 64 bytes: one cache line ---
+struct TTBucket
+{
+    TTSlot slots[TT_BUCKET_SIZE];
+};
+
+class TranspositionTable
+{
+private:
+    std::unique_ptr<TTBucket[]> buckets; // --- Power-of-two number of buckets ---
+    size_t bucket_count;
+    uint64_t index_mask;                 // --- bucket_count - 1 ---
+    int generation;                      // --- Bumped once per search, wraps at 64 ---
+
+public:
+    // --- Allocates a table of (at most) size_mb megabytes ---
+    explicit TranspositionTable(int size_mb);
+
+    // --- Reallocates the table to a new size, dropping all entries ---
+    void resize(int size_mb);
+
+    // --- Empties every entry ---
+    void clear();
+
+    // --- Marks the start of a new search so older entries age out ---
+    void new_search();
+
+    // --- Looks a key up; returns true and fills entry on a hit (safe to call from any thread) ---
+    bool probe(uint64_t key, TTEntry &entry) const;
+
+    // --- Stores a search result, choosing which slot of the bucket to overwrite (safe to call from any thread) ---
+    void store(uint64_t key, int depth, bound_type bound, int score, Move move);
+
+    // --- Size of the table in megabytes ---
+    int size_mb() const;
+};
+
+#endif
@@ -0,0 +1,72 @@
+// --------------------------------------------------------------------------------------
+// zobrist.cpp
+// --- Generates the Zobrist keys declared in zobrist.h.
+// --- A fixed seed keeps keys (and therefore search results) identical between runs.
+// --------------------------------------------------------------------------------------
+
+#include "zobrist.h"
+
+// --- Key storage ---
+uint64_t Zobrist::PIECES[2][6][64];
+uint64_t Zobrist::CASTLING[16];
+uint64_t Zobrist::EN_PASSANT[8];
+uint64_t Zobrist::BLACK_TO_MOVE;
+
+// --- Set once initialize() has run ---
+static bool keys_ready = false;
+
+// --- splitmix64 step, gives well-distributed keys from a simple counter ---
+static uint64_t next_key(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// --- Fills all keys from a fixed seed ---
+void Zobrist::initialize()
+{
+    if (keys_ready)
+    {
+        return;
+    }
+
+    uint64_t state = 1070372;
+
+    for (int s = 0; s < 2; s++)
+    {
+        for (int pt = 0; pt < 6; pt++)
+        {
+            for (int sq = 0; sq < 64; sq++)
+            {
+                PIECES[s][pt][sq] = next_key(state);
+            }
+        }
+    }
+
+    // --- No rights hashes to zero, each right XORs in its own key ---
+    uint64_t rights[4];
+    for (int r = 0; r < 4; r++)
+    {
+        rights[r] = next_key(state);
+    }
+    for (int c = 0; c < 16; c++)
+    {
+        CASTLING[c] = 0;
+        for (int r = 0; r < 4; r++)
+        {
+            if (c & (1 << r))
+                CASTLING[c] ^= rights[r];
+        }
+    }
+
+    for (int f = 0; f < 8; f++)
+    {
+        EN_PASSANT[f] = next_key(state);
+    }
+
+    BLACK_TO_MOVE = next_key(state);
+
+    keys_ready = true;
+}
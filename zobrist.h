@@ -0,0 +1,27 @@
+// --------------------------------------------------------------------------------------
+// zobrist.h
+// --- Declares the Zobrist keys used to hash a Position into 64 bits.
+// --- A position's key is the XOR of one random number per (side, piece, square), one
+// --- per castling-rights combination, one per en passant file and one for Black to
+// --- move. Position keeps its key up to date as pieces are placed and moves are made.
+// --- Keys are generated once by Zobrist::initialize(), which Engine::Engine() calls.
+// --------------------------------------------------------------------------------------
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+class Zobrist
+{
+public:
+    static uint64_t PIECES[2][6][64]; // --- [side][piece_type][square] ---
+    static uint64_t CASTLING[16];     // --- Indexed by the castling right bits ---
+    static uint64_t EN_PASSANT[8];    // --- Indexed by file of the en passant square ---
+    static uint64_t BLACK_TO_MOVE;
+
+    // --- Fills all keys from a fixed seed; safe to call more than once ---
+    static void initialize();
+};
+
+#endif